@@ -0,0 +1,626 @@
+#include "benchmarks.h"
+
+#ifdef WFEDIT_BENCHMARKS
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lin_alg.h"
+#include "timer.h"
+#include "wavetable.h"
+#include "voices.h"
+#include "ramp.h"
+#include "oversample.h"
+#include "resample.h"
+#include "lodepng.h"
+#include "headless.h"
+
+#define BENCH_SAMPLE_RATE 48000
+#define BENCH_NUM_SAMPLES (BENCH_SAMPLE_RATE * 10)
+#define BENCH_BLOCK 512
+
+// every *.png in here gets decoded, relative to the working directory
+#define BENCH_PNG_CORPUS "png_corpus"
+#define BENCH_PNG_REPEATS 5
+
+static float bench_block[BENCH_BLOCK];
+
+static void bench_wavetable() {
+	static float cycle[WT_TABLE_SIZE];
+	static wavetable_t wt;
+
+	vec4 coefs(13.5, -20.25, 6.75, 0.0);
+	for (int i = 0; i < WT_TABLE_SIZE; ++i) {
+		float x = (float)i / (float)WT_TABLE_SIZE;
+		cycle[i] = 0.6*dot4(coefs, vec4(x*x*x, x*x, x, 1));
+	}
+
+	perf_timer_t T;
+	T.begin();
+	for (int i = 0; i < 100; ++i) {
+		wt.build(cycle);
+	}
+	printf("wavetable_t::build: %.3f ms per rebuild\n", T.get_ms() / 100.0);
+
+	// the old path: evaluate the cubic for every output sample
+	float sink = 0;
+	T.begin();
+	for (int n = 0; n < BENCH_NUM_SAMPLES; n += BENCH_BLOCK) {
+		float x = 0, dx = 220.0 / (float)BENCH_SAMPLE_RATE;
+		for (int i = 0; i < BENCH_BLOCK; ++i) {
+			float x2 = x*x;
+			bench_block[i] = 0.6*dot4(coefs, vec4(x2*x, x2, x, 1));
+			x += dx;
+			x -= floorf(x);
+		}
+		sink += bench_block[BENCH_BLOCK - 1];
+	}
+	double poly_ms = T.get_ms();
+
+	wt_oscillator_t osc;
+	osc.set_frequency(220.0, BENCH_SAMPLE_RATE);
+	T.begin();
+	for (int n = 0; n < BENCH_NUM_SAMPLES; n += BENCH_BLOCK) {
+		memset(bench_block, 0, sizeof(bench_block));
+		osc.render_add(&wt, bench_block, BENCH_BLOCK, 1.0);
+		sink += bench_block[BENCH_BLOCK - 1];
+	}
+	double wt_ms = T.get_ms();
+
+	printf("10 s of audio @ %d Hz: polynomial %.3f ms, wavetable %.3f ms (%.1fx) [%f]\n",
+		BENCH_SAMPLE_RATE, poly_ms, wt_ms, poly_ms / wt_ms, sink);
+}
+
+static void bench_voices() {
+	static float cycle[WT_TABLE_SIZE];
+	static wavetable_t wt;
+	static voice_pool_t pool;
+	static float out_l[BENCH_BLOCK], out_r[BENCH_BLOCK], xfade[BENCH_BLOCK];
+	static wavetable_t wt_prev;
+
+	for (int i = 0; i < WT_TABLE_SIZE; ++i) {
+		cycle[i] = 2.0 * (float)i / (float)WT_TABLE_SIZE - 1.0;	// saw, worst case for the harmonic count
+	}
+	wt.build(cycle);
+	wt_prev.build(cycle);
+
+	pool.init(BENCH_SAMPLE_RATE);
+	for (int v = 0; v < MAX_VOICES; ++v) {
+		pool.note_on(36 + v, 0.5);
+	}
+
+	const int num_periods = 2000;
+	float sink = 0;
+
+	perf_timer_t T;
+	T.begin();
+	for (int p = 0; p < num_periods; ++p) {
+		pool.render(&wt, NULL, NULL, out_l, out_r, BENCH_BLOCK);
+		sink += out_l[0] + out_r[BENCH_BLOCK - 1];
+	}
+	double us_per_period = T.get_us() / (double)num_periods;
+	double us_per_voice = us_per_period / (double)MAX_VOICES;
+	double period_us = 1000000.0 * (double)BENCH_BLOCK / (double)BENCH_SAMPLE_RATE;
+
+	printf("voice_pool_t::render (%s): %d voices x %d frames = %.2f us, %.3f us per voice\n",
+		voice_mixer_name(), MAX_VOICES, BENCH_BLOCK, us_per_period, us_per_voice);
+	printf("  => ~%d voices fit in one %d-frame period (%.2f ms) on one core [%f]\n",
+		(int)(period_us / us_per_voice), BENCH_BLOCK, period_us / 1000.0, sink);
+
+	// the same with a new table arriving every period, i.e. the curve being edited continuously
+	ramp_t ramp;
+	T.begin();
+	for (int p = 0; p < num_periods; ++p) {
+		ramp.reset(0.0);
+		ramp.set_target(1.0, BENCH_BLOCK);
+		ramp.fill(xfade, BENCH_BLOCK);
+		pool.render(&wt, &wt_prev, xfade, out_l, out_r, BENCH_BLOCK);
+		sink += out_l[0] + out_r[BENCH_BLOCK - 1];
+	}
+	double us_per_period_xfade = T.get_us() / (double)num_periods;
+	printf("  with a wavetable crossfade every period: %.2f us per period (+%.0f%%) [%f]\n",
+		us_per_period_xfade, 100.0 * (us_per_period_xfade / us_per_period - 1.0), sink);
+}
+
+static void bench_oversampling() {
+	static float cycle[WT_TABLE_SIZE];
+	static wavetable_t wt;
+	static voice_pool_t pool;
+	static float os_l[BENCH_BLOCK * OVERSAMPLE_MAX_FACTOR], os_r[BENCH_BLOCK * OVERSAMPLE_MAX_FACTOR];
+	static float out_l[BENCH_BLOCK], out_r[BENCH_BLOCK];
+	static const char *quality_names[] = { "low", "medium", "high" };
+
+	for (int i = 0; i < WT_TABLE_SIZE; ++i) {
+		cycle[i] = 2.0 * (float)i / (float)WT_TABLE_SIZE - 1.0;
+	}
+	wt.build(cycle);
+
+	decimator_t dec_l, dec_r;
+	dec_l.allocate(BENCH_BLOCK);
+	dec_r.allocate(BENCH_BLOCK);
+
+	const int num_voices = 16;
+	const int num_periods = 1000;
+	float sink = 0;
+
+	printf("oversampled synthesis, %d voices, %d-frame periods:\n", num_voices, BENCH_BLOCK);
+
+	for (int factor = 1; factor <= OVERSAMPLE_MAX_FACTOR; factor *= 2) {
+		for (int q = OVERSAMPLE_QUALITY_LOW; q <= OVERSAMPLE_QUALITY_HIGH; ++q) {
+			if (factor == 1 && q != OVERSAMPLE_QUALITY_LOW) continue;	// no filter to speak of
+
+			pool.init((float)(BENCH_SAMPLE_RATE * factor));
+			for (int v = 0; v < num_voices; ++v) {
+				pool.note_on(48 + v, 0.5);
+			}
+			dec_l.setup(factor, q);
+			dec_r.setup(factor, q);
+
+			double synth_us = 0, decim_us = 0;
+			perf_timer_t T;
+			for (int p = 0; p < num_periods; ++p) {
+				T.begin();
+				pool.render(&wt, NULL, NULL, os_l, os_r, BENCH_BLOCK * factor);
+				synth_us += T.get_us();
+
+				T.begin();
+				dec_l.process(os_l, BENCH_BLOCK, out_l);
+				dec_r.process(os_r, BENCH_BLOCK, out_r);
+				decim_us += T.get_us();
+
+				sink += out_l[0] + out_r[BENCH_BLOCK - 1];
+			}
+
+			printf("  %dx %-6s: synth %7.2f us, decimation %6.2f us per period\n",
+				factor, factor == 1 ? "" : quality_names[q], synth_us / num_periods, decim_us / num_periods);
+		}
+	}
+	printf("  [%f]\n", sink);
+
+	dec_l.cleanup();
+	dec_r.cleanup();
+}
+
+static void bench_resampler() {
+	static const int device_rates[] = { 44100, 88200, 96000, 192000 };
+	static float out_l[BENCH_BLOCK], out_r[BENCH_BLOCK];
+	float *out[2] = { out_l, out_r };
+
+	const int num_periods = 2000;
+	float sink = 0;
+
+	printf("resampling from %d Hz, stereo, %d-frame device periods:\n", BENCH_SAMPLE_RATE, BENCH_BLOCK);
+
+	for (size_t r = 0; r < sizeof(device_rates) / sizeof(device_rates[0]); ++r) {
+		resampler_t rs;
+		rs.init(BENCH_SAMPLE_RATE, device_rates[r], 2, BENCH_BLOCK);
+
+		int phase = 0;
+		perf_timer_t T;
+		T.begin();
+		for (int p = 0; p < num_periods; ++p) {
+			int n_in = rs.input_needed(BENCH_BLOCK);
+			float *in_l = rs.input_ptr(0), *in_r = rs.input_ptr(1);
+			for (int i = 0; i < n_in; ++i, ++phase) {
+				in_l[i] = in_r[i] = (float)((phase & 127) - 64) / 64.0f;
+			}
+			rs.commit(n_in);
+			rs.process(out, BENCH_BLOCK);
+			sink += out_l[0] + out_r[BENCH_BLOCK - 1];
+		}
+		double us = T.get_us();
+
+		printf("  -> %6d Hz: %6.2f us per period, %.1f Mframes/s\n",
+			device_rates[r], us / num_periods, (double)num_periods * BENCH_BLOCK / us);
+
+		rs.cleanup();
+	}
+	printf("  [%f]\n", sink);
+}
+
+struct bench_png_t {
+	std::vector<unsigned char> file;
+	std::vector<unsigned char> idat;	// the zlib stream, all IDAT chunks concatenated
+};
+
+// every png in BENCH_PNG_CORPUS, false if there are none
+static bool load_png_corpus(std::vector<bench_png_t> &corpus) {
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA(BENCH_PNG_CORPUS "/*.png", &fd);
+	if (h == INVALID_HANDLE_VALUE) {
+		printf("  no files in %s\n", BENCH_PNG_CORPUS);
+		return false;
+	}
+	do {
+		bench_png_t png;
+		if (lodepng::load_file(png.file, std::string(BENCH_PNG_CORPUS "/") + fd.cFileName) || png.file.size() < 8) continue;
+
+		const unsigned char *end = &png.file[0] + png.file.size();
+		for (const unsigned char *chunk = &png.file[8]; chunk + 12 <= end; chunk = lodepng_chunk_next_const(chunk)) {
+			if (chunk + 12 + lodepng_chunk_length(chunk) > end) break;
+			if (lodepng_chunk_type_equals(chunk, "IDAT")) {
+				const unsigned char *data = lodepng_chunk_data_const(chunk);
+				png.idat.insert(png.idat.end(), data, data + lodepng_chunk_length(chunk));
+			}
+			if (lodepng_chunk_type_equals(chunk, "IEND")) break;
+		}
+		corpus.push_back(png);
+	} while (FindNextFileA(h, &fd));
+	FindClose(h);
+
+	if (corpus.empty()) {
+		printf("  couldn't read anything from %s\n", BENCH_PNG_CORPUS);
+		return false;
+	}
+	return true;
+}
+
+static void bench_png_decode() {
+	std::vector<bench_png_t> corpus;
+
+	printf("png decode:\n");
+	if (!load_png_corpus(corpus)) return;
+
+	size_t file_bytes = 0, pixel_bytes = 0, inflated_bytes = 0;
+	unsigned errors = 0;
+
+	perf_timer_t T;
+	double decode_us = 0, inflate_us = 0;
+	for (int r = 0; r < BENCH_PNG_REPEATS; ++r) {
+		for (size_t i = 0; i < corpus.size(); ++i) {
+			std::vector<unsigned char> pixels;
+			unsigned w, h;
+			T.begin();
+			errors += lodepng::decode(pixels, w, h, corpus[i].file) != 0;
+			decode_us += T.get_us();
+			file_bytes += corpus[i].file.size();
+			pixel_bytes += pixels.size();
+
+			// the zlib part on its own, that's where the huffman decoding happens
+			std::vector<unsigned char> inflated;
+			T.begin();
+			lodepng::decompress(inflated, corpus[i].idat);
+			inflate_us += T.get_us();
+			inflated_bytes += inflated.size();
+		}
+	}
+
+	printf("  %d files from %s (%d errors)\n", (int)corpus.size(), BENCH_PNG_CORPUS, errors / BENCH_PNG_REPEATS);
+	printf("  full decode: %.1f MB/s of pixels, %.1f MB/s of file\n", pixel_bytes / decode_us, file_bytes / decode_us);
+	printf("  inflate:     %.1f MB/s of output\n", inflated_bytes / inflate_us);
+}
+
+struct bench_stream_rows_t {
+	std::vector<unsigned char> *pixels;
+	size_t stride;
+};
+
+static unsigned bench_stream_row(void *user, const unsigned char *row, unsigned y, unsigned w, unsigned h) {
+	bench_stream_rows_t *rows = (bench_stream_rows_t*)user;
+	if (rows->pixels->empty()) rows->pixels->resize(rows->stride * h);
+	memcpy(&(*rows->pixels)[y * rows->stride], row, rows->stride);
+	return 0;
+}
+
+static void bench_png_stream() {
+	const size_t piece = 65536;	// what decode_streaming reads from the file at a time
+	std::vector<bench_png_t> corpus;
+
+	printf("png streaming decode:\n");
+	if (!load_png_corpus(corpus)) return;
+
+	size_t pixel_bytes = 0, largest = 0, largest_size = 0;
+	unsigned errors = 0;
+	perf_timer_t T;
+	double whole_us = 0, stream_us = 0;
+	for (int r = 0; r < BENCH_PNG_REPEATS; ++r) {
+		for (size_t i = 0; i < corpus.size(); ++i) {
+			const std::vector<unsigned char> &file = corpus[i].file;
+			std::vector<unsigned char> pixels;
+			unsigned w, h;
+			T.begin();
+			errors += lodepng::decode(pixels, w, h, file) != 0;
+			whole_us += T.get_us();
+			pixel_bytes += pixels.size();
+			if (pixels.size() > largest_size) {
+				largest = i;
+				largest_size = pixels.size();
+			}
+
+			std::vector<unsigned char> streamed;
+			bench_stream_rows_t rows = { &streamed, (size_t)w * 4 };
+			T.begin();
+			lodepng::State state;
+			LodePNGStreamDecoder *decoder = lodepng_stream_new(&state, bench_stream_row, &rows, 1);
+			unsigned error = 0;
+			for (size_t pos = 0; pos < file.size() && !error; pos += piece) {
+				error = lodepng_stream_feed(decoder, &file[pos], file.size() - pos < piece ? file.size() - pos : piece);
+			}
+			if (!error) error = lodepng_stream_finish(decoder);
+			lodepng_stream_delete(decoder);
+			stream_us += T.get_us();
+			errors += error != 0;
+		}
+	}
+
+	printf("  %d files from %s (%d errors)\n", (int)corpus.size(), BENCH_PNG_CORPUS, errors / BENCH_PNG_REPEATS);
+	printf("  whole file: %.1f MB/s of pixels\n", pixel_bytes / whole_us);
+	printf("  streamed:   %.1f MB/s of pixels, bottom-up\n", pixel_bytes / stream_us);
+
+	// the buffers besides the output image each way needs, for the biggest image
+	unsigned w, h;
+	lodepng::State state;
+	const std::vector<unsigned char> &file = corpus[largest].file;
+	if (lodepng_inspect(&w, &h, &state, &file[0], file.size()) == 0) {
+		size_t scanline = 1 + lodepng_get_raw_size(w, 1, &state.info_png.color);
+		size_t whole = file.size() + corpus[largest].idat.size() + scanline * h;
+		size_t streamed = piece + 2 * scanline + 4 * w + 32768 + 65536;
+		printf("  %ux%u: %.0f KB of buffers whole, %.0f KB streamed\n", w, h, whole / 1024.0, streamed / 1024.0);
+	}
+}
+
+static void bench_png_unfilter() {
+	// one image per filter type and pixel size, every scanline using that filter. stored without compression
+	// so inflate is just a copy, and what's left besides unfiltering is the same for every filter type
+	const unsigned w = 1024, h = 1024;
+	static const char *filter_names[] = { "none", "sub", "up", "average", "paeth" };
+	static const LodePNGColorType color_types[] = { LCT_RGB, LCT_RGBA };
+
+	printf("png unfiltering, %ux%u:\n", w, h);
+
+	for (int ct = 0; ct < 2; ++ct) {
+		unsigned bpp = color_types[ct] == LCT_RGB ? 3 : 4;
+		std::vector<unsigned char> pixels(w * h * bpp);
+		unsigned seed = 1;
+		for (size_t i = 0; i < pixels.size(); ++i) {
+			seed = seed * 1103515245 + 12345;
+			pixels[i] = (unsigned char)(i / bpp + (seed >> 24) / 16);	// a gradient with some noise
+		}
+
+		for (int f = 0; f < 5; ++f) {
+			std::vector<unsigned char> filters(h, (unsigned char)f);
+			lodepng::State state;
+			state.info_raw.colortype = color_types[ct];
+			state.info_png.color.colortype = color_types[ct];
+			state.encoder.auto_convert = 0;
+			state.encoder.filter_strategy = LFS_PREDEFINED;
+			state.encoder.predefined_filters = &filters[0];
+			state.encoder.zlibsettings.btype = 0;
+
+			std::vector<unsigned char> png;
+			if (lodepng::encode(png, pixels, w, h, state)) {
+				printf("  encoding failed\n");
+				return;
+			}
+
+			// no checksums and no color conversion either, that leaves little more than memcpys around the unfiltering
+			lodepng::State dec_state;
+			dec_state.decoder.ignore_crc = 1;
+			dec_state.decoder.zlibsettings.ignore_adler32 = 1;
+			dec_state.info_raw.colortype = color_types[ct];
+
+			// best of a few runs, the differences between filter types are small next to the noise otherwise
+			std::vector<unsigned char> decoded;
+			unsigned dw, dh;
+			perf_timer_t T;
+			double us = 1e30;
+			for (int r = 0; r < 20; ++r) {
+				decoded.clear();
+				T.begin();
+				lodepng::decode(decoded, dw, dh, dec_state, png);
+				double t = T.get_us();
+				if (t < us) us = t;
+			}
+			bool ok = decoded == pixels;
+
+			printf("  %s %-8s: %7.1f MB/s%s\n", bpp == 3 ? "RGB " : "RGBA", filter_names[f],
+				(double)pixels.size() / us, ok ? "" : " MISMATCH");
+		}
+	}
+}
+
+static void bench_checksums() {
+	const size_t size = 1 << 24;
+	std::vector<unsigned char> data(size);
+	unsigned seed = 1;
+	for (size_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (unsigned char)(seed >> 24);
+	}
+
+	printf("checksums:\n");
+
+	perf_timer_t T;
+	unsigned crc = lodepng_crc32(&data[0], size);
+	double us = T.get_us();
+	printf("  crc32: %.1f MB/s [%08x]\n", size / us, crc);
+
+	// adler32 isn't exposed by lodepng, it shows up as the difference between checking and ignoring checksums.
+	// same for the chunk CRCs, which is what this is about: how much of decoding is still spent on checksums
+	std::vector<bench_png_t> corpus;
+	if (!load_png_corpus(corpus)) return;
+
+	lodepng::State checked, unchecked;
+	unchecked.decoder.ignore_crc = 1;
+	unchecked.decoder.zlibsettings.ignore_adler32 = 1;
+
+	double checked_us = 0, unchecked_us = 0;
+	for (int r = 0; r < BENCH_PNG_REPEATS; ++r) {
+		for (size_t i = 0; i < corpus.size(); ++i) {
+			std::vector<unsigned char> pixels;
+			unsigned w, h;
+			T.begin();
+			lodepng::decode(pixels, w, h, checked, corpus[i].file);
+			checked_us += T.get_us();
+
+			pixels.clear();
+			T.begin();
+			lodepng::decode(pixels, w, h, unchecked, corpus[i].file);
+			unchecked_us += T.get_us();
+		}
+	}
+	printf("  decoding %s: %.0f us with checksums, %.0f us without (%.1f%%)\n", BENCH_PNG_CORPUS,
+		checked_us / BENCH_PNG_REPEATS, unchecked_us / BENCH_PNG_REPEATS, 100.0 * (checked_us - unchecked_us) / checked_us);
+}
+
+// something like a screenshot of the editor: a dark background, grid lines and a few antialiased waveforms
+static void make_screenshot(std::vector<unsigned char> &pixels, unsigned w, unsigned h) {
+	pixels.resize(w * h * 4);
+	for (unsigned y = 0; y < h; ++y) {
+		for (unsigned x = 0; x < w; ++x) {
+			unsigned char *p = &pixels[(y * w + x) * 4];
+			float v = (x % 64 == 0 || y % 64 == 0) ? 48.0f : 16.0f;
+			for (int k = 0; k < 3; ++k) {
+				float center = h * (0.5f + 0.3f * sinf(x * (0.003f + 0.002f * k) + k));
+				float d = fabsf((float)y - center);
+				if (d < 2.0f) v += (2.0f - d) * 100.0f;
+			}
+			if (v > 255.0f) v = 255.0f;
+			p[0] = (unsigned char)v;
+			p[1] = (unsigned char)(v * 0.8f);
+			p[2] = (unsigned char)(v * 0.5f);
+			p[3] = 255;
+		}
+	}
+}
+
+static void bench_png_encode() {
+	const unsigned w = 2048, h = 1024;
+	std::vector<unsigned char> pixels;
+	make_screenshot(pixels, w, h);
+
+	static const unsigned thread_counts[] = { 1, 2, 4, 0 };
+
+	printf("png encode, %ux%u RGBA:\n", w, h);
+
+	for (int i = 0; i < 4; ++i) {
+		lodepng::State state;
+		state.encoder.zlibsettings.num_threads = thread_counts[i];
+
+		std::vector<unsigned char> png;
+		perf_timer_t T;
+		unsigned error = lodepng::encode(png, pixels, w, h, state);
+		double us = T.get_us();
+		if (error) {
+			printf("  encoding failed: %s\n", lodepng_error_text(error));
+			return;
+		}
+
+		std::vector<unsigned char> decoded;
+		unsigned dw, dh;
+		bool ok = !lodepng::decode(decoded, dw, dh, png) && decoded == pixels;
+
+		if (thread_counts[i]) printf("  %u threads:  ", thread_counts[i]);
+		else printf("  all cores:  ");
+		printf("%7.1f MB/s, %d bytes%s\n", (double)pixels.size() / us, (int)png.size(), ok ? "" : " MISMATCH");
+	}
+}
+
+// deflate only, on the filtered scanlines the png encoder would hand it
+static void bench_png_levels() {
+	std::vector<std::vector<unsigned char> > inputs;
+	std::vector<unsigned char> screenshot, png, filtered;
+	make_screenshot(screenshot, 2048, 1024);
+	if (!lodepng::encode(png, screenshot, 2048, 1024)) {
+		std::vector<unsigned char> idat;
+		const unsigned char *end = &png[0] + png.size();
+		for (const unsigned char *chunk = &png[8]; chunk + 12 <= end; chunk = lodepng_chunk_next_const(chunk)) {
+			if (lodepng_chunk_type_equals(chunk, "IDAT")) {
+				idat.insert(idat.end(), lodepng_chunk_data_const(chunk), lodepng_chunk_data_const(chunk) + lodepng_chunk_length(chunk));
+			}
+		}
+		if (!lodepng::decompress(filtered, idat)) inputs.push_back(filtered);
+	}
+
+	// the corpus is optional here, the screenshot alone already shows the curve
+	printf("png compression levels:\n");
+	std::vector<bench_png_t> corpus;
+	load_png_corpus(corpus);
+	for (size_t i = 0; i < corpus.size(); ++i) {
+		filtered.clear();
+		if (!lodepng::decompress(filtered, corpus[i].idat)) inputs.push_back(filtered);
+	}
+
+	size_t input_bytes = 0;
+	for (size_t i = 0; i < inputs.size(); ++i) input_bytes += inputs[i].size();
+	printf("  screenshot and %d files from %s, %.1f MB filtered\n", (int)corpus.size(), BENCH_PNG_CORPUS, input_bytes / 1e6);
+
+	for (unsigned level = 1; level <= 9; ++level) {
+		LodePNGCompressSettings settings;
+		lodepng_compress_settings_init(&settings);
+		lodepng_compress_settings_level(&settings, level);
+
+		size_t output_bytes = 0;
+		perf_timer_t T;
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			std::vector<unsigned char> out;
+			lodepng::compress(out, inputs[i], settings);
+			output_bytes += out.size();
+		}
+		double us = T.get_us();
+
+		printf("  level %u: %7.1f MB/s, %6.3f%% of the input\n", level, input_bytes / us, 100.0 * output_bytes / input_bytes);
+	}
+}
+
+// the editor's passes in a hidden context, same numbers as wfedit_headless gives elsewhere
+static void bench_render_headless() {
+	printf("headless rendering:\n");
+	headless_options_t opt;
+	headless_default_options(&opt);
+	opt.out_png = "headless.png";
+	if (headless_run(&opt)) {
+		printf("  failed\n");
+	}
+	printf("\n");
+}
+
+// the instanced quad markers, 100k of them on top of the editor frame
+static void bench_render_markers() {
+	printf("headless rendering, 100k markers:\n");
+	headless_options_t opt;
+	headless_default_options(&opt);
+	opt.frames = 100;
+	opt.markers = 100000;
+	if (headless_run(&opt)) {
+		printf("  failed\n");
+	}
+	printf("\n");
+}
+
+// all the way out, every tile from the column reduction. the curve animates, so that's every visible tile
+// reduced and drawn each frame, and the reduction is checked against the CPU reference at the end
+static void bench_render_zoomed_out() {
+	printf("headless rendering, zoomed all the way out:\n");
+	headless_options_t opt;
+	headless_default_options(&opt);
+	opt.frames = 100;
+	opt.zoom = -9;
+	if (headless_run(&opt)) {
+		printf("  failed\n");
+	}
+	printf("\n");
+}
+
+void run_benchmarks() {
+	printf("=== wfedit benchmarks ===\n\n");
+	bench_wavetable();
+	bench_voices();
+	bench_oversampling();
+	bench_resampler();
+	bench_png_decode();
+	bench_png_stream();
+	bench_png_unfilter();
+	bench_checksums();
+	bench_png_encode();
+	bench_png_levels();
+	bench_render_headless();
+	bench_render_markers();
+	bench_render_zoomed_out();
+	printf("\n=== done ===\n");
+}
+
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+
+// uncomment to run the benchmarks on startup (results go to the debug console) instead of the editor
+//#define WFEDIT_BENCHMARKS
+
+#ifdef WFEDIT_BENCHMARKS
+void run_benchmarks();
+#endif
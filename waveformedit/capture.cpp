@@ -0,0 +1,280 @@
+#include "capture.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "glext_loader.h"
+#include "glstate.h"
+#include "stats.h"
+#include "timer.h"
+#include "lodepng.h"
+
+struct capture_slot_t {
+	GLuint pbo;
+	GLsync fence;	// NULL if nothing is in flight in this one
+	int frame;
+	int width, height;
+};
+
+// a frame on its way to the disk, rows bottom-up like glReadPixels leaves them
+struct capture_job_t {
+	std::vector<unsigned char> pixels;
+	int frame;
+	int width, height;
+};
+
+static capture_slot_t ring[CAPTURE_RING_SIZE];
+static int ring_next = 0;	// where the next frame goes, the oldest one in flight
+static size_t ring_bytes = 0;
+
+static bool active = false;
+static std::string capture_dir;
+static int next_frame = 0;
+
+static std::vector<std::thread> workers;
+static std::mutex queue_mutex;
+static std::condition_variable work_available, work_done;
+static std::deque<capture_job_t*> work_queue;
+static int num_queued = 0;	// in the queue or being written
+static int num_written = 0, num_failed = 0;
+static bool stopping = false;
+
+static void write_png(capture_job_t *job) {
+	// png wants the rows top-down
+	size_t stride = (size_t)job->width * 4;
+	std::vector<unsigned char> row(stride);
+	for (int y = 0; y < job->height / 2; ++y) {
+		unsigned char *a = &job->pixels[y * stride];
+		unsigned char *b = &job->pixels[(job->height - 1 - y) * stride];
+		memcpy(row.data(), a, stride);
+		memcpy(a, b, stride);
+		memcpy(b, row.data(), stride);
+	}
+
+	// one deflate thread per frame, the pool already has a frame per core
+	LodePNGState state;
+	lodepng_state_init(&state);
+	lodepng_compress_settings_level(&state.encoder.zlibsettings, CAPTURE_PNG_LEVEL);
+	state.encoder.zlibsettings.num_threads = 1;
+
+	char filename[512];
+	snprintf(filename, sizeof(filename), "%s/frame_%06d.png", capture_dir.c_str(), job->frame);
+	unsigned char *png = NULL;
+	size_t png_size = 0;
+	unsigned e = lodepng_encode(&png, &png_size, job->pixels.data(), job->width, job->height, &state);
+	if (!e) e = lodepng_save_file(png, png_size, filename);
+	free(png);
+	lodepng_state_cleanup(&state);
+
+	std::lock_guard<std::mutex> lock(queue_mutex);
+	if (e) {
+		printf("capture: writing %s: %s\n", filename, lodepng_error_text(e));
+		++num_failed;
+	}
+	else {
+		++num_written;
+	}
+}
+
+static void worker_proc() {
+	for (;;) {
+		capture_job_t *job;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			work_available.wait(lock, [] { return stopping || !work_queue.empty(); });
+			if (work_queue.empty()) {
+				return;	// stopping, and everything's written
+			}
+			job = work_queue.front();
+			work_queue.pop_front();
+		}
+
+		write_png(job);
+		delete job;
+
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			--num_queued;
+		}
+		work_done.notify_all();
+	}
+}
+
+static void submit(capture_job_t *job) {
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	if (num_queued >= CAPTURE_MAX_QUEUED) {
+		stats_add("capture stalls", 1);
+		work_done.wait(lock, [] { return num_queued < CAPTURE_MAX_QUEUED; });
+	}
+	work_queue.push_back(job);
+	++num_queued;
+	lock.unlock();
+	work_available.notify_one();
+}
+
+// copies a slot's pixels out once the GL is done with them. without wait that's only if the fence has
+// already signaled, returns whether the slot is free now
+static bool read_back(capture_slot_t *s, bool wait) {
+	if (!s->fence) {
+		return true;
+	}
+	GLenum result = glClientWaitSync(s->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+	while (wait && result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(s->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	}
+	if (result == GL_TIMEOUT_EXPIRED) {
+		return false;
+	}
+	glDeleteSync(s->fence);
+	s->fence = NULL;
+
+	size_t size = (size_t)s->width * s->height * 4;
+	capture_job_t *job = new capture_job_t;
+	job->pixels.resize(size);
+	job->frame = s->frame;
+	job->width = s->width;
+	job->height = s->height;
+
+	gls_bind_buffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+	void *p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (p) {
+		memcpy(job->pixels.data(), p, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	gls_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (!p) {
+		printf("capture: mapping frame %d failed, skipped.\n", job->frame);
+		delete job;
+		return true;
+	}
+	submit(job);
+	return true;
+}
+
+// every frame in flight, oldest first
+static void drain_ring() {
+	for (int k = 0; k < CAPTURE_RING_SIZE; ++k) {
+		read_back(&ring[(ring_next + k) % CAPTURE_RING_SIZE], true);
+	}
+}
+
+static void free_ring() {
+	for (int i = 0; i < CAPTURE_RING_SIZE; ++i) {
+		if (ring[i].pbo) {
+			glDeleteBuffers(1, &ring[i].pbo);
+			ring[i].pbo = 0;
+		}
+	}
+	ring_bytes = 0;
+}
+
+int capture_start(const char *directory, int num_threads) {
+	if (active) {
+		return 0;
+	}
+#ifdef _WIN32
+	CreateDirectoryA(directory, NULL);
+#else
+	mkdir(directory, 0755);
+#endif
+	capture_dir = directory;
+	next_frame = 0;
+	ring_next = 0;
+	num_written = num_failed = 0;
+
+	if (num_threads <= 0) {
+		num_threads = (int)std::thread::hardware_concurrency() - 1;
+		if (num_threads < 1) num_threads = 1;
+	}
+	stopping = false;
+	for (int i = 0; i < num_threads; ++i) {
+		workers.push_back(std::thread(worker_proc));
+	}
+
+	active = true;
+	printf("capture: started, frames go to %s\n", directory);
+	return 1;
+}
+
+void capture_stop() {
+	if (!active) {
+		return;
+	}
+	drain_ring();
+	free_ring();
+
+	// the workers finish the queue before they leave
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (auto &t : workers) {
+		t.join();
+	}
+	workers.clear();
+
+	active = false;
+	printf("capture: stopped, %d frames written to %s", num_written, capture_dir.c_str());
+	if (num_failed) printf(", %d failed", num_failed);
+	printf("\n");
+}
+
+int capture_active() {
+	return active;
+}
+
+void capture_frame(int width, int height) {
+	if (!active || width <= 0 || height <= 0) {
+		return;
+	}
+	perf_timer_t T;
+
+	size_t size = (size_t)width * height * 4;
+	if (size != ring_bytes) {
+		drain_ring();
+		free_ring();
+		for (int i = 0; i < CAPTURE_RING_SIZE; ++i) {
+			glGenBuffers(1, &ring[i].pbo);
+			gls_bind_buffer(GL_PIXEL_PACK_BUFFER, ring[i].pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		}
+		ring_bytes = size;
+	}
+
+	// whatever has come back since the last frame
+	for (int k = 0; k < CAPTURE_RING_SIZE; ++k) {
+		if (!read_back(&ring[(ring_next + k) % CAPTURE_RING_SIZE], false)) {
+			break;
+		}
+	}
+
+	// the GPU is a whole ring behind, this one waits
+	capture_slot_t *s = &ring[ring_next];
+	if (s->fence) {
+		stats_add("capture stalls", 1);
+		read_back(s, true);
+	}
+
+	gls_bind_buffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	gls_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+	s->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s->frame = next_frame++;
+	s->width = width;
+	s->height = height;
+	ring_next = (ring_next + 1) % CAPTURE_RING_SIZE;
+
+	stats_add("capture cpu ms", T.get_ms());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// the view as a png sequence. capture_frame has the GL read the finished frame into the next of a ring of
+// pixel pack buffers and puts a fence after it. a buffer is only mapped once its fence has signaled, a couple
+// of frames later, so the render thread never waits for a readback. the pixels are copied out and encoded on
+// a pool of worker threads. nothing is dropped: a full ring or encode queue waits instead, and those waits
+// show up in the stats as "capture stalls". GL thread only
+
+#define CAPTURE_RING_SIZE 3
+
+// lodepng's zlib-like level, a long capture is a lot of big frames so this goes for speed
+#define CAPTURE_PNG_LEVEL 1
+
+// frames read back but not written yet, each one holds a copy of the pixels
+#define CAPTURE_MAX_QUEUED 16
+
+// frames go to directory/frame_NNNNNN.png, the directory is created if needed. num_threads 0 means one less
+// than the hardware threads, at least one. returns 0 if a capture is already running
+int capture_start(const char *directory, int num_threads);
+// reads back and writes everything still in flight, then stops the workers
+void capture_stop();
+int capture_active();
+
+// after the frame is rendered, before the swap. reads the current read buffer
+void capture_frame(int width, int height);
@@ -1,9 +1,9 @@
-#include <Windows.h>
-#include <gl/gl.h>
-#include <wingdi.h>
 #include <cassert>
+#include <cstring>
 
 #include "glext_loader.h"
+#include "platform.h"
+#include "glstate.h"
 
 PFNGLGETSHADERIVPROC glGetShaderiv;
 PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
@@ -17,6 +17,8 @@ PFNGLCREATEPROGRAMPROC glCreateProgram;
 PFNGLBINDBUFFERPROC glBindBuffer;
 PFNGLBUFFERDATAPROC glBufferData;
 PFNGLBUFFERSUBDATAPROC glBufferSubData;
+PFNGLGETBUFFERSUBDATAPROC glGetBufferSubData;
+PFNGLTEXBUFFERPROC glTexBuffer;
 PFNGLGENBUFFERSPROC glGenBuffers;
 PFNGLACTIVETEXTUREPROC glActiveTexture;
 PFNGLBINDATTRIBLOCATIONPROC glBindAttribLocation;
@@ -40,139 +42,269 @@ PFNGLVALIDATEPROGRAMPROC glValidateProgram;
 PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform;
 PFNGLUNIFORM4FVPROC glUniform4fv;
 PFNGLUNIFORM1FPROC glUniform1f;
+PFNGLUNIFORM2FPROC glUniform2f;
 PFNGLUNIFORM2IVPROC glUniform2iv;
 PFNGLPATCHPARAMETERIPROC glPatchParameteri;
 PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
 PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
 PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
-
-PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
-
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+PFNGLFENCESYNCPROC glFenceSync;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+PFNGLDELETESYNCPROC glDeleteSync;
+PFNGLDELETEPROGRAMPROC glDeleteProgram;
+PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
+PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
+PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers;
+PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
+PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer;
+PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced;
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+PFNGLPROGRAMBINARYPROC glProgramBinary;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+int GL_parallel_shader_compile = 0;
+PFNGLTEXSTORAGE2DPROC glTexStorage2D;
+PFNGLBUFFERSTORAGEPROC glBufferStorage;
+PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
+PFNGLMEMORYBARRIERPROC glMemoryBarrier;
+PFNGLBINDIMAGETEXTUREPROC glBindImageTexture;
+int GL_compute_shader = 0;
+PFNGLGENQUERIESPROC glGenQueries;
+PFNGLDELETEQUERIESPROC glDeleteQueries;
+PFNGLBEGINQUERYPROC glBeginQuery;
+PFNGLENDQUERYPROC glEndQuery;
+PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+int GL_timer_query = 0;
+
+
+static int has_extension(const char *name) {
+	const char *ext = (const char*)glGetString(GL_EXTENSIONS);
+	size_t len = strlen(name);
+	while (ext && (ext = strstr(ext, name)) != NULL) {
+		if (ext[len] == ' ' || ext[len] == '\0') {
+			return 1;
+		}
+		ext += len;
+	}
+	return 0;
+}
 
 int load_GL_extensions() {
 
-	glGetShaderiv = (PFNGLGETSHADERIVPROC)wglGetProcAddress("glGetShaderiv");
+	glGetShaderiv = (PFNGLGETSHADERIVPROC)platform_get_proc_address("glGetShaderiv");
 	assert(glGetShaderiv);
 	
-	glGetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC)wglGetProcAddress("glGetShaderInfoLog");
+	glGetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC)platform_get_proc_address("glGetShaderInfoLog");
 	assert(glGetShaderInfoLog);
 
-	glCreateShader = (PFNGLCREATESHADERPROC)wglGetProcAddress("glCreateShader");
+	glCreateShader = (PFNGLCREATESHADERPROC)platform_get_proc_address("glCreateShader");
 	assert(glCreateShader);
 
-	glAttachShader = (PFNGLATTACHSHADERPROC)wglGetProcAddress("glAttachShader");
+	glAttachShader = (PFNGLATTACHSHADERPROC)platform_get_proc_address("glAttachShader");
 	assert(glAttachShader);
 
-	glCompileShader = (PFNGLCOMPILESHADERARBPROC)wglGetProcAddress("glCompileShader");
+	glCompileShader = (PFNGLCOMPILESHADERARBPROC)platform_get_proc_address("glCompileShader");
 	assert(glCompileShader);
 
-	glGetProgramiv = (PFNGLGETPROGRAMIVPROC)wglGetProcAddress("glGetProgramiv");
+	glGetProgramiv = (PFNGLGETPROGRAMIVPROC)platform_get_proc_address("glGetProgramiv");
 	assert(glGetProgramiv);
 
-	glLinkProgram = (PFNGLLINKPROGRAMPROC)wglGetProcAddress("glLinkProgram");
+	glLinkProgram = (PFNGLLINKPROGRAMPROC)platform_get_proc_address("glLinkProgram");
 	assert(glLinkProgram);
 
-	glShaderSource = (PFNGLSHADERSOURCEPROC)wglGetProcAddress("glShaderSource");
+	glShaderSource = (PFNGLSHADERSOURCEPROC)platform_get_proc_address("glShaderSource");
 	assert(glShaderSource);
 	
-	glCreateProgram = (PFNGLCREATEPROGRAMPROC)wglGetProcAddress("glCreateProgram");
+	glCreateProgram = (PFNGLCREATEPROGRAMPROC)platform_get_proc_address("glCreateProgram");
 	assert(glCreateProgram);
 
-	glBindBuffer = (PFNGLBINDBUFFERPROC)wglGetProcAddress("glBindBuffer");
+	glBindBuffer = (PFNGLBINDBUFFERPROC)platform_get_proc_address("glBindBuffer");
 	assert(glBindBuffer);
 
-	glBufferData = (PFNGLBUFFERDATAPROC)wglGetProcAddress("glBufferData");
+	glBufferData = (PFNGLBUFFERDATAPROC)platform_get_proc_address("glBufferData");
 	assert(glBufferData);
 
-	glBufferSubData = (PFNGLBUFFERSUBDATAPROC)wglGetProcAddress("glBufferSubData");
+	glBufferSubData = (PFNGLBUFFERSUBDATAPROC)platform_get_proc_address("glBufferSubData");
 	assert(glBufferSubData);
+
+	glGetBufferSubData = (PFNGLGETBUFFERSUBDATAPROC)platform_get_proc_address("glGetBufferSubData");
+	assert(glGetBufferSubData);
+
+	glTexBuffer = (PFNGLTEXBUFFERPROC)platform_get_proc_address("glTexBuffer");
+	assert(glTexBuffer);
 	
-	glGenBuffers = (PFNGLGENBUFFERSPROC)wglGetProcAddress("glGenBuffers");
+	glGenBuffers = (PFNGLGENBUFFERSPROC)platform_get_proc_address("glGenBuffers");
 	assert(glGenBuffers);
 	
-	glActiveTexture = (PFNGLACTIVETEXTUREPROC)wglGetProcAddress("glActiveTexture");
+	glActiveTexture = (PFNGLACTIVETEXTUREPROC)platform_get_proc_address("glActiveTexture");
 	assert(glActiveTexture);
 
-	glBindAttribLocation = (PFNGLBINDATTRIBLOCATIONPROC)wglGetProcAddress("glBindAttribLocation");
+	glBindAttribLocation = (PFNGLBINDATTRIBLOCATIONPROC)platform_get_proc_address("glBindAttribLocation");
 	assert(glBindAttribLocation);
 
-	glBindFragDataLocation = (PFNGLBINDFRAGDATALOCATIONPROC)wglGetProcAddress("glBindFragDataLocation");
+	glBindFragDataLocation = (PFNGLBINDFRAGDATALOCATIONPROC)platform_get_proc_address("glBindFragDataLocation");
 	assert(glBindFragDataLocation);
 
-	glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)wglGetProcAddress("glBindFramebuffer");
+	glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)platform_get_proc_address("glBindFramebuffer");
 	assert(glBindFramebuffer);
 
-	glClientActiveTexture = (PFNGLCLIENTACTIVETEXTUREPROC)wglGetProcAddress("glClientActiveTexture");
+	glClientActiveTexture = (PFNGLCLIENTACTIVETEXTUREPROC)platform_get_proc_address("glClientActiveTexture");
 	assert(glClientActiveTexture);
 
-	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)wglGetProcAddress("glDeleteBuffers");
+	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)platform_get_proc_address("glDeleteBuffers");
 	assert(glDeleteBuffers);
 
-	glDrawBuffers = (PFNGLDRAWBUFFERSPROC)wglGetProcAddress("glDrawBuffers");
+	glDrawBuffers = (PFNGLDRAWBUFFERSPROC)platform_get_proc_address("glDrawBuffers");
 	assert(glDrawBuffers);
 
-	glEnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC)wglGetProcAddress("glEnableVertexAttribArray");
+	glEnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC)platform_get_proc_address("glEnableVertexAttribArray");
 	assert(glEnableVertexAttribArray);
 
-	glFramebufferTexture = (PFNGLFRAMEBUFFERTEXTUREPROC)wglGetProcAddress("glFramebufferTexture");
+	glFramebufferTexture = (PFNGLFRAMEBUFFERTEXTUREPROC)platform_get_proc_address("glFramebufferTexture");
 	assert(glFramebufferTexture);
 
-	glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)wglGetProcAddress("glGenFramebuffers");
+	glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)platform_get_proc_address("glGenFramebuffers");
 	assert(glGenFramebuffers);
 
-	glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC)wglGetProcAddress("glGetUniformLocation");
+	glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC)platform_get_proc_address("glGetUniformLocation");
 	assert(glGetUniformLocation);
 
-	glUniformMatrix4fv = (PFNGLUNIFORMMATRIX4FVPROC)wglGetProcAddress("glUniformMatrix4fv");
+	glUniformMatrix4fv = (PFNGLUNIFORMMATRIX4FVPROC)platform_get_proc_address("glUniformMatrix4fv");
 	assert(glUniformMatrix4fv);
 
-	glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)wglGetProcAddress("glCheckFramebufferStatus");
+	glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)platform_get_proc_address("glCheckFramebufferStatus");
 	assert(glCheckFramebufferStatus);
 
-	glUseProgram = (PFNGLUSEPROGRAMPROC)wglGetProcAddress("glUseProgram");
+	glUseProgram = (PFNGLUSEPROGRAMPROC)platform_get_proc_address("glUseProgram");
 	assert(glUseProgram);
 
-	glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)wglGetProcAddress("glVertexAttribPointer");
+	glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)platform_get_proc_address("glVertexAttribPointer");
 	assert(glVertexAttribPointer);
 
-	glUniform1i = (PFNGLUNIFORM1IPROC)wglGetProcAddress("glUniform1i");
+	glUniform1i = (PFNGLUNIFORM1IPROC)platform_get_proc_address("glUniform1i");
 	assert(glUniform1i);
 
-	glGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)wglGetProcAddress("glGenerateMipmap");
+	glGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)platform_get_proc_address("glGenerateMipmap");
 	assert(glGenerateMipmap);
 
-	glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC)wglGetProcAddress("glGetProgramInfoLog");
+	glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC)platform_get_proc_address("glGetProgramInfoLog");
 	assert(glGetProgramInfoLog);
 
-	glValidateProgram = (PFNGLVALIDATEPROGRAMPROC)wglGetProcAddress("glValidateProgram");
+	glValidateProgram = (PFNGLVALIDATEPROGRAMPROC)platform_get_proc_address("glValidateProgram");
 	assert(glValidateProgram);
 
-	glGetActiveUniform = (PFNGLGETACTIVEUNIFORMPROC)wglGetProcAddress("glGetActiveUniform");
+	glGetActiveUniform = (PFNGLGETACTIVEUNIFORMPROC)platform_get_proc_address("glGetActiveUniform");
 	assert(glGetActiveUniform);
 
-	glUniform4fv = (PFNGLUNIFORM4FVPROC)wglGetProcAddress("glUniform4fv");
+	glUniform4fv = (PFNGLUNIFORM4FVPROC)platform_get_proc_address("glUniform4fv");
 	assert(glUniform4fv);
 
-	glUniform1f = (PFNGLUNIFORM1FPROC)wglGetProcAddress("glUniform1f");
+	glUniform1f = (PFNGLUNIFORM1FPROC)platform_get_proc_address("glUniform1f");
 	assert(glUniform1f);
 
-	glUniform2iv = (PFNGLUNIFORM2IVPROC)wglGetProcAddress("glUniform2iv");
+	glUniform2f = (PFNGLUNIFORM2FPROC)platform_get_proc_address("glUniform2f");
+	assert(glUniform2f);
+
+	glUniform2iv = (PFNGLUNIFORM2IVPROC)platform_get_proc_address("glUniform2iv");
 	assert(glUniform2iv);
 
-	glPatchParameteri = (PFNGLPATCHPARAMETERIPROC)wglGetProcAddress("glPatchParameteri");
+	glPatchParameteri = (PFNGLPATCHPARAMETERIPROC)platform_get_proc_address("glPatchParameteri");
 	assert(glPatchParameteri);
 
-	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)wglGetProcAddress("glGenVertexArrays");
+	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)platform_get_proc_address("glGenVertexArrays");
 	assert(glGenVertexArrays);
 
-	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)wglGetProcAddress("glBindVertexArray");
+	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)platform_get_proc_address("glBindVertexArray");
 	assert(glBindVertexArray);
 
-	glDisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC)wglGetProcAddress("glDisableVertexAttribArray");
+	glDisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC)platform_get_proc_address("glDisableVertexAttribArray");
 	assert(glDisableVertexAttribArray);
 
-	wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
-	assert(wglSwapIntervalEXT);
+	glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)platform_get_proc_address("glMapBufferRange");
+	assert(glMapBufferRange);
+
+	glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)platform_get_proc_address("glUnmapBuffer");
+	assert(glUnmapBuffer);
+
+	glFenceSync = (PFNGLFENCESYNCPROC)platform_get_proc_address("glFenceSync");
+	assert(glFenceSync);
+
+	glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)platform_get_proc_address("glClientWaitSync");
+	assert(glClientWaitSync);
+
+	glDeleteSync = (PFNGLDELETESYNCPROC)platform_get_proc_address("glDeleteSync");
+	assert(glDeleteSync);
+
+	glDeleteProgram = (PFNGLDELETEPROGRAMPROC)platform_get_proc_address("glDeleteProgram");
+	assert(glDeleteProgram);
+
+	glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)platform_get_proc_address("glDeleteFramebuffers");
+	assert(glDeleteFramebuffers);
+
+	glGenRenderbuffers = (PFNGLGENRENDERBUFFERSPROC)platform_get_proc_address("glGenRenderbuffers");
+	assert(glGenRenderbuffers);
+
+	glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC)platform_get_proc_address("glDeleteRenderbuffers");
+	assert(glDeleteRenderbuffers);
+
+	glBindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC)platform_get_proc_address("glBindRenderbuffer");
+	assert(glBindRenderbuffer);
+
+	glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC)platform_get_proc_address("glRenderbufferStorage");
+	assert(glRenderbufferStorage);
+
+	glFramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFERPROC)platform_get_proc_address("glFramebufferRenderbuffer");
+	assert(glFramebufferRenderbuffer);
+
+	glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)platform_get_proc_address("glDrawArraysInstanced");
+	assert(glDrawArraysInstanced);
+
+	glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)platform_get_proc_address("glVertexAttribDivisor");
+	assert(glVertexAttribDivisor);
+
+	// optional, callers check for NULL
+	glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)platform_get_proc_address("glGetProgramBinary");
+	glProgramBinary = (PFNGLPROGRAMBINARYPROC)platform_get_proc_address("glProgramBinary");
+	glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)platform_get_proc_address("glProgramParameteri");
+	if (has_extension("GL_KHR_parallel_shader_compile")) {
+		glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)platform_get_proc_address("glMaxShaderCompilerThreadsKHR");
+	}
+	else if (has_extension("GL_ARB_parallel_shader_compile")) {
+		glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)platform_get_proc_address("glMaxShaderCompilerThreadsARB");
+	}
+	if (glMaxShaderCompilerThreadsKHR) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);	// as many as the driver likes
+		GL_parallel_shader_compile = 1;
+	}
+	glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)platform_get_proc_address("glTexStorage2D");
+	glBufferStorage = (PFNGLBUFFERSTORAGEPROC)platform_get_proc_address("glBufferStorage");
+
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major * 10 + minor >= 43 || has_extension("GL_ARB_compute_shader")) {
+		glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)platform_get_proc_address("glDispatchCompute");
+		glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)platform_get_proc_address("glMemoryBarrier");
+		glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)platform_get_proc_address("glBindImageTexture");
+		GL_compute_shader = glDispatchCompute && glMemoryBarrier && glBindImageTexture;
+	}
+	if (major * 10 + minor >= 33 || has_extension("GL_ARB_timer_query")) {
+		glGenQueries = (PFNGLGENQUERIESPROC)platform_get_proc_address("glGenQueries");
+		glDeleteQueries = (PFNGLDELETEQUERIESPROC)platform_get_proc_address("glDeleteQueries");
+		glBeginQuery = (PFNGLBEGINQUERYPROC)platform_get_proc_address("glBeginQuery");
+		glEndQuery = (PFNGLENDQUERYPROC)platform_get_proc_address("glEndQuery");
+		glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC)platform_get_proc_address("glGetQueryObjectiv");
+		glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)platform_get_proc_address("glGetQueryObjectui64v");
+		GL_timer_query = glGenQueries && glDeleteQueries && glBeginQuery && glEndQuery && glGetQueryObjectiv && glGetQueryObjectui64v;
+	}
+
+	// a new context, nothing the state cache remembers applies to it
+	gls_invalidate();
 
 	return 1;
 }
\ No newline at end of file
@@ -1,8 +1,19 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <wingdi.h>
 #include <gl\gl.h>
+#else
+// the headless build (see platform.h). mesa's gl.h has prototypes for some of the 1.3 entry points that
+// are function pointers here, so those are renamed out of the way
+#define GL_GLEXT_LEGACY
+#define glActiveTexture mesa_glActiveTexture
+#define glClientActiveTexture mesa_glClientActiveTexture
+#include <GL/gl.h>
+#undef glActiveTexture
+#undef glClientActiveTexture
+#endif
 
 #ifndef APIENTRY
 #define APIENTRY
@@ -18,6 +29,8 @@ typedef unsigned int GLhandleARB; // this is the #else bracnh of "#ifdef __APPLE
 #include <stddef.h>
 typedef ptrdiff_t GLsizeiptr;
 typedef ptrdiff_t GLintptr;
+typedef unsigned long long GLuint64;
+typedef struct __GLsync *GLsync;
 
 #define GL_ARRAY_BUFFER                   0x8892
 #define GL_ELEMENT_ARRAY_BUFFER           0x8893
@@ -34,9 +47,46 @@ typedef ptrdiff_t GLintptr;
 
 #define GL_STATIC_DRAW                    0x88E4
 #define GL_DYNAMIC_DRAW                   0x88E8
+#define GL_STREAM_DRAW                    0x88E0
+#define GL_STREAM_READ                    0x88E1
+
+#define GL_PIXEL_PACK_BUFFER              0x88EB
+#define GL_PIXEL_UNPACK_BUFFER            0x88EC
+#define GL_MAP_READ_BIT                   0x0001
+#define GL_MAP_WRITE_BIT                  0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT       0x0004
+#define GL_MAP_INVALIDATE_BUFFER_BIT      0x0008
+#define GL_MAP_UNSYNCHRONIZED_BIT         0x0020
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#define GL_TIMEOUT_EXPIRED                0x911B
+#define GL_WAIT_FAILED                    0x911D
 
 #define GL_TEXTURE0                       0x84C0
 #define GL_COLOR_ATTACHMENT0              0x8CE0
+#define GL_DEPTH_ATTACHMENT               0x8D00
+#define GL_RENDERBUFFER                   0x8D41
+#define GL_DEPTH_COMPONENT24              0x81A6
+
+#define GL_TEXTURE_BUFFER                 0x8C2A
+#define GL_R32F                           0x822E
+#define GL_RGBA32F                        0x8814
+#define GL_READ_ONLY                      0x88B8
+#define GL_WRITE_ONLY                     0x88B9
+
+#define GL_TEXTURE_FETCH_BARRIER_BIT      0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_BUFFER_UPDATE_BARRIER_BIT      0x00000200
+
+#define GL_TIME_ELAPSED                   0x88BF
+#define GL_QUERY_RESULT                   0x8866
+#define GL_QUERY_RESULT_AVAILABLE         0x8867
+
+#define GL_MAJOR_VERSION                  0x821B
+#define GL_MINOR_VERSION                  0x821C
 
 #define GL_MAX_ELEMENTS_VERTICES          0x80E8
 #define GL_MAX_ELEMENTS_INDICES           0x80E9
@@ -45,8 +95,10 @@ typedef ptrdiff_t GLintptr;
 #define GL_VERTEX_SHADER                  0x8B31
 #define GL_TESS_EVALUATION_SHADER         0x8E87
 #define GL_TESS_CONTROL_SHADER            0x8E88
+#define GL_COMPUTE_SHADER                 0x91B9
 
 #define GL_FRAMEBUFFER_COMPLETE           0x8CD5
+#define GL_FRAMEBUFFER_BINDING            0x8CA6
 #define GL_LINK_STATUS                    0x8B82
 #define GL_COMPILE_STATUS                 0x8B81
 #define GL_INFO_LOG_LENGTH                0x8B84
@@ -56,8 +108,12 @@ typedef ptrdiff_t GLintptr;
 
 #define GL_SHADING_LANGUAGE_VERSION       0x8B8C
 
-typedef bool (APIENTRYP PFNWGLSWAPINTERVALEXTPROC) (int interval);
-extern PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
 
 typedef void (APIENTRYP PFNGLGETSHADERIVPROC) (GLuint shader, GLenum pname, GLint *params);
 extern PFNGLGETSHADERIVPROC glGetShaderiv;
@@ -98,6 +154,12 @@ extern PFNGLBUFFERDATAPROC glBufferData;
 typedef void (APIENTRYP PFNGLBUFFERSUBDATAPROC) (GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 extern PFNGLBUFFERSUBDATAPROC glBufferSubData;
 
+typedef void (APIENTRYP PFNGLGETBUFFERSUBDATAPROC) (GLenum target, GLintptr offset, GLsizeiptr size, void *data);
+extern PFNGLGETBUFFERSUBDATAPROC glGetBufferSubData;
+
+typedef void (APIENTRYP PFNGLTEXBUFFERPROC) (GLenum target, GLenum internalformat, GLuint buffer);
+extern PFNGLTEXBUFFERPROC glTexBuffer;
+
 typedef void (APIENTRYP PFNGLGENBUFFERSPROC) (GLsizei n, GLuint *buffers);
 extern PFNGLGENBUFFERSPROC glGenBuffers;
 
@@ -167,6 +229,9 @@ extern PFNGLUNIFORM4FVPROC glUniform4fv;
 typedef void (APIENTRYP PFNGLUNIFORM1FPROC) (GLint location, GLfloat v0);
 extern PFNGLUNIFORM1FPROC glUniform1f;
 
+typedef void (APIENTRYP PFNGLUNIFORM2FPROC) (GLint location, GLfloat v0, GLfloat v1);
+extern PFNGLUNIFORM2FPROC glUniform2f;
+
 typedef void (APIENTRYP PFNGLUNIFORM2IVPROC) (GLint location, GLsizei count, const GLint *value);
 extern PFNGLUNIFORM2IVPROC glUniform2iv;
 
@@ -182,4 +247,100 @@ extern PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
 typedef void (APIENTRYP PFNGLDISABLEVERTEXATTRIBARRAYPROC) (GLuint index);
 extern PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
 
+typedef void* (APIENTRYP PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+extern PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+
+typedef GLboolean(APIENTRYP PFNGLUNMAPBUFFERPROC) (GLenum target);
+extern PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+
+typedef GLsync(APIENTRYP PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+extern PFNGLFENCESYNCPROC glFenceSync;
+
+typedef GLenum(APIENTRYP PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+extern PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+
+typedef void (APIENTRYP PFNGLDELETESYNCPROC) (GLsync sync);
+extern PFNGLDELETESYNCPROC glDeleteSync;
+
+typedef void (APIENTRYP PFNGLDELETEPROGRAMPROC) (GLuint program);
+extern PFNGLDELETEPROGRAMPROC glDeleteProgram;
+
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint *framebuffers);
+extern PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
+
+typedef void (APIENTRYP PFNGLGENRENDERBUFFERSPROC) (GLsizei n, GLuint *renderbuffers);
+extern PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
+
+typedef void (APIENTRYP PFNGLDELETERENDERBUFFERSPROC) (GLsizei n, const GLuint *renderbuffers);
+extern PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers;
+
+typedef void (APIENTRYP PFNGLBINDRENDERBUFFERPROC) (GLenum target, GLuint renderbuffer);
+extern PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
+
+typedef void (APIENTRYP PFNGLRENDERBUFFERSTORAGEPROC) (GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+extern PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
+
+typedef void (APIENTRYP PFNGLFRAMEBUFFERRENDERBUFFERPROC) (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+extern PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer;
+
+typedef void (APIENTRYP PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+extern PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced;
+
+typedef void (APIENTRYP PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+extern PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+
+// the ones below are GL 4.1/4.2/4.4 (ARB_get_program_binary, ARB_texture_storage, ARB_buffer_storage) and NULL if the driver doesn't have them
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+extern PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+extern PFNGLPROGRAMBINARYPROC glProgramBinary;
+
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+extern PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+
+// KHR_parallel_shader_compile, or the ARB version of it (same enums, ARB suffix on the function)
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count);
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+extern int GL_parallel_shader_compile;
+
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC) (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+extern PFNGLTEXSTORAGE2DPROC glTexStorage2D;
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glBufferStorage;
+
+// compute shaders (GL 4.3 or ARB_compute_shader) with the 4.2 image load/store bits they write through.
+// GL_compute_shader is 1 if all of these are there
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC) (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+extern PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
+
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC) (GLbitfield barriers);
+extern PFNGLMEMORYBARRIERPROC glMemoryBarrier;
+
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC) (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+extern PFNGLBINDIMAGETEXTUREPROC glBindImageTexture;
+extern int GL_compute_shader;
+
+// timer queries (GL 3.3 or ARB_timer_query), GL_timer_query is 1 if all of these are there
+typedef void (APIENTRYP PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids);
+extern PFNGLGENQUERIESPROC glGenQueries;
+
+typedef void (APIENTRYP PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids);
+extern PFNGLDELETEQUERIESPROC glDeleteQueries;
+
+typedef void (APIENTRYP PFNGLBEGINQUERYPROC) (GLenum target, GLuint id);
+extern PFNGLBEGINQUERYPROC glBeginQuery;
+
+typedef void (APIENTRYP PFNGLENDQUERYPROC) (GLenum target);
+extern PFNGLENDQUERYPROC glEndQuery;
+
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTIVPROC) (GLuint id, GLenum pname, GLint *params);
+extern PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv;
+
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, GLuint64 *params);
+extern PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+extern int GL_timer_query;
+
 int load_GL_extensions();
\ No newline at end of file
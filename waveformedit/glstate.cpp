@@ -0,0 +1,95 @@
+#include "glstate.h"
+
+// nothing is ever bound to this, so it works as "don't know"
+#define GLS_UNKNOWN 0xFFFFFFFF
+
+enum {
+	GLS_ARRAY_BUFFER,
+	GLS_ELEMENT_ARRAY_BUFFER,
+	GLS_PIXEL_PACK_BUFFER,
+	GLS_PIXEL_UNPACK_BUFFER,
+	GLS_NUM_BUFFER_TARGETS
+};
+
+struct gl_state_t {
+	GLuint program;
+	GLuint vao;
+	GLuint buffers[GLS_NUM_BUFFER_TARGETS];
+	GLint patch_vertices;
+	gls_counts_t counts;
+};
+
+static gl_state_t state = { GLS_UNKNOWN, GLS_UNKNOWN, { GLS_UNKNOWN, GLS_UNKNOWN, GLS_UNKNOWN, GLS_UNKNOWN }, -1, { 0, 0 } };
+
+static int buffer_target_index(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER: return GLS_ARRAY_BUFFER;
+	case GL_ELEMENT_ARRAY_BUFFER: return GLS_ELEMENT_ARRAY_BUFFER;
+	case GL_PIXEL_PACK_BUFFER: return GLS_PIXEL_PACK_BUFFER;
+	case GL_PIXEL_UNPACK_BUFFER: return GLS_PIXEL_UNPACK_BUFFER;
+	default: return -1;
+	}
+}
+
+void gls_use_program(GLuint program) {
+	if (state.program == program) {
+		++state.counts.filtered;
+		return;
+	}
+	glUseProgram(program);
+	state.program = program;
+	++state.counts.issued;
+}
+
+void gls_bind_vertex_array(GLuint vao) {
+	if (state.vao == vao) {
+		++state.counts.filtered;
+		return;
+	}
+	glBindVertexArray(vao);
+	state.vao = vao;
+	// the element array binding lives in the VAO
+	state.buffers[GLS_ELEMENT_ARRAY_BUFFER] = GLS_UNKNOWN;
+	++state.counts.issued;
+}
+
+void gls_bind_buffer(GLenum target, GLuint buffer) {
+	int i = buffer_target_index(target);
+	if (i >= 0 && state.buffers[i] == buffer) {
+		++state.counts.filtered;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (i >= 0) {
+		state.buffers[i] = buffer;
+	}
+	++state.counts.issued;
+}
+
+void gls_patch_parameteri(GLenum pname, GLint value) {
+	if (pname == GL_PATCH_VERTICES && state.patch_vertices == value) {
+		++state.counts.filtered;
+		return;
+	}
+	glPatchParameteri(pname, value);
+	if (pname == GL_PATCH_VERTICES) {
+		state.patch_vertices = value;
+	}
+	++state.counts.issued;
+}
+
+void gls_invalidate() {
+	state.program = GLS_UNKNOWN;
+	state.vao = GLS_UNKNOWN;
+	for (int i = 0; i < GLS_NUM_BUFFER_TARGETS; ++i) {
+		state.buffers[i] = GLS_UNKNOWN;
+	}
+	state.patch_vertices = -1;
+}
+
+gls_counts_t gls_take_counts() {
+	gls_counts_t counts = state.counts;
+	state.counts.issued = 0;
+	state.counts.filtered = 0;
+	return counts;
+}
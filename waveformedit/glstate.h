@@ -0,0 +1,23 @@
+#pragma once
+
+#include "glext_loader.h"
+
+// a thin cache over the binding calls that the frame repeats a lot (every uniform update makes its program
+// current, for one). a call that wouldn't change the bound state never reaches the driver. everything that
+// binds these has to go through here, or call gls_invalidate afterwards. one context at a time, GL thread only
+
+void gls_use_program(GLuint program);
+void gls_bind_vertex_array(GLuint vao);
+void gls_bind_buffer(GLenum target, GLuint buffer);
+void gls_patch_parameteri(GLenum pname, GLint value);
+
+// forget everything, the next call of each kind goes through. for a new context
+void gls_invalidate();
+
+struct gls_counts_t {
+	unsigned issued;
+	unsigned filtered;
+};
+
+// the counts since the last call, then starts over. once a frame
+gls_counts_t gls_take_counts();
@@ -15,9 +15,21 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "capture.h"
+#include "gputimer.h"
+#include "render.h"
+#include "glstate.h"
+#include "stats.h"
+#include "text.h"
+#include "glyphs.h"
+#include "platform.h"
+#include "loader.h"
+#include "timer.h"
 #include "lin_alg.h"
 #include "sound.h"
 #include "curve.h"
+#include "wavetable.h"
+#include "oversample.h"
 
 bool mouse_locked = false;
 
@@ -33,22 +45,34 @@ static HWND hWnd_child = NULL;
 unsigned WINDOW_WIDTH = WIN_W;
 unsigned WINDOW_HEIGHT = WIN_H;
 
-static GLuint wave_VBOid, wave_VAOid;
-
 bool fullscreen = false;
 bool active = TRUE;
 
 static Texture *gradient_texture;
-static ShaderProgram *wave_shader, *point_shader, *grid_shader;
+static render_programs_t programs;
+static render_curve_t curve;
+static load_handle_t wave_shader_handle, point_shader_handle, grid_shader_handle;
+static load_handle_t tile_shader_handle, text_shader_handle, font_handle;
+static load_handle_t wave_lod_shader_handle, wave_reduce_shader_handle;
+static bool resources_ready = false;
+static perf_timer_t startup_timer;
+
+// the window only redraws when something changed (damage) or while the curve animates, A toggles the animation.
+// it starts off, an editor nobody touches doesn't draw at all
+static bool damaged = true;
+static bool animating = false;
+
+// I toggles the stats overlay
+static bool show_stats = false;
+
+// F9 starts and stops recording the view as a png sequence (see capture.h)
+#define CAPTURE_DIR "capture"
 
 static bool _main_loop_running = true;
 bool main_loop_running() { return _main_loop_running; }
 void stop_main_loop() { _main_loop_running = false; }
 
 
-
-#define NUM_CURVES 1
-
 void kill_GL_window();
 
 void set_cursor_relative_pos(int x, int y) {
@@ -101,139 +125,260 @@ vec4 solve_equation_coefs(const float *points) {
 	return correct;
 }
 
-static float *sample_buffer = NULL;
-
 static float GT = 0;
 
-static int allocate_static_buf(size_t size) {
-	if (sample_buffer == NULL) {
-		sample_buffer = new float[size];
-		return 1;
-	}
-	return 0;
-}
-
+static float cycle_buffer[WT_TABLE_SIZE];
 
+static void get_cycle(const vec4 &coefs, float *cycle) {
+	// renders exactly one period, SND_set_cycle turns this into the band-limited tables
 
-static int get_samples(const vec4 &coefs, wave_format_t *fmt) {
-	UINT32 frame_size = SND_get_frame_size();
-
-	float dt = 1.0 / (float)frame_size;
+	float dt = 1.0 / (float)WT_TABLE_SIZE;
 	float x = 0;
 
-	for (int i = 0; i < frame_size; ++i) {
+	for (int i = 0; i < WT_TABLE_SIZE; ++i) {
 		float x2 = x*x;
 		float x3 = x2*x;
 		vec4 tmp = vec4(x3, x2, x, 1);
 		
-		float v = 0.6*dot4(coefs, tmp);
-
-		//printf("v: %.4f\n", v);
-	
-		sample_buffer[2*i] = v;
-		sample_buffer[2*i + 1] = v;
+		cycle[i] = 0.6*dot4(coefs, tmp);
 
 		x += dt;
 	}
 
+}
+
+void update_data() {
 
-	return 1;
+	render_curve_at(GT, &curve);
+
+	float points[8] = {
+		0.0, curve.y[0],
+		0.33, curve.y[1],
+		0.66, curve.y[2],
+		1.0, curve.y[3]
+	};
+
+	// the wavetables are only rebuilt when the curve actually changes
+	static float prev_points[8];
+	static bool have_prev_points = false;
+
+	if (!have_prev_points || memcmp(points, prev_points, sizeof(points)) != 0) {
+		vec4 coefs = solve_equation_coefs(points);
+		get_cycle(coefs, cycle_buffer);
+		SND_set_cycle(cycle_buffer);
+
+		memcpy(prev_points, points, sizeof(points));
+		have_prev_points = true;
+	}
 
 }
 
-void update_data() {
 
-	//static float patch_buffer[NUM_CURVES];
+static void toggle_preview_note();
 
-	//for (int i = 0; i < NUM_CURVES; ++i) {
-	//	patch_buffer[i] = (float)i / (float)NUM_CURVES;
-	//}
+// the shaders come in through the loader, the first frames just clear until they're all there
+// and the audio device is up
+static bool poll_resources() {
+	if (resources_ready) {
+		return true;
+	}
 
-	mat4 m = mat4(
-		vec4(0, 0, 0, 1), 
-		vec4((0.33*0.33*0.33), (0.33*0.33), 0.33, 1), 
-		vec4((0.66*0.66*0.66), (0.66*0.66), 0.66, 1), 
-		vec4(1, 1, 1, 1));
-	
-	m.invert();
+	loader_poll(4.0);
 
-	float y0, y1, y2, y3;
-	y0 = 0.0;
-	y1 = sin(GT);
-	y2 = -sin(GT);
-	y3 = 0.0;
+	load_handle_t handles[8] = { wave_shader_handle, point_shader_handle, grid_shader_handle, tile_shader_handle,
+		wave_lod_shader_handle, wave_reduce_shader_handle, text_shader_handle, font_handle };
+	for (int i = 0; i < 8; ++i) {
+		if (loader_status(handles[i]) == LOAD_PENDING) { return false; }
+	}
+	if (!SND_initialized()) {
+		return false;
+	}
 
-	float points[8] = {
-		0.0, y0,
-		0.33, y1,
-		0.66, y2,
-		1.0, y3
-	};
+	programs.wave = loader_shader(wave_shader_handle);
+	programs.point = loader_shader(point_shader_handle);
+	programs.grid = loader_shader(grid_shader_handle);
+	programs.tile = loader_shader(tile_shader_handle);
+	programs.wave_lod = loader_shader(wave_lod_shader_handle);
+	if (!programs.wave || !programs.point || !programs.grid || !programs.tile || !programs.wave_lod) {
+		static bool reported = false;
+		if (!reported) {
+			printf("init: loading the shaders failed, exiting.\n");
+			PostQuitMessage(0);
+			reported = true;
+		}
+		return false;
+	}
 
-	while (!SND_initialized()) { Sleep(250); }
+	// without compute shaders the zoomed out wave gets its columns from the CPU
+	programs.wave_reduce = loader_shader(wave_reduce_shader_handle);
+	if (!programs.wave_reduce) {
+		printf("init: no compute shaders, the waveform overview is reduced on the CPU.\n");
+	}
 
-	wave_format_t fmt = SND_get_format_info();
-	vec4 coefs = solve_equation_coefs(points);
-	allocate_static_buf(fmt.num_channels * SND_get_frame_size());
-	get_samples(coefs, &fmt);
+	// text is nice to have, the editor works without it
+	programs.text = loader_shader(text_shader_handle);
+	programs.font = loader_texture(font_handle);
+	if (!programs.text || !programs.font) {
+		printf("init: the text shader or the glyph atlas didn't load, no text.\n");
+	}
 
-	SND_write_to_buffer(sample_buffer);
+	// cold (compiled) vs warm (program binary cache) startup
+	ShaderProgram *shaders[5] = { programs.wave, programs.point, programs.grid, programs.tile, programs.wave_lod };
+	int num_cached = 0;
+	double build_ms = 0;
+	for (int i = 0; i < 5; ++i) {
+		num_cached += shaders[i]->is_from_cache() ? 1 : 0;
+		build_ms += shaders[i]->get_build_ms();
+	}
+	printf("startup: shaders ready %.1f ms after init_GL, %.1f ms of it building programs (%d/5 from the program cache, %s start)\n",
+		startup_timer.get_ms(), build_ms, num_cached, num_cached == 5 ? "warm" : "cold");
 
-	glUseProgram(wave_shader->getProgramHandle());
-	wave_shader->update_uniform_mat4("coefs_inv", m);
-	wave_shader->update_uniform_vec4("y_coords", vec4(y0, y1, y2, y3));
+	update_data();
+	toggle_preview_note();
 
-	//glBindBuffer(GL_ARRAY_BUFFER, wave_VBOid);
-	//glBufferSubData(GL_ARRAY_BUFFER, 0, NUM_CURVES*sizeof(float), patch_buffer);
+	resources_ready = true;
+	return true;
+}
 
+void damage_window() {
+	damaged = true;
 }
 
+bool window_wants_frame() {
+	// the loader is polled from draw(), so keep drawing until everything is in. a capture records a steady
+	// stream of frames rather than just the damaged ones
+	return damaged || animating || !resources_ready || capture_active();
+}
 
 void draw() {
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glUseProgram(wave_shader->getProgramHandle());
+	if (!poll_resources()) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		return;
+	}
 
-	mat4 mvp = mat4::proj_ortho(-0.1, 1.1, -1.5, 1.5, -1.0, 1.0);
+	damaged = false;
 
-	wave_shader->update_uniform_mat4("uMVP", mvp);
-	GT += 0.006;
-	
-	wave_shader->update_uniform_1f("TIME", GT);
+	perf_timer_t frame_timer;
 
+	if (animating) { GT += 0.006; }
 	update_data();
 
-	glBindVertexArray(wave_VAOid);	
-	glDrawArrays(GL_PATCHES, 0, NUM_CURVES);
+	if (show_stats) {
+		const char *name;
+		double value;
+		for (int i = 0; stats_last(i, &name, &value); ++i) {
+			text_printf(8, 8 + i * GLYPH_PITCH_Y, TEXT_COLOR_OVERLAY, "%-20s %10.3f", name, value);
+		}
+	}
+
+	render_frame(&programs, &curve, GT);
+	capture_frame(WINDOW_WIDTH, WINDOW_HEIGHT);
 
-	glBindVertexArray(0);
+	gls_counts_t counts = gls_take_counts();
+	stats_add("frame cpu ms", frame_timer.get_ms());
+	stats_add("gl binds issued", counts.issued);
+	stats_add("gl binds filtered", counts.filtered);
+	gpu_timer_end_frame();
+	stats_end_frame();
 
-	glUseProgram(grid_shader->getProgramHandle());
-	grid_shader->update_uniform_1f("tess_level", 11);
-	grid_shader->update_uniform_mat4("uMVP", mvp);
-	glDrawArrays(GL_PATCHES, 0, 1);
+}
+
+// the two letter rows of the keyboard play like a piano, starting from C3
+#define KEYBOARD_BASE_NOTE 48
+static const char note_keys[] = "ZSXDCVGBHNJMQ2W3ER5T6Y7U";
+
+// the edited cycle is always audible through this one, space toggles it
+#define PREVIEW_NOTE 57
+static bool preview_playing = false;
+
+static void toggle_preview_note() {
+	if (preview_playing) { SND_note_off(PREVIEW_NOTE); }
+	else { SND_note_on(PREVIEW_NOTE, 0.8); }
+	preview_playing = !preview_playing;
+}
+
+static int key_to_note(WPARAM key) {
+	for (int i = 0; note_keys[i] != '\0'; ++i) {
+		if ((WPARAM)note_keys[i] == key) {
+			return KEYBOARD_BASE_NOTE + i;
+		}
+	}
+	return -1;
+}
+
+// O cycles through the oversampling factors, P through the decimation filter qualities
+static int oversample_factor = 1;
+static int oversample_quality = OVERSAMPLE_QUALITY_MEDIUM;
+
+static void cycle_oversampling(bool quality) {
+	static const char *quality_names[] = { "low", "medium", "high" };
+
+	if (quality) { oversample_quality = (oversample_quality + 1) % 3; }
+	else { oversample_factor = oversample_factor == 8 ? 1 : oversample_factor * 2; }
+
+	printf("oversampling: %dx, %s quality\n", oversample_factor, quality_names[oversample_quality]);
+	SND_set_oversampling(oversample_factor, oversample_quality);
+}
+
+static void handle_key_press(WPARAM key) {
+	if (key == VK_SPACE) {
+		toggle_preview_note();
+		return;
+	}
+	if (key == 'O' || key == 'P') {
+		cycle_oversampling(key == 'P');
+		return;
+	}
+	if (key == 'I') {
+		show_stats = !show_stats;
+		damage_window();
+		return;
+	}
+	if (key == VK_F9) {
+		if (capture_active()) { capture_stop(); }
+		else { capture_start(CAPTURE_DIR, 0); }
+		return;
+	}
+	if (key == 'A') {
+		animating = !animating;
+		damage_window();
+		printf("animation %s\n", animating ? "on" : "off (redrawing on damage only)");
+		return;
+	}
+
+	int note = key_to_note(key);
+	if (note >= 0) { SND_note_on(note, 0.8); }
+}
 
-	/*grid_shader->update_uniform_1f("tess_level", 22);
-	mvp = mvp * mat4::scale(0.50, 2.0, 0) * mat4::rotate(3.1415926536 / 2.0, 0, 0, 1) * mat4::translate(-0.5, 1.0, 0.0);
-	grid_shader->update_uniform_mat4("uMVP", mvp);
-	glDrawArrays(GL_PATCHES, 0, 1);*/
+// arrows pan and zoom the view, home resets it. these repeat while held
+static bool handle_view_key(WPARAM key) {
+	switch (key) {
+	case VK_LEFT: render_pan(-(double)WIN_W / 8); break;
+	case VK_RIGHT: render_pan((double)WIN_W / 8); break;
+	case VK_UP: render_zoom(1, 0.5 * WIN_W); break;
+	case VK_DOWN: render_zoom(-1, 0.5 * WIN_W); break;
+	case VK_HOME: render_view_reset(); break;
+	default: return false;
+	}
+	damage_window();
+	return true;
+}
 
+static void handle_key_release(WPARAM key) {
+	int note = key_to_note(key);
+	if (note >= 0) { SND_note_off(note); }
 }
 
 int init_GL() {
 
+	startup_timer.begin();
+
 	if (!load_GL_extensions()) {
 		return 0;
 	}
 
-	glClearColor(0.0, 0.0, 0.0, 1.0);
-	glEnable(GL_DEPTH_TEST);
-
-	//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	//glEnable(GL_BLEND);
-
-	wglSwapIntervalEXT(1);
+	platform_swap_interval(1);
 
 	glViewport(0, 0, WIN_W, WIN_H);
 
@@ -245,8 +390,6 @@ int init_GL() {
 	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &max_elements_vertices);
 	glGetIntegerv(GL_MAX_ELEMENTS_INDICES, &max_elements_indices);
 
-	glPatchParameteri(GL_PATCH_VERTICES, 1);
-
 	printf("GL_MAX_ELEMENTS_VERTICES = %d\nGL_MAX_ELEMENTS_INDICES = %d\n", max_elements_vertices, max_elements_indices);
 
 
@@ -257,28 +400,21 @@ int init_GL() {
 	std::unordered_map<GLuint, std::string> default_attrib_bindings;
 	ADD_ATTRIB(default_attrib_bindings, ATTRIB_POSITION, "Position_VS_in");
 
-	wave_shader = new ShaderProgram("shaders/wave", default_attrib_bindings);
-	point_shader = new ShaderProgram("shaders/pointplot", default_attrib_bindings);
-	grid_shader = new ShaderProgram("shaders/grid", default_attrib_bindings);
-
-	// TODO: CHECK SHADERS FOR BADNESS :D
-
-	glGenVertexArrays(1, &wave_VAOid);
-	glBindVertexArray(wave_VAOid);
-
-	glEnableVertexAttribArray(ATTRIB_POSITION);
-
-	glGenBuffers(1, &wave_VBOid);
-	glBindBuffer(GL_ARRAY_BUFFER, wave_VBOid);
-	glBufferData(GL_ARRAY_BUFFER, NUM_CURVES*sizeof(float), NULL, GL_DYNAMIC_DRAW);
-
-	glVertexAttribPointer(ATTRIB_POSITION, 1, GL_FLOAT, GL_FALSE, 1*sizeof(float), 0);
+	// the file reads happen on the loader threads while the window comes up and the audio device
+	// initializes, compiling waits for draw() to poll the loader (see poll_resources)
+	loader_start(0);
 
-	glBindVertexArray(0);
+	wave_shader_handle = loader_load_shader("shaders/wave", default_attrib_bindings);
+	point_shader_handle = loader_load_shader("shaders/pointplot", default_attrib_bindings);
+	grid_shader_handle = loader_load_shader("shaders/grid", default_attrib_bindings);
+	tile_shader_handle = loader_load_shader("shaders/tile", default_attrib_bindings);
+	wave_lod_shader_handle = loader_load_shader("shaders/wave_lod", default_attrib_bindings);
+	wave_reduce_shader_handle = loader_load_shader("shaders/wave_reduce", default_attrib_bindings);
+	text_shader_handle = loader_load_shader("shaders/text", default_attrib_bindings);
+	font_handle = loader_load_texture("textures/dina_all.png", GL_NEAREST);
 
-	//glDisableVertexAttribArray(ATTRIB_POSITION);
-
-	update_data();
+	render_init();
+	render_resize(WIN_W, WIN_H);
 
 	return 1;
 
@@ -296,6 +432,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 			active = FALSE;
 			mouse_locked = false;
 		}
+		damage_window();
+		break;
+
+	case WM_PAINT:
+		// DefWindowProc validates the region, the frame itself is drawn from the main loop
+		damage_window();
 		break;
 
 	case WM_SYSCOMMAND:
@@ -319,16 +461,33 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 		//handle_char_input(wParam);
 		break;
 
+	case WM_MOUSEWHEEL: {
+		// zooms around the pointer
+		POINT pt;
+		pt.x = (short)LOWORD(lParam);
+		pt.y = (short)HIWORD(lParam);
+		ScreenToClient(hWnd, &pt);
+		render_zoom(GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA, pt.x);
+		damage_window();
+		break;
+	}
+
 	case WM_KEYDOWN:
-		//handle_key_press(wParam);
+		if (handle_view_key(wParam)) {
+			break;
+		}
+		if (!BIT_SET(lParam, 30)) { // ignore autorepeat
+			handle_key_press(wParam);
+		}
 		break;
 
 	case WM_KEYUP:
-		//keys[wParam] = false;
+		handle_key_release(wParam);
 		break;
 
 	case WM_SIZE:
 		//resize_GL_scene(LOWORD(lParam), HIWORD(lParam));
+		damage_window();
 		break;
 
 	default:
@@ -495,6 +654,11 @@ int create_GL_window(const char* title, int width, int height) {
 void kill_GL_window() {
 
 	if (hRC) {
+		// the frames still in flight and the half-loaded resources need the context
+		capture_stop();
+		loader_stop();
+
+
 		if (!wglMakeCurrent(NULL, NULL)) {
 			MessageBox(NULL, "wglMakeCurrent(NULL,NULL) failed", "erreur", MB_OK | MB_ICONINFORMATION);
 		}
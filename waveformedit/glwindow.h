@@ -12,4 +12,9 @@ void swap_buffers();
 int create_GL_window(const char* title, int width, int height);
 int init_GL();
 
-void draw();
\ No newline at end of file
+void draw();
+
+// marks the window contents stale, the next main loop iteration redraws
+void damage_window();
+// false when the last frame is still current, the main loop can then block on messages
+bool window_wants_frame();
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <utility>
+
+// the glyph layout of the 128x128 dina_all atlas: 98 glyphs from ' ' on, 14 to a row, 6x12 pixels each on a
+// 7x13 pixel grid starting from the top left. the texcoords are worked out from that at compile time. v counts
+// up from the bottom row of the image, which is how the texture loader stores the rows
+
+#define GLYPH_ATLAS_SIZE 128
+#define GLYPH_WIDTH 6
+#define GLYPH_HEIGHT 12
+#define GLYPH_PITCH_X 7
+#define GLYPH_PITCH_Y 13
+#define GLYPHS_PER_ROW 14
+#define GLYPH_COUNT 98
+#define GLYPH_FIRST_CHAR ' '
+
+struct glyph_t {
+	float u0, v0;	// bottom left
+	float u1, v1;	// top right
+};
+
+struct glyph_table_t {
+	glyph_t glyphs[GLYPH_COUNT];
+};
+
+constexpr float glyph_atlas_u(int px) { return (float)px / (float)GLYPH_ATLAS_SIZE; }
+constexpr float glyph_atlas_v(int px_from_top) { return 1.0f - (float)px_from_top / (float)GLYPH_ATLAS_SIZE; }
+
+constexpr glyph_t glyph_at(int i) {
+	return glyph_t{
+		glyph_atlas_u((i % GLYPHS_PER_ROW) * GLYPH_PITCH_X),
+		glyph_atlas_v((i / GLYPHS_PER_ROW) * GLYPH_PITCH_Y + GLYPH_HEIGHT),
+		glyph_atlas_u((i % GLYPHS_PER_ROW) * GLYPH_PITCH_X + GLYPH_WIDTH),
+		glyph_atlas_v((i / GLYPHS_PER_ROW) * GLYPH_PITCH_Y)
+	};
+}
+
+template <size_t... I>
+constexpr glyph_table_t make_glyph_table(std::index_sequence<I...>) {
+	return glyph_table_t{ { glyph_at((int)I)... } };
+}
+
+constexpr glyph_table_t glyph_table = make_glyph_table(std::make_index_sequence<GLYPH_COUNT>());
+
+// spot checks against the table the old generator script wrote out
+static_assert(glyph_table.glyphs[0].u0 == 0.0f && glyph_table.glyphs[0].v0 == 0.90625f && glyph_table.glyphs[0].u1 == 0.046875f && glyph_table.glyphs[0].v1 == 1.0f, "glyph 0");
+static_assert(glyph_table.glyphs[15].u0 == 0.0546875f && glyph_table.glyphs[15].v1 == 0.8984375f, "glyph 15");
+static_assert(glyph_table.glyphs[GLYPH_COUNT - 1].u1 == 0.7578125f && glyph_table.glyphs[GLYPH_COUNT - 1].v0 == 0.296875f, "last glyph");
+
+// NULL for characters the atlas doesn't have
+inline const glyph_t *glyph_for(char c) {
+	int i = (int)(unsigned char)c - GLYPH_FIRST_CHAR;
+	return i >= 0 && i < GLYPH_COUNT ? &glyph_table.glyphs[i] : NULL;
+}
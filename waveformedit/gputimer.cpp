@@ -0,0 +1,70 @@
+#include "gputimer.h"
+
+#include "glext_loader.h"
+#include "stats.h"
+
+struct gpu_timer_frame_t {
+	GLuint queries[GPU_TIMER_MAX_PASSES];
+	const char *names[GPU_TIMER_MAX_PASSES];
+	int count;
+};
+
+static gpu_timer_frame_t frames[GPU_TIMER_FRAMES];
+static int current = 0;		// the frame the passes go to now
+static bool initialized = false;
+static bool in_pass = false;
+
+void gpu_timer_init() {
+	if (initialized || !GL_timer_query) {
+		return;
+	}
+	for (int i = 0; i < GPU_TIMER_FRAMES; ++i) {
+		glGenQueries(GPU_TIMER_MAX_PASSES, frames[i].queries);
+		frames[i].count = 0;
+	}
+	current = 0;
+	initialized = true;
+}
+
+void gpu_timer_begin(const char *name) {
+	gpu_timer_frame_t *f = &frames[current];
+	if (!initialized || in_pass || f->count >= GPU_TIMER_MAX_PASSES) {
+		return;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, f->queries[f->count]);
+	f->names[f->count] = name;
+	in_pass = true;
+}
+
+void gpu_timer_end() {
+	if (!in_pass) {
+		return;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	++frames[current].count;
+	in_pass = false;
+}
+
+void gpu_timer_end_frame() {
+	if (!initialized) {
+		return;
+	}
+	gpu_timer_end();
+
+	// the oldest frame, the one the next frame's passes reuse
+	current = (current + 1) % GPU_TIMER_FRAMES;
+	gpu_timer_frame_t *f = &frames[current];
+	for (int i = 0; i < f->count; ++i) {
+		// a GPU more than a frame behind, drop the result rather than wait for it
+		GLint available = 0;
+		glGetQueryObjectiv(f->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			stats_add("gpu timer misses", 1);
+			continue;
+		}
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(f->queries[i], GL_QUERY_RESULT, &ns);
+		stats_add(f->names[i], (double)ns * 1e-6);
+	}
+	f->count = 0;
+}
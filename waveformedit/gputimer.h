@@ -0,0 +1,17 @@
+#pragma once
+
+// GPU time per render pass, from GL_TIME_ELAPSED queries. a frame's queries are read at the end of the next
+// frame, when the GPU is long done with them, so nothing waits on a result. they go to stats under the pass
+// names, a frame late. without timer queries all of this does nothing.
+// names are string literals like for stats, passes don't nest. GL thread only
+
+#define GPU_TIMER_FRAMES 2			// frames of queries in flight
+#define GPU_TIMER_MAX_PASSES 16		// per frame, the passes past that aren't timed
+
+void gpu_timer_init();
+
+void gpu_timer_begin(const char *name);
+void gpu_timer_end();
+
+// adds the passes of the frame before to stats and starts over, call it before stats_end_frame
+void gpu_timer_end_frame();
@@ -0,0 +1,274 @@
+#include "headless.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+
+#include "platform.h"
+#include "render.h"
+#include "capture.h"
+#include "gputimer.h"
+#include "glstate.h"
+#include "stats.h"
+#include "shader.h"
+#include "texture.h"
+#include "timer.h"
+#include "lodepng.h"
+
+// outside windows this is its own program, built from the GL side of the editor without the window or
+// the audio, e.g.
+//   g++ -O2 -o wfedit_headless headless.cpp render.cpp shader.cpp glext_loader.cpp glstate.cpp offscreen.cpp
+//       platform_egl.cpp stats.cpp text.cpp texture.cpp tilecache.cpp wavelod.cpp capture.cpp gputimer.cpp lodepng.cpp -lEGL -lGL -lpthread
+// and run from this directory so shaders/ is found. LIBGL_ALWAYS_SOFTWARE=1 forces llvmpipe.
+
+// the frame that gets compared, any fixed time will do as long as it stays the same
+#define HEADLESS_REFERENCE_TIME 1.0f
+
+// the GPU column reduction against the CPU reference, largest difference allowed
+#define HEADLESS_LOD_TOLERANCE 1e-4
+
+void headless_default_options(headless_options_t *opt) {
+	opt->width = 1600;
+	opt->height = 900;
+	opt->frames = 200;
+	opt->markers = 0;
+	opt->pan_px = 0;
+	opt->zoom = 0;
+	opt->capture_dir = NULL;
+	opt->out_png = NULL;
+	opt->reference_png = NULL;
+	opt->tolerance = 2;
+	opt->max_bad_fraction = 0.001;
+}
+
+static int compare_to_reference(const headless_options_t *opt, const std::vector<unsigned char> &pixels) {
+	std::vector<unsigned char> reference;
+	unsigned w, h;
+	unsigned e = lodepng::decode(reference, w, h, opt->reference_png);
+	if (e) {
+		printf("headless: reference %s: %s\n", opt->reference_png, lodepng_error_text(e));
+		return 1;
+	}
+	if (w != (unsigned)opt->width || h != (unsigned)opt->height) {
+		printf("headless: reference is %ux%u, rendered %dx%d\n", w, h, opt->width, opt->height);
+		return 1;
+	}
+
+	size_t num_bad = 0;
+	int max_diff = 0;
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		int pixel_diff = 0;
+		for (int c = 0; c < 4; ++c) {
+			int d = abs((int)pixels[i + c] - (int)reference[i + c]);
+			if (d > pixel_diff) pixel_diff = d;
+		}
+		if (pixel_diff > opt->tolerance) ++num_bad;
+		if (pixel_diff > max_diff) max_diff = pixel_diff;
+	}
+
+	double bad_fraction = (double)num_bad / (double)(opt->width * opt->height);
+	bool pass = bad_fraction <= opt->max_bad_fraction;
+	printf("headless: vs %s: %zu pixels off by more than %d (%.4f%%), max difference %d: %s\n",
+		opt->reference_png, num_bad, opt->tolerance, 100.0 * bad_fraction, max_diff, pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
+
+static void free_shader(ShaderProgram *shader) {
+	if (shader) {
+		glDeleteProgram(shader->getProgramHandle());
+		delete shader;
+	}
+}
+
+// a bad texture never made a GL texture
+static void free_texture(Texture *texture) {
+	if (texture) {
+		if (!texture->bad()) {
+			GLuint id = texture->id();
+			glDeleteTextures(1, &id);
+		}
+		delete texture;
+	}
+}
+
+// before the context goes
+static void free_programs(render_programs_t *programs) {
+	free_shader(programs->wave);
+	free_shader(programs->point);
+	free_shader(programs->grid);
+	free_shader(programs->tile);
+	free_shader(programs->wave_lod);
+	free_shader(programs->wave_reduce);
+	free_shader(programs->text);
+	free_texture(programs->font);
+	memset(programs, 0, sizeof(*programs));
+}
+
+int headless_run(const headless_options_t *opt) {
+	if (!platform_headless_create(opt->width, opt->height)) {
+		platform_headless_destroy();
+		return 1;
+	}
+
+	std::unordered_map<GLuint, std::string> bindings;
+	bindings[ATTRIB_POSITION] = "Position_VS_in";
+
+	render_programs_t programs = {};
+	programs.wave = new ShaderProgram("shaders/wave", bindings);
+	programs.point = new ShaderProgram("shaders/pointplot", bindings);
+	programs.grid = new ShaderProgram("shaders/grid", bindings);
+	programs.tile = new ShaderProgram("shaders/tile", bindings);
+	programs.wave_lod = new ShaderProgram("shaders/wave_lod", bindings);
+	if (programs.wave->is_bad() || programs.point->is_bad() || programs.grid->is_bad() || programs.tile->is_bad() || programs.wave_lod->is_bad()) {
+		printf("headless: loading the shaders failed.\n");
+		free_programs(&programs);
+		platform_headless_destroy();
+		return 1;
+	}
+	// without compute shaders the CPU reduces the columns, like in the editor
+	programs.wave_reduce = new ShaderProgram("shaders/wave_reduce", bindings);
+	if (programs.wave_reduce->is_bad()) {
+		printf("headless: no compute shaders, the column reduction runs on the CPU.\n");
+		free_shader(programs.wave_reduce);
+		programs.wave_reduce = NULL;
+	}
+	// no text if these don't load, like in the editor
+	programs.text = new ShaderProgram("shaders/text", bindings);
+	programs.font = new Texture("textures/dina_all.png", GL_NEAREST);
+	if (programs.text->is_bad() || programs.font->bad()) {
+		printf("headless: the text shader or the glyph atlas didn't load, no text.\n");
+		free_shader(programs.text);
+		free_texture(programs.font);
+		programs.text = NULL;
+		programs.font = NULL;
+	}
+
+	render_init();
+	render_resize(opt->width, opt->height);
+	gls_take_counts();
+
+	// a fixed scatter over the curve area, the same every run
+	std::vector<float> markers(2 * (size_t)opt->markers);
+	unsigned seed = 1;
+	for (size_t i = 0; i < markers.size(); i += 2) {
+		seed = seed * 1664525u + 1013904223u;
+		markers[i] = (float)(seed >> 8) / (float)(1 << 24);
+		seed = seed * 1664525u + 1013904223u;
+		markers[i + 1] = 2.8f * (float)(seed >> 8) / (float)(1 << 24) - 1.4f;
+	}
+
+	// frame times, glFinish makes every frame pay for its own rendering
+	render_curve_t curve;
+	float time = 0;
+	double total_ms = 0, min_ms = 1e9, max_ms = 0;
+	if (opt->zoom) {
+		render_zoom(opt->zoom, 0.5 * opt->width);
+	}
+	if (opt->capture_dir) {
+		capture_start(opt->capture_dir, 0);
+	}
+	for (int i = 0; i < opt->frames; ++i) {
+		perf_timer_t t;
+		if (opt->pan_px) {
+			render_pan(opt->pan_px);
+		}
+		else {
+			time += 0.006;
+		}
+		render_curve_at(time, &curve);
+		render_frame(&programs, &curve, time);
+		if (opt->markers > 0) {
+			render_markers(&programs, markers.data(), opt->markers);
+		}
+		capture_frame(opt->width, opt->height);
+		glFinish();
+		double ms = t.get_ms();
+		total_ms += ms;
+		if (ms < min_ms) min_ms = ms;
+		if (ms > max_ms) max_ms = ms;
+
+		gls_counts_t counts = gls_take_counts();
+		stats_add("frame ms", ms);
+		stats_add("gl binds issued", counts.issued);
+		stats_add("gl binds filtered", counts.filtered);
+		gpu_timer_end_frame();
+		stats_end_frame();
+	}
+	capture_stop();
+	if (opt->frames > 0) {
+		printf("headless: %d frames at %dx%d with %d extra markers, %.3f ms/frame (min %.3f, max %.3f)\n",
+			opt->frames, opt->width, opt->height, opt->markers, total_ms / opt->frames, min_ms, max_ms);
+		stats_report();
+	}
+
+	// the reduction the zoomed out wave is drawn from, over the timed frames' view
+	int result = 0;
+	if (programs.wave_reduce) {
+		double gpu_ms, cpu_ms;
+		double diff = render_lod_check(&programs, &gpu_ms, &cpu_ms);
+		bool pass = diff <= HEADLESS_LOD_TOLERANCE;
+		printf("headless: column reduction over %d columns: gpu %.3f ms, cpu reference %.3f ms, max difference %g: %s\n",
+			opt->width, gpu_ms, cpu_ms, diff, pass ? "PASS" : "FAIL");
+		if (!pass) result = 1;
+	}
+
+	// the regression frame, flipped to top-down rows for the png
+	render_view_reset();
+	render_curve_at(HEADLESS_REFERENCE_TIME, &curve);
+	render_frame(&programs, &curve, HEADLESS_REFERENCE_TIME);
+
+	size_t stride = (size_t)opt->width * 4;
+	std::vector<unsigned char> bottom_up(stride * opt->height), pixels(stride * opt->height);
+	platform_headless_read_pixels(bottom_up.data());
+	for (int y = 0; y < opt->height; ++y) {
+		memcpy(&pixels[y * stride], &bottom_up[(opt->height - 1 - y) * stride], stride);
+	}
+
+	if (opt->out_png) {
+		unsigned e = lodepng::encode(opt->out_png, pixels, opt->width, opt->height);
+		if (e) {
+			printf("headless: writing %s: %s\n", opt->out_png, lodepng_error_text(e));
+			result = 1;
+		}
+	}
+	if (opt->reference_png && compare_to_reference(opt, pixels)) {
+		result = 1;
+	}
+
+	free_programs(&programs);
+	platform_headless_destroy();
+	return result;
+}
+
+#ifndef _WIN32
+
+static void usage() {
+	printf("usage: wfedit_headless [-size WxH] [-frames N] [-markers N] [-pan PX] [-zoom N] [-capture DIR] [-out image.png] [-reference image.png] [-tolerance N]\n");
+}
+
+int main(int argc, char **argv) {
+	headless_options_t opt;
+	headless_default_options(&opt);
+
+	for (int i = 1; i < argc; ++i) {
+		bool has_value = i + 1 < argc;
+		if (!strcmp(argv[i], "-size") && has_value) {
+			if (sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2) { usage(); return 2; }
+		}
+		else if (!strcmp(argv[i], "-frames") && has_value) { opt.frames = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "-markers") && has_value) { opt.markers = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "-pan") && has_value) { opt.pan_px = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "-zoom") && has_value) { opt.zoom = atoi(argv[++i]); }
+		else if (!strcmp(argv[i], "-capture") && has_value) { opt.capture_dir = argv[++i]; }
+		else if (!strcmp(argv[i], "-out") && has_value) { opt.out_png = argv[++i]; }
+		else if (!strcmp(argv[i], "-reference") && has_value) { opt.reference_png = argv[++i]; }
+		else if (!strcmp(argv[i], "-tolerance") && has_value) { opt.tolerance = atoi(argv[++i]); }
+		else { usage(); return 2; }
+	}
+
+	return headless_run(&opt);
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+// renders the editor's passes into an offscreen framebuffer without a window (see platform.h): a timed
+// run of frames for frame-time numbers, then one fixed frame that's written out as a png and compared
+// against a reference image if one is given
+
+struct headless_options_t {
+	int width, height;
+	int frames;
+	int markers;				// extra markers scattered over the timed frames, 0 for the plain editor frame
+	int pan_px;					// if not 0 the timed frames hold the curve still and pan the view this much each
+	int zoom;					// zoom steps for the timed frames, negative is out (see render_zoom)
+	const char *capture_dir;	// the timed frames as a png sequence in here (see capture.h), NULL for none
+	const char *out_png;		// NULL to skip writing
+	const char *reference_png;	// NULL to skip the comparison
+	int tolerance;				// per channel
+	double max_bad_fraction;	// of the pixels, beyond the tolerance
+};
+
+void headless_default_options(headless_options_t *opt);
+
+// 0 if everything went through and the image matched the reference
+int headless_run(const headless_options_t *opt);
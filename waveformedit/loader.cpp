@@ -0,0 +1,264 @@
+#include "loader.h"
+
+#include <cstdio>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "shader.h"
+#include "texture.h"
+#include "timer.h"
+
+enum {
+	LOAD_SHADER,
+	LOAD_TEXTURE
+};
+
+// a request goes back and forth between the work queue (worker side) and the done queue (GL side) one
+// stage at a time. a texture takes four stages: header, map, decode, upload. a shader takes three: reading
+// the sources, kicking off the compile, and collecting the result once the driver is done with it
+struct load_request_t {
+	int type;
+	int stage;
+	std::atomic<int> status;
+	std::string name;
+
+	std::unordered_map<GLuint, std::string> bindings;
+	shader_sources_t sources;
+	ShaderProgram *shader;
+
+	GLint filter_param;
+	texture_load_t *texture_load;
+	Texture *texture;
+};
+
+static std::vector<std::thread> workers;
+static std::mutex queue_mutex;
+static std::condition_variable work_available;
+static std::deque<load_request_t*> work_queue, done_queue;
+static bool stopping = false;
+
+// only touched on the GL thread, the workers get the request pointers from the queues
+static std::vector<load_request_t*> requests;
+static std::vector<load_request_t*> linking;	// shaders the driver is still compiling
+static int num_pending = 0;
+
+static void run_worker_stage(load_request_t *r) {
+	if (r->type == LOAD_SHADER) {
+		ShaderProgram::read_sources(r->name, &r->sources);
+	}
+	else if (r->stage == 0) {
+		r->texture_load = texture_load_begin(r->name, r->filter_param);
+	}
+	else {
+		texture_load_decode(r->texture_load);
+	}
+	++r->stage;
+}
+
+// returns true if the request has more worker stages to go
+static bool run_gl_stage(load_request_t *r) {
+	if (r->type == LOAD_SHADER) {
+		r->shader = new ShaderProgram(r->name, &r->sources, r->bindings, true);
+		ShaderProgram::free_sources(&r->sources);
+		if (r->shader->is_linking()) {
+			linking.push_back(r);
+		}
+		else {
+			r->status = r->shader->is_bad() ? LOAD_FAILED : LOAD_READY;
+		}
+		return false;
+	}
+
+	if (r->stage == 1 && texture_load_map(r->texture_load)) {
+		++r->stage;
+		return true;
+	}
+	// the map failing skips straight to the end, which cleans up
+	r->texture = texture_load_end(r->texture_load);
+	r->texture_load = NULL;
+	r->status = (r->texture && !r->texture->bad()) ? LOAD_READY : LOAD_FAILED;
+	return false;
+}
+
+static void worker_proc() {
+	for (;;) {
+		load_request_t *r;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			work_available.wait(lock, [] { return stopping || !work_queue.empty(); });
+			if (stopping) {
+				return;
+			}
+			r = work_queue.front();
+			work_queue.pop_front();
+		}
+
+		run_worker_stage(r);
+
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		done_queue.push_back(r);
+	}
+}
+
+// the GL side and the object of a resource nobody is going to get. a bad texture never made a GL texture
+static void free_resource(load_request_t *r) {
+	if (r->shader) {
+		glDeleteProgram(r->shader->getProgramHandle());
+		delete r->shader;
+		r->shader = NULL;
+	}
+	if (r->texture) {
+		if (!r->texture->bad()) {
+			GLuint id = r->texture->id();
+			glDeleteTextures(1, &id);
+		}
+		delete r->texture;
+		r->texture = NULL;
+	}
+}
+
+void loader_start(int num_threads) {
+	if (num_threads <= 0) {
+		num_threads = (int)std::thread::hardware_concurrency() - 1;
+		if (num_threads < 1) num_threads = 1;
+	}
+	stopping = false;
+	for (int i = 0; i < num_threads; ++i) {
+		workers.push_back(std::thread(worker_proc));
+	}
+}
+
+void loader_stop() {
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (auto &t : workers) {
+		t.join();
+	}
+	workers.clear();
+
+	// the finished resources stay alive, whoever asked for them owns them now. nobody can get at the
+	// half-done ones any more, those go
+	for (auto r : requests) {
+		if (r->status == LOAD_PENDING) {
+			if (r->texture_load) {
+				r->texture = texture_load_end(r->texture_load);
+			}
+			free_resource(r);
+		}
+		ShaderProgram::free_sources(&r->sources);
+		delete r;
+	}
+	requests.clear();
+	linking.clear();
+	work_queue.clear();
+	done_queue.clear();
+	num_pending = 0;
+}
+
+static load_handle_t submit(load_request_t *r) {
+	r->stage = 0;
+	r->status = LOAD_PENDING;
+	r->shader = NULL;
+	r->texture_load = NULL;
+	r->texture = NULL;
+	for (int i = 0; i <= ComputeShader; ++i) r->sources.buf[i] = NULL;
+
+	requests.push_back(r);
+	++num_pending;
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		work_queue.push_back(r);
+	}
+	work_available.notify_one();
+	return (load_handle_t)requests.size() - 1;
+}
+
+load_handle_t loader_load_shader(const std::string &name_base, const std::unordered_map<GLuint, std::string> &bindattrib_loc_names_map) {
+	load_request_t *r = new load_request_t;
+	r->type = LOAD_SHADER;
+	r->name = name_base;
+	r->bindings = bindattrib_loc_names_map;
+	return submit(r);
+}
+
+load_handle_t loader_load_texture(const std::string &filename, GLint filter_param) {
+	load_request_t *r = new load_request_t;
+	r->type = LOAD_TEXTURE;
+	r->name = filename;
+	r->filter_param = filter_param;
+	return submit(r);
+}
+
+int loader_status(load_handle_t h) {
+	if (h < 0 || h >= (int)requests.size()) {
+		return LOAD_FAILED;
+	}
+	return requests[h]->status;
+}
+
+ShaderProgram *loader_shader(load_handle_t h) {
+	return loader_status(h) == LOAD_READY ? requests[h]->shader : NULL;
+}
+
+Texture *loader_texture(load_handle_t h) {
+	return loader_status(h) == LOAD_READY ? requests[h]->texture : NULL;
+}
+
+static void finish(load_request_t *r) {
+	if (r->status == LOAD_FAILED) {
+		printf("loader: loading %s failed.\n", r->name.c_str());
+		free_resource(r);
+	}
+	--num_pending;
+}
+
+int loader_poll(double budget_ms) {
+	perf_timer_t budget;
+
+	// programs the driver has finished with. this never blocks with parallel shader compile, without it
+	// these have at least had a frame's head start
+	for (size_t i = 0; i < linking.size(); ) {
+		load_request_t *r = linking[i];
+		if (!r->shader->link_ready()) {
+			++i;
+			continue;
+		}
+		r->shader->finish_link();
+		r->status = r->shader->is_bad() ? LOAD_FAILED : LOAD_READY;
+		finish(r);
+		linking.erase(linking.begin() + i);
+	}
+
+	// kicking off a compile is cheap, so the shaders that are waiting normally all go to the driver in the same poll
+	do {
+		load_request_t *r;
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			if (done_queue.empty()) {
+				break;
+			}
+			r = done_queue.front();
+			done_queue.pop_front();
+		}
+
+		if (run_gl_stage(r)) {
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				work_queue.push_back(r);
+			}
+			work_available.notify_one();
+		}
+		else if (r->status != LOAD_PENDING) {
+			finish(r);
+		}
+	} while (budget.get_ms() < budget_ms);
+
+	return num_pending;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "glext_loader.h"
+
+class ShaderProgram;
+class Texture;
+
+// asynchronous resource loading. file i/o and png decoding run on a pool of worker threads, everything
+// that needs the GL context is queued back to the GL thread and run from loader_poll. requests are
+// identified by handles that stay valid until loader_stop.
+
+typedef int load_handle_t;
+
+enum {
+	LOAD_PENDING = 0,
+	LOAD_READY = 1,
+	LOAD_FAILED = 2
+};
+
+// num_threads 0 means one less than the hardware threads, at least one
+void loader_start(int num_threads);
+// waits for the workers to finish what they're doing, unfinished requests are dropped. the GL context
+// has to be current still, the half-done ones have GL objects to free
+void loader_stop();
+
+load_handle_t loader_load_shader(const std::string &name_base, const std::unordered_map<GLuint, std::string> &bindattrib_loc_names_map);
+load_handle_t loader_load_texture(const std::string &filename, GLint filter_param);
+
+int loader_status(load_handle_t h);
+// NULL unless the status is LOAD_READY
+ShaderProgram *loader_shader(load_handle_t h);
+Texture *loader_texture(load_handle_t h);
+
+// call on the GL thread, once per frame. runs the GL side of finished requests until budget_ms is used up
+// (at least one gets done per call), returns the number of requests still pending
+int loader_poll(double budget_ms);
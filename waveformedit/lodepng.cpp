@@ -123,6 +123,167 @@ Example: if(!uivector_resizev(&frequencies_ll, 286, 0)) ERROR_BREAK(83);
   return;\
 }
 
+/*
+SIMD code paths for x86. Everything that uses more than SSE2 is selected at runtime based on cpuid,
+so the same binary still runs on older CPUs. Define LODEPNG_NO_SIMD to compile the scalar code only.
+*/
+#if !defined(LODEPNG_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define LODEPNG_X86_SIMD
+#endif
+
+#ifdef LODEPNG_X86_SIMD
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+/*MSVC lets every function use every intrinsic, gcc and clang need the instruction set named per function*/
+#if defined(__GNUC__)
+#define LODEPNG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LODEPNG_TARGET(isa)
+#endif
+
+#define CPU_FEATURE_SSE2 1u
+#define CPU_FEATURE_SSSE3 2u
+#define CPU_FEATURE_SSE41 4u
+#define CPU_FEATURE_PCLMUL 8u
+#define CPU_FEATURE_AVX2 16u
+
+static void lodepng_cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	regs[0] = (unsigned)r[0]; regs[1] = (unsigned)r[1]; regs[2] = (unsigned)r[2]; regs[3] = (unsigned)r[3];
+#else
+	if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+	{
+		regs[0] = regs[1] = regs[2] = regs[3] = 0;
+	}
+#endif
+}
+
+/*the OS has to save the ymm registers on context switches, or AVX can't be used even if the CPU has it*/
+static unsigned lodepng_os_saves_ymm(void)
+{
+#ifdef _MSC_VER
+	return (_xgetbv(0) & 6) == 6;
+#else
+	unsigned eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (eax & 6) == 6;
+#endif
+}
+
+static unsigned lodepng_detect_cpu_features(void)
+{
+	unsigned regs[4], features = 0;
+
+	lodepng_cpuid(0, 0, regs);
+	if (regs[0] < 1) return 0;
+	lodepng_cpuid(1, 0, regs);
+	if (regs[3] & (1u << 26)) features |= CPU_FEATURE_SSE2;
+	if (regs[2] & (1u << 9)) features |= CPU_FEATURE_SSSE3;
+	if (regs[2] & (1u << 19)) features |= CPU_FEATURE_SSE41;
+	if (regs[2] & (1u << 1)) features |= CPU_FEATURE_PCLMUL;
+
+	/*AVX2: needs OSXSAVE and AVX in leaf 1, the OS enabling ymm state, and the bit in leaf 7*/
+	if ((regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) && lodepng_os_saves_ymm())
+	{
+		lodepng_cpuid(0, 0, regs);
+		if (regs[0] >= 7)
+		{
+			lodepng_cpuid(7, 0, regs);
+			if (regs[1] & (1u << 5)) features |= CPU_FEATURE_AVX2;
+		}
+	}
+	return features;
+}
+
+/*detection runs once. threads racing on the first call all store the same value, so no locking is needed*/
+static unsigned lodepng_cpu_features(void)
+{
+	static volatile int features = -1;
+	if (features < 0) features = (int)lodepng_detect_cpu_features();
+	return (unsigned)features;
+}
+#endif /*LODEPNG_X86_SIMD*/
+
+/*
+Worker threads for the encoder, used when num_threads in LodePNGCompressSettings asks for them. Needs C++11
+std::thread, define LODEPNG_NO_THREADS to always encode on the calling thread.
+*/
+#ifdef LODEPNG_COMPILE_ENCODER
+#if !defined(LODEPNG_NO_THREADS) && defined(__cplusplus) && (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900))
+#define LODEPNG_THREADS
+#endif
+
+#ifdef LODEPNG_THREADS
+#include <atomic>
+#include <thread>
+#endif
+
+#define LODEPNG_MAX_THREADS 64
+
+typedef void (*LodePNGJob)(void* context, size_t index);
+
+/*the thread count num_threads stands for, 0 is one per hardware thread*/
+static unsigned lodepng_num_threads(unsigned num_threads)
+{
+#ifdef LODEPNG_THREADS
+	if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+#endif
+	if (num_threads == 0) num_threads = 1;
+	if (num_threads > LODEPNG_MAX_THREADS) num_threads = LODEPNG_MAX_THREADS;
+	return num_threads;
+}
+
+#ifdef LODEPNG_THREADS
+static void lodepng_job_worker(LodePNGJob job, void* context, size_t numjobs, std::atomic<size_t>* next)
+{
+	size_t i;
+	while ((i = (*next)++) < numjobs) job(context, i);
+}
+#endif /*LODEPNG_THREADS*/
+
+/*
+Calls job(context, i) for every i in [0, numjobs) on up to numthreads threads, the calling thread being one of
+them, and returns when all are done. Jobs are handed out in order from a shared counter, so uneven jobs still
+balance out. If a thread can't be started, the ones that did start do its share.
+*/
+static void lodepng_run_jobs(LodePNGJob job, void* context, size_t numjobs, unsigned numthreads)
+{
+#ifdef LODEPNG_THREADS
+	std::thread threads[LODEPNG_MAX_THREADS - 1];
+	std::atomic<size_t> next(0);
+	unsigned i, started = 0;
+	if (numthreads > numjobs) numthreads = (unsigned)numjobs;
+	if (numthreads > LODEPNG_MAX_THREADS) numthreads = LODEPNG_MAX_THREADS;
+	for (i = 1; i < numthreads; ++i)
+	{
+		try
+		{
+			threads[started] = std::thread(lodepng_job_worker, job, context, numjobs, &next);
+			++started;
+		}
+		catch (...)
+		{
+			break;
+		}
+	}
+	lodepng_job_worker(job, context, numjobs, &next);
+	for (i = 0; i != started; ++i) threads[i].join();
+#else /*LODEPNG_THREADS*/
+	size_t i;
+	(void)numthreads;
+	for (i = 0; i != numjobs; ++i) job(context, i);
+#endif /*LODEPNG_THREADS*/
+}
+#endif /*LODEPNG_COMPILE_ENCODER*/
+
 /*
 About uivector, ucvector and string:
 -All of them wrap dynamic arrays or text strings in a similar way.
@@ -234,7 +395,7 @@ static unsigned ucvector_resize(ucvector* p, size_t size)
 	return 1; /*success*/
 }
 
-#ifdef LODEPNG_COMPILE_PNG
+#if defined(LODEPNG_COMPILE_PNG) || defined(LODEPNG_COMPILE_ENCODER)
 
 static void ucvector_cleanup(void* p)
 {
@@ -248,7 +409,7 @@ static void ucvector_init(ucvector* p)
 	p->data = NULL;
 	p->size = p->allocsize = 0;
 }
-#endif /*LODEPNG_COMPILE_PNG*/
+#endif /*defined(LODEPNG_COMPILE_PNG) || defined(LODEPNG_COMPILE_ENCODER)*/
 
 #ifdef LODEPNG_COMPILE_ZLIB
 /*you can both convert from vector to buffer&size and vica versa. If you use
@@ -416,6 +577,20 @@ unsigned lodepng_save_file(const unsigned char* buffer, size_t buffersize, const
 /* ////////////////////////////////////////////////////////////////////////// */
 
 #ifdef LODEPNG_COMPILE_ZLIB
+static unsigned long long readLE64(const unsigned char* p)
+{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	unsigned long long result;
+	memcpy(&result, p, 8); /*little endian already, compiles to a single load*/
+	return result;
+#else
+	return (unsigned long long)p[0] | ((unsigned long long)p[1] << 8)
+		| ((unsigned long long)p[2] << 16) | ((unsigned long long)p[3] << 24)
+		| ((unsigned long long)p[4] << 32) | ((unsigned long long)p[5] << 40)
+		| ((unsigned long long)p[6] << 48) | ((unsigned long long)p[7] << 56);
+#endif
+}
+
 #ifdef LODEPNG_COMPILE_ENCODER
 /*TODO: this ignores potential out of memory errors*/
 #define addBitToStream(/*size_t**/ bitpointer, /*ucvector**/ bitstream, /*unsigned char*/ bit)\
@@ -442,23 +617,89 @@ static void addBitsToStreamReversed(size_t* bitpointer, ucvector* bitstream, uns
 
 #ifdef LODEPNG_COMPILE_DECODER
 
-#define READBIT(bitpointer, bitstream) ((bitstream[bitpointer >> 3] >> (bitpointer & 0x7)) & (unsigned char)1)
-
-static unsigned char readBitFromStream(size_t* bitpointer, const unsigned char* bitstream)
+/*
+Bit reader for the inflater. Deflate packs bits lsb first, so up to 64 upcoming bits are kept in an
+integer where the next bit to read is the lowest one. Refilling loads 8 bytes at once and only
+advances the byte pointer by the whole bytes that fit; the partial byte gets loaded again next time.
+Reading past the end of the input yields zero bits, the callers detect that by comparing bp with bitsize.
+*/
+typedef struct LodePNGBitReader
 {
-	unsigned char result = (unsigned char)(READBIT(*bitpointer, bitstream));
-	++(*bitpointer);
-	return result;
-}
+	const unsigned char* data;
+	size_t size; /*size of data in bytes*/
+	size_t bitsize; /*size of data in bits, end of valid bp values*/
+	size_t bp; /*bits consumed so far*/
+	size_t next; /*next byte of data to load into buffer*/
+	unsigned long long buffer; /*upcoming bits, the next one is the lsb*/
+	unsigned bits; /*amount of valid bits in buffer*/
+} LodePNGBitReader;
 
-static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bitstream, size_t nbits)
+/*after this at least 56 bits are in the buffer*/
+static void LodePNGBitReader_refill(LodePNGBitReader* reader)
 {
-	unsigned result = 0, i;
-	for (i = 0; i != nbits; ++i)
+	if (reader->next + 8 <= reader->size)
 	{
-		result += ((unsigned)READBIT(*bitpointer, bitstream)) << i;
-		++(*bitpointer);
+		reader->buffer |= readLE64(reader->data + reader->next) << reader->bits;
+		reader->next += (63 - reader->bits) >> 3;
+		reader->bits |= 56;
+	}
+	else
+	{
+		/*near the end, byte by byte, and zeros after it*/
+		while (reader->bits <= 56)
+		{
+			unsigned long long b = reader->next < reader->size ? reader->data[reader->next] : 0;
+			reader->buffer |= b << reader->bits;
+			++reader->next;
+			reader->bits += 8;
+		}
 	}
+}
+
+/*continue reading at the given bit position, used to get back in sync after stored blocks*/
+static void LodePNGBitReader_seek(LodePNGBitReader* reader, size_t bitpos)
+{
+	reader->bp = bitpos;
+	reader->next = bitpos >> 3;
+	reader->buffer = 0;
+	reader->bits = 0;
+	LodePNGBitReader_refill(reader);
+	reader->buffer >>= (bitpos & 7);
+	reader->bits -= (unsigned)(bitpos & 7);
+}
+
+static void LodePNGBitReader_init(LodePNGBitReader* reader, const unsigned char* data, size_t size)
+{
+	reader->data = data;
+	reader->size = size;
+	reader->bitsize = size * 8;
+	LodePNGBitReader_seek(reader, 0);
+}
+
+/*make sure at least nbits (at most 56) can be peeked*/
+static void ensureBits(LodePNGBitReader* reader, unsigned nbits)
+{
+	if (reader->bits < nbits) LodePNGBitReader_refill(reader);
+}
+
+/*nbits must already be in the buffer, see ensureBits*/
+static unsigned peekBits(const LodePNGBitReader* reader, unsigned nbits)
+{
+	return (unsigned)(reader->buffer & ((1ull << nbits) - 1u));
+}
+
+static void advanceBits(LodePNGBitReader* reader, unsigned nbits)
+{
+	reader->buffer >>= nbits;
+	reader->bits -= nbits;
+	reader->bp += nbits;
+}
+
+/*nbits must already be in the buffer, see ensureBits*/
+static unsigned readBits(LodePNGBitReader* reader, unsigned nbits)
+{
+	unsigned result = peekBits(reader, nbits);
+	advanceBits(reader, nbits);
 	return result;
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
@@ -508,11 +749,12 @@ Huffman tree struct, containing multiple representations of the tree
 */
 typedef struct HuffmanTree
 {
-	unsigned* tree2d;
 	unsigned* tree1d;
 	unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
 	unsigned maxbitlen; /*maximum number of bits a single code can get*/
 	unsigned numcodes; /*number of symbols in the alphabet = number of codes*/
+	unsigned char* table_len; /*the lookup table used by the decoder: code length, or the secondary table's index bits*/
+	unsigned short* table_value; /*the symbol, or where the secondary table starts*/
 } HuffmanTree;
 
 /*function used for debug purposes to draw the tree in ascii art with C++*/
@@ -530,74 +772,154 @@ std::cout << std::endl;
 
 static void HuffmanTree_init(HuffmanTree* tree)
 {
-	tree->tree2d = 0;
 	tree->tree1d = 0;
 	tree->lengths = 0;
+	tree->table_len = 0;
+	tree->table_value = 0;
 }
 
 static void HuffmanTree_cleanup(HuffmanTree* tree)
 {
-	lodepng_free(tree->tree2d);
 	lodepng_free(tree->tree1d);
 	lodepng_free(tree->lengths);
+	lodepng_free(tree->table_len);
+	lodepng_free(tree->table_value);
+}
+
+/*
+The decoder looks symbols up in a table indexed by the next FIRSTBITS bits of input. Codes of at most
+FIRSTBITS bits are repeated over every entry they are a prefix of. For longer codes the entry points to
+a secondary table indexed by the remaining bits, sized for the longest code sharing that prefix.
+9 bits gives a 512 entry first level table which covers the vast majority of symbols in real images.
+*/
+#define FIRSTBITS 9u
+/*table_value of entries that no code maps to*/
+#define INVALIDSYMBOL 65535u
+
+/*reverse the order of the lowest num bits of bits*/
+static unsigned reverseBits(unsigned bits, unsigned num)
+{
+	unsigned i, result = 0;
+	for (i = 0; i < num; ++i) result |= ((bits >> (num - i - 1u)) & 1u) << i;
+	return result;
 }
 
-/*the tree representation used by the decoder. return value is error*/
-static unsigned HuffmanTree_make2DTree(HuffmanTree* tree)
+/*make the lookup tables used by huffmanDecodeSymbol from tree1d and lengths. return value is error*/
+static unsigned HuffmanTree_makeTable(HuffmanTree* tree)
 {
-	unsigned nodefilled = 0; /*up to which node it is filled*/
-	unsigned treepos = 0; /*position in the tree (1 of the numcodes columns)*/
-	unsigned n, i;
+	static const unsigned headsize = 1u << FIRSTBITS;
+	static const unsigned mask = (1u << FIRSTBITS) - 1u;
+	size_t i, pointer, size; /*total table size*/
+	unsigned long kraft = 0;
+	unsigned* maxlens = (unsigned*)lodepng_malloc(headsize * sizeof(unsigned));
+	if (!maxlens) return 83; /*alloc fail*/
+
+	/*oversubscribed, see comment in lodepng_error_text*/
+	for (i = 0; i < tree->numcodes; ++i)
+	{
+		if (tree->lengths[i] > 15) { lodepng_free(maxlens); return 55; }
+		if (tree->lengths[i]) kraft += 1ul << (15 - tree->lengths[i]);
+	}
+	if (kraft > (1ul << 15)) { lodepng_free(maxlens); return 55; }
 
-	tree->tree2d = (unsigned*)lodepng_malloc(tree->numcodes * 2 * sizeof(unsigned));
-	if (!tree->tree2d) return 83; /*alloc fail*/
+	/*compute maxlens: max total bit length of symbols sharing prefix in the first table*/
+	memset(maxlens, 0, headsize * sizeof(*maxlens));
+	for (i = 0; i < tree->numcodes; ++i)
+	{
+		unsigned symbol = tree->tree1d[i];
+		unsigned l = tree->lengths[i];
+		unsigned index;
+		if (l <= FIRSTBITS) continue; /*symbols that fit in first table don't increase secondary table size*/
+		/*get the FIRSTBITS MSBs, the MSBs of the symbol are encoded first. See later comment about the reversing*/
+		index = reverseBits(symbol >> (l - FIRSTBITS), FIRSTBITS);
+		if (l > maxlens[index]) maxlens[index] = l;
+	}
+	/*compute total table size: size of first table plus all secondary tables for symbols longer than FIRSTBITS*/
+	size = headsize;
+	for (i = 0; i < headsize; ++i)
+	{
+		unsigned l = maxlens[i];
+		if (l > FIRSTBITS) size += (1u << (l - FIRSTBITS));
+	}
+	tree->table_len = (unsigned char*)lodepng_malloc(size * sizeof(*tree->table_len));
+	tree->table_value = (unsigned short*)lodepng_malloc(size * sizeof(*tree->table_value));
+	if (!tree->table_len || !tree->table_value)
+	{
+		lodepng_free(maxlens);
+		/*freeing tree->table values is done at a higher scope*/
+		return 83; /*alloc fail*/
+	}
+	/*initialize with an invalid length to indicate unused entries*/
+	for (i = 0; i < size; ++i) tree->table_len[i] = 16;
 
-								  /*
-								  convert tree1d[] to tree2d[][]. In the 2D array, a value of 32767 means
-								  uninited, a value >= numcodes is an address to another bit, a value < numcodes
-								  is a code. The 2 rows are the 2 possible bit values (0 or 1), there are as
-								  many columns as codes - 1.
-								  A good huffman tree has N * 2 - 1 nodes, of which N - 1 are internal nodes.
-								  Here, the internal nodes are stored (what their 0 and 1 option point to).
-								  There is only memory for such good tree currently, if there are more nodes
-								  (due to too long length codes), error 55 will happen
-								  */
-	for (n = 0; n < tree->numcodes * 2; ++n)
+	/*fill in the first table for long symbols: max prefix size and pointer to secondary tables*/
+	pointer = headsize;
+	for (i = 0; i < headsize; ++i)
 	{
-		tree->tree2d[n] = 32767; /*32767 here means the tree2d isn't filled there yet*/
+		unsigned l = maxlens[i];
+		if (l <= FIRSTBITS) continue;
+		tree->table_len[i] = l;
+		tree->table_value[i] = (unsigned short)pointer;
+		pointer += (1u << (l - FIRSTBITS));
 	}
+	lodepng_free(maxlens);
 
-	for (n = 0; n < tree->numcodes; ++n) /*the codes*/
+	/*fill in the first table for short symbols, or secondary table for long symbols*/
+	for (i = 0; i < tree->numcodes; ++i)
 	{
-		for (i = 0; i != tree->lengths[n]; ++i) /*the bits for this code*/
+		unsigned l = tree->lengths[i];
+		unsigned symbol, reverse;
+		if (l == 0) continue;
+		symbol = tree->tree1d[i]; /*the huffman bit pattern. i itself is the value*/
+		/*reverse bits, because the huffman bits are given in MSB first order but the bit reader reads LSB first*/
+		reverse = reverseBits(symbol, l);
+
+		if (l <= FIRSTBITS)
 		{
-			unsigned char bit = (unsigned char)((tree->tree1d[n] >> (tree->lengths[n] - i - 1)) & 1);
-			/*oversubscribed, see comment in lodepng_error_text*/
-			if (treepos > 2147483647 || treepos + 2 > tree->numcodes) return 55;
-			if (tree->tree2d[2 * treepos + bit] == 32767) /*not yet filled in*/
+			/*short symbol, fully in first table, replicated num times if l < FIRSTBITS*/
+			unsigned num = 1u << (FIRSTBITS - l);
+			unsigned j;
+			for (j = 0; j < num; ++j)
 			{
-				if (i + 1 == tree->lengths[n]) /*last bit*/
-				{
-					tree->tree2d[2 * treepos + bit] = n; /*put the current code in it*/
-					treepos = 0;
-				}
-				else
-				{
-					/*put address of the next step in here, first that address has to be found of course
-					(it's just nodefilled + 1)...*/
-					++nodefilled;
-					/*addresses encoded with numcodes added to it*/
-					tree->tree2d[2 * treepos + bit] = nodefilled + tree->numcodes;
-					treepos = nodefilled;
-				}
+				/*bit reader will read the l bits of symbol first, the remaining FIRSTBITS - l bits go to the MSB's*/
+				unsigned index = reverse | (j << l);
+				tree->table_len[index] = l;
+				tree->table_value[index] = (unsigned short)i;
+			}
+		}
+		else
+		{
+			/*long symbol, shares prefix with other long symbols in first lookup table, needs second lookup*/
+			/*the FIRSTBITS MSBs of the symbol are the first table index*/
+			unsigned index = reverse & mask;
+			unsigned maxlen = tree->table_len[index];
+			/*log2 of secondary table length, should be >= l - FIRSTBITS*/
+			unsigned tablelen = maxlen - FIRSTBITS;
+			unsigned start = tree->table_value[index]; /*starting index in secondary table*/
+			unsigned num = 1u << (tablelen - (l - FIRSTBITS)); /*amount of entries of this symbol in secondary table*/
+			unsigned j;
+			for (j = 0; j < num; ++j)
+			{
+				unsigned reverse2 = reverse >> FIRSTBITS; /* l - FIRSTBITS bits */
+				unsigned index2 = start + (reverse2 | (j << (l - FIRSTBITS)));
+				tree->table_len[index2] = l;
+				tree->table_value[index2] = (unsigned short)i;
 			}
-			else treepos = tree->tree2d[2 * treepos + bit] - tree->numcodes;
 		}
 	}
 
-	for (n = 0; n < tree->numcodes * 2; ++n)
+	/*
+	An incomplete tree is valid (deflate allows e.g. a single distance code), but the bit patterns no code
+	maps to must never be hit. They decode to an invalid symbol with a length that still advances the reader,
+	the callers of huffmanDecodeSymbol turn that into an error.
+	*/
+	for (i = 0; i < size; ++i)
 	{
-		if (tree->tree2d[n] == 32767) tree->tree2d[n] = 0; /*remove possible remaining 32767's*/
+		if (tree->table_len[i] == 16)
+		{
+			tree->table_len[i] = (i < headsize) ? 1 : (FIRSTBITS + 1);
+			tree->table_value[i] = INVALIDSYMBOL;
+		}
 	}
 
 	return 0;
@@ -644,7 +966,7 @@ static unsigned HuffmanTree_makeFromLengths2(HuffmanTree* tree)
 	uivector_cleanup(&blcount);
 	uivector_cleanup(&nextcode);
 
-	if (!error) return HuffmanTree_make2DTree(tree);
+	if (!error) return HuffmanTree_makeTable(tree);
 	else return error;
 }
 
@@ -941,26 +1263,28 @@ static unsigned generateFixedDistanceTree(HuffmanTree* tree)
 #ifdef LODEPNG_COMPILE_DECODER
 
 /*
-returns the code, or (unsigned)(-1) if error happened
-inbitlength is the length of the complete buffer, in bits (so its byte length times 8)
+returns the code, or INVALIDSYMBOL if the bits don't form a code of this tree. The caller must have
+made at least 15 bits available with ensureBits. Running past the end of the input is not detected
+here, that shows up as reader->bp > reader->bitsize afterwards.
 */
-static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
-	const HuffmanTree* codetree, size_t inbitlength)
+static unsigned huffmanDecodeSymbol(LodePNGBitReader* reader, const HuffmanTree* codetree)
 {
-	unsigned treepos = 0, ct;
-	for (;;)
+	unsigned code = peekBits(reader, FIRSTBITS);
+	unsigned l = codetree->table_len[code];
+	unsigned value = codetree->table_value[code];
+	if (l <= FIRSTBITS)
 	{
-		if (*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
-													   /*
-													   decode the symbol from the tree. The "readBitFromStream" code is inlined in
-													   the expression below because this is the biggest bottleneck while decoding
-													   */
-		ct = codetree->tree2d[(treepos << 1) + READBIT(*bp, in)];
-		++(*bp);
-		if (ct < codetree->numcodes) return ct; /*the symbol is decoded, return it*/
-		else treepos = ct - codetree->numcodes; /*symbol not yet decoded, instead move tree position*/
-
-		if (treepos >= codetree->numcodes) return (unsigned)(-1); /*error: it appeared outside the codetree*/
+		advanceBits(reader, l);
+		return value;
+	}
+	else
+	{
+		/*long code: the first level entry holds where its secondary table starts and how many bits index it*/
+		unsigned index2;
+		advanceBits(reader, FIRSTBITS);
+		index2 = value + peekBits(reader, l - FIRSTBITS);
+		advanceBits(reader, codetree->table_len[index2] - FIRSTBITS);
+		return codetree->table_value[index2];
 	}
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
@@ -981,12 +1305,11 @@ static void getTreeInflateFixed(HuffmanTree* tree_ll, HuffmanTree* tree_d)
 
 /*get the tree of a deflated block with dynamic tree, the tree itself is also Huffman compressed with a known tree*/
 static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
-	const unsigned char* in, size_t* bp, size_t inlength)
+	LodePNGBitReader* reader)
 {
 	/*make sure that length values that aren't filled in will be 0, or a wrong tree will be generated*/
 	unsigned error = 0;
 	unsigned n, HLIT, HDIST, HCLEN, i;
-	size_t inbitlength = inlength * 8;
 
 	/*see comments in deflateDynamic for explanation of the context and these variables, it is analogous*/
 	unsigned* bitlen_ll = 0; /*lit,len code lengths*/
@@ -995,16 +1318,17 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 	unsigned* bitlen_cl = 0;
 	HuffmanTree tree_cl; /*the code tree for code length codes (the huffman tree for compressed huffman trees)*/
 
-	if ((*bp) + 14 > (inlength << 3)) return 49; /*error: the bit pointer is or will go past the memory*/
+	if (reader->bp + 14 > reader->bitsize) return 49; /*error: the bit pointer is or will go past the memory*/
 
-												 /*number of literal/length codes + 257. Unlike the spec, the value 257 is added to it here already*/
-	HLIT = readBitsFromStream(bp, in, 5) + 257;
+	ensureBits(reader, 14);
+	/*number of literal/length codes + 257. Unlike the spec, the value 257 is added to it here already*/
+	HLIT = readBits(reader, 5) + 257;
 	/*number of distance codes. Unlike the spec, the value 1 is added to it here already*/
-	HDIST = readBitsFromStream(bp, in, 5) + 1;
+	HDIST = readBits(reader, 5) + 1;
 	/*number of code length codes. Unlike the spec, the value 4 is added to it here already*/
-	HCLEN = readBitsFromStream(bp, in, 4) + 4;
+	HCLEN = readBits(reader, 4) + 4;
 
-	if ((*bp) + HCLEN * 3 > (inlength << 3)) return 50; /*error: the bit pointer is or will go past the memory*/
+	if (reader->bp + HCLEN * 3 > reader->bitsize) return 50; /*error: the bit pointer is or will go past the memory*/
 
 	HuffmanTree_init(&tree_cl);
 
@@ -1017,7 +1341,8 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 
 		for (i = 0; i != NUM_CODE_LENGTH_CODES; ++i)
 		{
-			if (i < HCLEN) bitlen_cl[CLCL_ORDER[i]] = readBitsFromStream(bp, in, 3);
+			ensureBits(reader, 3);
+			if (i < HCLEN) bitlen_cl[CLCL_ORDER[i]] = readBits(reader, 3);
 			else bitlen_cl[CLCL_ORDER[i]] = 0; /*if not, it must stay 0*/
 		}
 
@@ -1035,7 +1360,9 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 		i = 0;
 		while (i < HLIT + HDIST)
 		{
-			unsigned code = huffmanDecodeSymbol(in, bp, &tree_cl, inbitlength);
+			unsigned code;
+			ensureBits(reader, 22); /*up to 15 bits for the code and 7 for the repeat length*/
+			code = huffmanDecodeSymbol(reader, &tree_cl);
 			if (code <= 15) /*a length code*/
 			{
 				if (i < HLIT) bitlen_ll[i] = code;
@@ -1049,8 +1376,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 
 				if (i == 0) ERROR_BREAK(54); /*can't repeat previous if i is 0*/
 
-				if ((*bp + 2) > inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
-				replength += readBitsFromStream(bp, in, 2);
+				replength += readBits(reader, 2);
 
 				if (i < HLIT + 1) value = bitlen_ll[i - 1];
 				else value = bitlen_d[i - HLIT - 1];
@@ -1066,8 +1392,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 			else if (code == 17) /*repeat "0" 3-10 times*/
 			{
 				unsigned replength = 3; /*read in the bits that indicate repeat length*/
-				if ((*bp + 3) > inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
-				replength += readBitsFromStream(bp, in, 3);
+				replength += readBits(reader, 3);
 
 				/*repeat this value in the next lengths*/
 				for (n = 0; n < replength; ++n)
@@ -1082,8 +1407,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 			else if (code == 18) /*repeat "0" 11-138 times*/
 			{
 				unsigned replength = 11; /*read in the bits that indicate repeat length*/
-				if ((*bp + 7) > inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
-				replength += readBitsFromStream(bp, in, 7);
+				replength += readBits(reader, 7);
 
 				/*repeat this value in the next lengths*/
 				for (n = 0; n < replength; ++n)
@@ -1095,17 +1419,14 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 					++i;
 				}
 			}
-			else /*if(code == (unsigned)(-1))*/ /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+			else /*if(code == INVALIDSYMBOL)*/
 			{
-				if (code == (unsigned)(-1))
-				{
-					/*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
-					(10=no endcode, 11=wrong jump outside of tree)*/
-					error = (*bp) > inbitlength ? 10 : 11;
-				}
-				else error = 16; /*unexisting code, this can never happen*/
+				/*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
+				(10=no endcode, 11=wrong jump outside of tree)*/
+				error = reader->bp > reader->bitsize ? 10 : 11;
 				break;
 			}
+			if (reader->bp > reader->bitsize) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
 		}
 		if (error) break;
 
@@ -1128,24 +1449,26 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 }
 
 /*inflate a block with dynamic of fixed Huffman tree*/
-static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size_t* bp,
-	size_t* pos, size_t inlength, unsigned btype)
+static unsigned inflateHuffmanBlock(ucvector* out, LodePNGBitReader* reader,
+	size_t* pos, unsigned btype)
 {
 	unsigned error = 0;
 	HuffmanTree tree_ll; /*the huffman tree for literal and length codes*/
 	HuffmanTree tree_d; /*the huffman tree for distance codes*/
-	size_t inbitlength = inlength * 8;
 
 	HuffmanTree_init(&tree_ll);
 	HuffmanTree_init(&tree_d);
 
 	if (btype == 1) getTreeInflateFixed(&tree_ll, &tree_d);
-	else if (btype == 2) error = getTreeInflateDynamic(&tree_ll, &tree_d, in, bp, inlength);
+	else if (btype == 2) error = getTreeInflateDynamic(&tree_ll, &tree_d, reader);
 
 	while (!error) /*decode all symbols until end reached, breaks at end code*/
 	{
 		/*code_ll is literal, length or end code*/
-		unsigned code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
+		unsigned code_ll;
+		/*one refill covers a whole length/distance pair: 15 + 5 + 15 + 13 bits*/
+		ensureBits(reader, 48);
+		code_ll = huffmanDecodeSymbol(reader, &tree_ll);
 		if (code_ll <= 255) /*literal symbol*/
 		{
 			/*ucvector_push_back would do the same, but for some reason the two lines below run 10% faster*/
@@ -1164,18 +1487,17 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
 			/*part 2: get extra bits and add the value of that to length*/
 			numextrabits_l = LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX];
-			if ((*bp + numextrabits_l) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-			length += readBitsFromStream(bp, in, numextrabits_l);
+			length += readBits(reader, numextrabits_l);
 
 			/*part 3: get distance code*/
-			code_d = huffmanDecodeSymbol(in, bp, &tree_d, inbitlength);
+			code_d = huffmanDecodeSymbol(reader, &tree_d);
 			if (code_d > 29)
 			{
-				if (code_ll == (unsigned)(-1)) /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+				if (code_d == INVALIDSYMBOL)
 				{
 					/*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
 					(10=no endcode, 11=wrong jump outside of tree)*/
-					error = (*bp) > inlength * 8 ? 10 : 11;
+					error = reader->bp > reader->bitsize ? 10 : 11;
 				}
 				else error = 18; /*error: invalid distance code (30-31 are never used)*/
 				break;
@@ -1184,8 +1506,9 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
 			/*part 4: get extra bits from distance*/
 			numextrabits_d = DISTANCEEXTRA[code_d];
-			if ((*bp + numextrabits_d) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-			distance += readBitsFromStream(bp, in, numextrabits_d);
+			distance += readBits(reader, numextrabits_d);
+
+			if (reader->bp > reader->bitsize) ERROR_BREAK(51); /*error, bit pointer jumped past memory*/
 
 			/*part 5: fill in all the out[n] values based on the length and dist*/
 			start = (*pos);
@@ -1194,9 +1517,15 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
 			if (!ucvector_resize(out, (*pos) + length)) ERROR_BREAK(83 /*alloc fail*/);
 			if (distance < length) {
-				for (forward = 0; forward < length; ++forward)
+				/*overlapping: everything from backward on repeats with period distance, so copy the already
+				written part of the run forward, doubling the chunk size every time*/
+				for (forward = 0; forward < length;)
 				{
-					out->data[(*pos)++] = out->data[backward++];
+					size_t chunk = (*pos) - backward;
+					if (chunk > length - forward) chunk = length - forward;
+					memcpy(out->data + *pos, out->data + backward, chunk);
+					*pos += chunk;
+					forward += chunk;
 				}
 			}
 			else {
@@ -1208,13 +1537,15 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 		{
 			break; /*end code, break the loop*/
 		}
-		else /*if(code == (unsigned)(-1))*/ /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+		else /*if(code_ll == INVALIDSYMBOL)*/
 		{
 			/*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
 			(10=no endcode, 11=wrong jump outside of tree)*/
-			error = ((*bp) > inlength * 8) ? 10 : 11;
+			error = (reader->bp > reader->bitsize) ? 10 : 11;
 			break;
 		}
+		/*the reader hands out zeros past the end, so running out of input only shows here*/
+		if (reader->bp > reader->bitsize) ERROR_BREAK(10); /*error: end of input memory reached without endcode*/
 	}
 
 	HuffmanTree_cleanup(&tree_ll);
@@ -1223,14 +1554,15 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 	return error;
 }
 
-static unsigned inflateNoCompression(ucvector* out, const unsigned char* in, size_t* bp, size_t* pos, size_t inlength)
+static unsigned inflateNoCompression(ucvector* out, LodePNGBitReader* reader, size_t* pos)
 {
 	size_t p;
 	unsigned LEN, NLEN, n, error = 0;
+	const unsigned char* in = reader->data;
+	size_t inlength = reader->size;
 
 	/*go to first boundary of byte*/
-	while (((*bp) & 0x7) != 0) ++(*bp);
-	p = (*bp) / 8; /*byte position*/
+	p = (reader->bp + 7) / 8; /*byte position*/
 
 				   /*read LEN (2 bytes) and NLEN (2 bytes)*/
 	if (p + 4 >= inlength) return 52; /*error, bit pointer will jump past memory*/
@@ -1246,7 +1578,7 @@ static unsigned inflateNoCompression(ucvector* out, const unsigned char* in, siz
 	if (p + LEN > inlength) return 23; /*error: reading outside of in buffer*/
 	for (n = 0; n < LEN; ++n) out->data[(*pos)++] = in[p++];
 
-	(*bp) = p * 8;
+	LodePNGBitReader_seek(reader, p * 8);
 
 	return error;
 }
@@ -1255,25 +1587,26 @@ static unsigned lodepng_inflatev(ucvector* out,
 	const unsigned char* in, size_t insize,
 	const LodePNGDecompressSettings* settings)
 {
-	/*bit pointer in the "in" data, current byte is bp >> 3, current bit is bp & 0x7 (from lsb to msb of the byte)*/
-	size_t bp = 0;
+	LodePNGBitReader reader;
 	unsigned BFINAL = 0;
 	size_t pos = 0; /*byte position in the out buffer*/
 	unsigned error = 0;
 
 	(void)settings;
 
+	LodePNGBitReader_init(&reader, in, insize);
+
 	while (!BFINAL)
 	{
 		unsigned BTYPE;
-		if (bp + 2 >= insize * 8) return 52; /*error, bit pointer will jump past memory*/
-		BFINAL = readBitFromStream(&bp, in);
-		BTYPE = 1u * readBitFromStream(&bp, in);
-		BTYPE += 2u * readBitFromStream(&bp, in);
+		if (reader.bp + 2 >= reader.bitsize) return 52; /*error, bit pointer will jump past memory*/
+		ensureBits(&reader, 3);
+		BFINAL = readBits(&reader, 1);
+		BTYPE = readBits(&reader, 2);
 
 		if (BTYPE == 3) return 20; /*error: invalid BTYPE*/
-		else if (BTYPE == 0) error = inflateNoCompression(out, in, &bp, &pos, insize); /*no compression*/
-		else error = inflateHuffmanBlock(out, in, &bp, &pos, insize, BTYPE); /*compression, BTYPE 01 or 10*/
+		else if (BTYPE == 0) error = inflateNoCompression(out, &reader, &pos); /*no compression*/
+		else error = inflateHuffmanBlock(out, &reader, &pos, BTYPE); /*compression, BTYPE 01 or 10*/
 
 		if (error) return error;
 	}
@@ -1441,12 +1774,56 @@ static unsigned getHash(const unsigned char* data, size_t size, size_t pos)
 	return result & HASH_BIT_MASK;
 }
 
+/*index of the lowest set bit, x must not be 0*/
+static unsigned lodepng_ctz64(unsigned long long x)
+{
+#if defined(LODEPNG_X86_SIMD) && defined(_MSC_VER) && defined(_M_X64) /*intrin.h is included for the SIMD code*/
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned)index;
+#elif defined(__GNUC__)
+	return (unsigned)__builtin_ctzll(x);
+#else
+	unsigned n = 0;
+	while (!(x & 1)) { x >>= 1; ++n; }
+	return n;
+#endif
+}
+
+/*
+Length of the common prefix of back and fore, not reading fore past end. Compares 8 bytes at a time, the
+lowest set bit of the xor of two little endian words is in the first byte that differs.
+*/
+static unsigned matchLength(const unsigned char* back, const unsigned char* fore, const unsigned char* end)
+{
+	const unsigned char* start = fore;
+	while (end - fore >= 8)
+	{
+		unsigned long long diff = readLE64(back) ^ readLE64(fore);
+		if (diff) return (unsigned)(fore - start) + (lodepng_ctz64(diff) >> 3);
+		back += 8;
+		fore += 8;
+	}
+	while (fore != end && *back == *fore)
+	{
+		++back;
+		++fore;
+	}
+	return (unsigned)(fore - start);
+}
+
 static unsigned countZeros(const unsigned char* data, size_t size, size_t pos)
 {
 	const unsigned char* start = data + pos;
 	const unsigned char* end = start + MAX_SUPPORTED_DEFLATE_LENGTH;
 	if (end > data + size) end = data + size;
 	data = start;
+	while (end - data >= 8)
+	{
+		unsigned long long word = readLE64(data);
+		if (word) return (unsigned)(data - start) + (lodepng_ctz64(word) >> 3);
+		data += 8;
+	}
 	while (data != end && *data == 0) ++data;
 	/*subtracting two addresses returned as 32-bit number (max value is MAX_SUPPORTED_DEFLATE_LENGTH)*/
 	return (unsigned)(data - start);
@@ -1464,6 +1841,32 @@ static void updateHashChain(Hash* hash, size_t wpos, unsigned hashval, unsigned
 	hash->headz[numzeros] = wpos;
 }
 
+/*
+Insert the positions [start, end) into the hash chains without encoding anything, the same way encodeLZ77 would
+have on its way there. A chunk deflated on its own thread starts like this with the window before it, so that its
+matches can still reach back into the previous chunk.
+*/
+static void hash_prime(Hash* hash, const unsigned char* in, size_t insize, size_t start, size_t end,
+	unsigned windowsize)
+{
+	size_t pos;
+	unsigned numzeros = 0;
+	for (pos = start; pos < end; ++pos)
+	{
+		unsigned hashval = getHash(in, insize, pos);
+		if (hashval == 0)
+		{
+			if (numzeros == 0) numzeros = countZeros(in, insize, pos);
+			else if (pos + numzeros > insize || in[pos + numzeros - 1] != 0) --numzeros;
+		}
+		else
+		{
+			numzeros = 0;
+		}
+		updateHashChain(hash, pos & (windowsize - 1), hashval, numzeros);
+	}
+}
+
 /*
 LZ77-encode the data. Return value is error code. The input are raw bytes, the output
 is in the form of unsigned integers with codes representing for example literal bytes, or
@@ -1474,14 +1877,20 @@ the "dictionary". A brute force search through all possible distances would be s
 this hash technique is one out of several ways to speed this up.
 */
 static unsigned encodeLZ77(uivector* out, Hash* hash,
-	const unsigned char* in, size_t inpos, size_t insize, unsigned windowsize,
-	unsigned minmatch, unsigned nicematch, unsigned lazymatching)
+	const unsigned char* in, size_t inpos, size_t insize, const LodePNGCompressSettings* settings)
 {
 	size_t pos;
 	unsigned i, error = 0;
+	unsigned windowsize = settings->windowsize;
+	unsigned minmatch = settings->minmatch;
+	unsigned nicematch = settings->nicematch;
+	unsigned lazymatching = settings->lazymatching;
 	/*for large window lengths, assume the user wants no compression loss. Otherwise, max hash chain length speedup.*/
-	unsigned maxchainlength = windowsize >= 8192 ? windowsize : windowsize / 8;
+	unsigned maxchainlength = settings->maxchainlength ? settings->maxchainlength
+		: windowsize >= 8192 ? windowsize : windowsize / 8;
 	unsigned maxlazymatch = windowsize >= 8192 ? MAX_SUPPORTED_DEFLATE_LENGTH : 64;
+	/*greedy only: longer matches skip the hash chain updates for the positions they cover*/
+	unsigned maxinsert = lazymatching ? 0 : settings->maxinsert;
 
 	unsigned usezeros = 1; /*not sure if setting it to false for windowsize < 8192 is better or worse*/
 	unsigned numzeros = 0;
@@ -1552,12 +1961,8 @@ static unsigned encodeLZ77(uivector* out, Hash* hash,
 					foreptr += skip;
 				}
 
-				while (foreptr != lastptr && *backptr == *foreptr) /*maximum supported length by deflate is max length*/
-				{
-					++backptr;
-					++foreptr;
-				}
-				current_length = (unsigned)(foreptr - &in[pos]);
+				/*maximum supported length by deflate is max length*/
+				current_length = (unsigned)(foreptr - &in[pos]) + matchLength(backptr, foreptr, lastptr);
 
 				if (current_length > length)
 				{
@@ -1628,6 +2033,20 @@ static unsigned encodeLZ77(uivector* out, Hash* hash,
 		else
 		{
 			addLengthDistance(out, length, offset);
+			if (maxinsert && length > maxinsert)
+			{
+				/*mark the skipped positions as stale, so that chains passing through them stop there and their
+				zero counts don't make the matcher skip bytes that may not be zero anymore*/
+				for (i = 1; i < length; ++i)
+				{
+					wpos = (pos + i) & (windowsize - 1);
+					hash->val[wpos] = -1;
+					hash->zeros[wpos] = 0;
+				}
+				pos += length - 1;
+				numzeros = 0;
+				continue;
+			}
 			for (i = 1; i < length; ++i)
 			{
 				++pos;
@@ -1784,8 +2203,7 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
 	{
 		if (settings->use_lz77)
 		{
-			error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
-				settings->minmatch, settings->nicematch, settings->lazymatching);
+			error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings);
 			if (error) break;
 		}
 		else
@@ -1994,8 +2412,7 @@ static unsigned deflateFixed(ucvector* out, size_t* bp, Hash* hash,
 	{
 		uivector lz77_encoded;
 		uivector_init(&lz77_encoded);
-		error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
-			settings->minmatch, settings->nicematch, settings->lazymatching);
+		error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings);
 		if (!error) writeLZ77data(bp, out, &lz77_encoded, &tree_ll, &tree_d);
 		uivector_cleanup(&lz77_encoded);
 	}
@@ -2016,16 +2433,124 @@ static unsigned deflateFixed(ucvector* out, size_t* bp, Hash* hash,
 	return error;
 }
 
+/*
+Multithreaded deflate, pigz style: the input is cut into chunks that are compressed independently, each into
+its own buffer. Every chunk but the last ends with an empty stored block (what zlib calls a sync flush), which
+leaves it on a byte boundary, so the buffers can simply be concatenated into one stream afterwards.
+*/
+typedef struct DeflateChunks
+{
+	const unsigned char* in;
+	size_t insize;
+	size_t chunksize;
+	size_t numchunks;
+	const LodePNGCompressSettings* settings;
+	ucvector* out; /*numchunks outputs*/
+	unsigned* errors; /*numchunks error codes*/
+} DeflateChunks;
+
+static void deflateChunk(void* context, size_t index)
+{
+	DeflateChunks* chunks = (DeflateChunks*)context;
+	const LodePNGCompressSettings* settings = chunks->settings;
+	ucvector* out = &chunks->out[index];
+	size_t start = index * chunks->chunksize;
+	size_t end = start + chunks->chunksize;
+	unsigned final = (index == chunks->numchunks - 1);
+	size_t bp = 0;
+	unsigned error;
+	Hash hash;
+
+	if (end > chunks->insize) end = chunks->insize;
+
+	error = hash_init(&hash, settings->windowsize);
+	if (!error)
+	{
+		hash_prime(&hash, chunks->in, end, start > settings->windowsize ? start - settings->windowsize : 0, start,
+			settings->windowsize);
+		if (settings->btype == 1) error = deflateFixed(out, &bp, &hash, chunks->in, start, end, settings, final);
+		else error = deflateDynamic(out, &bp, &hash, chunks->in, start, end, settings, final);
+	}
+	hash_cleanup(&hash);
+
+	if (!error && !final)
+	{
+		/*BFINAL 0 and BTYPE 00, padding to the byte boundary, then LEN 0 and NLEN 0xffff*/
+		addBitsToStream(&bp, out, 0, 3);
+		if (!ucvector_push_back(out, 0) || !ucvector_push_back(out, 0) ||
+			!ucvector_push_back(out, 255) || !ucvector_push_back(out, 255)) error = 83; /*alloc fail*/
+	}
+
+	chunks->errors[index] = error;
+}
+
+static unsigned deflateParallel(ucvector* out, const unsigned char* in, size_t insize,
+	const LodePNGCompressSettings* settings, unsigned numthreads)
+{
+	unsigned error = 0;
+	size_t i, total;
+	DeflateChunks chunks;
+
+	/*the same block sizes as single threaded, but small enough for a few chunks per thread*/
+	chunks.chunksize = insize / (numthreads * 4) + 8;
+	if (chunks.chunksize < 65536) chunks.chunksize = 65536;
+	if (chunks.chunksize > 262144) chunks.chunksize = 262144;
+	chunks.numchunks = (insize + chunks.chunksize - 1) / chunks.chunksize;
+	chunks.in = in;
+	chunks.insize = insize;
+	chunks.settings = settings;
+	chunks.out = (ucvector*)lodepng_malloc(sizeof(ucvector) * chunks.numchunks);
+	chunks.errors = (unsigned*)lodepng_malloc(sizeof(unsigned) * chunks.numchunks);
+	if (!chunks.out || !chunks.errors)
+	{
+		lodepng_free(chunks.out);
+		lodepng_free(chunks.errors);
+		return 83; /*alloc fail*/
+	}
+	for (i = 0; i != chunks.numchunks; ++i) ucvector_init(&chunks.out[i]);
+
+	lodepng_run_jobs(deflateChunk, &chunks, chunks.numchunks, numthreads);
+
+	total = out->size;
+	for (i = 0; i != chunks.numchunks && !error; ++i)
+	{
+		error = chunks.errors[i];
+		total += chunks.out[i].size;
+	}
+	if (!error && !ucvector_reserve(out, total)) error = 83; /*alloc fail*/
+	for (i = 0; i != chunks.numchunks; ++i)
+	{
+		if (!error)
+		{
+			memcpy(out->data + out->size, chunks.out[i].data, chunks.out[i].size);
+			out->size += chunks.out[i].size;
+		}
+		ucvector_cleanup(&chunks.out[i]);
+	}
+
+	lodepng_free(chunks.out);
+	lodepng_free(chunks.errors);
+	return error;
+}
+
 static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t insize,
 	const LodePNGCompressSettings* settings)
 {
 	unsigned error = 0;
 	size_t i, blocksize, numdeflateblocks;
 	size_t bp = 0; /*the bit pointer*/
+	unsigned numthreads = lodepng_num_threads(settings->num_threads);
 	Hash hash;
 
 	if (settings->btype > 2) return 61;
 	else if (settings->btype == 0) return deflateNoCompression(out, in, insize);
+	else if (numthreads > 1 && insize > 65536)
+	{
+		/*the window size is checked by encodeLZ77, but that's too late to stop the hash_prime*/
+		if (settings->windowsize == 0 || settings->windowsize > 32768) return 60;
+		if ((settings->windowsize & (settings->windowsize - 1)) != 0) return 90;
+		return deflateParallel(out, in, insize, settings, numthreads);
+	}
 	else if (settings->btype == 1) blocksize = insize;
 	else /*if(settings->btype == 2)*/
 	{
@@ -2090,15 +2615,142 @@ static unsigned deflate(unsigned char** out, size_t* outsize,
 /* / Adler32                                                                  */
 /* ////////////////////////////////////////////////////////////////////////// */
 
-static unsigned update_adler32(unsigned adler, const unsigned char* data, unsigned len)
+/*the most bytes that can be summed before s2 might overflow 32 bits, so before it has to be reduced modulo 65521*/
+#define ADLER32_NMAX 5552
+
+#ifdef LODEPNG_X86_SIMD
+/*
+Vectorized Adler-32 for whole blocks of 32 (SSSE3) or 64 (AVX2) bytes. Within a block, s1 grows by the sum of
+the bytes (psadbw) and s2 by the bytes weighted by their distance from the end of the block (pmaddubsw with
+descending taps), plus block size times the s1 from before the block. That last part is accumulated in ps
+and multiplied in once per NMAX stretch. Returns the updated adler, the caller does the remaining bytes.
+*/
+static LODEPNG_TARGET("ssse3") unsigned update_adler32_ssse3(unsigned adler, const unsigned char* data, unsigned blocks)
+{
+	unsigned s1 = adler & 0xffff;
+	unsigned s2 = (adler >> 16) & 0xffff;
+	const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+	const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+
+	while (blocks)
+	{
+		unsigned n = ADLER32_NMAX / 32;
+		__m128i v_ps, v_s1, v_s2;
+		if (n > blocks) n = blocks;
+		blocks -= n;
+
+		v_ps = _mm_cvtsi32_si128((int)(s1 * n));
+		v_s2 = _mm_cvtsi32_si128((int)s2);
+		v_s1 = zero;
+		do
+		{
+			__m128i bytes1 = _mm_loadu_si128((const __m128i*)data);
+			__m128i bytes2 = _mm_loadu_si128((const __m128i*)(data + 16));
+			v_ps = _mm_add_epi32(v_ps, v_s1);
+			v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+			v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+			v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+			v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+			data += 32;
+		} while (--n);
+		v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+		/*psadbw leaves its sums in the two 64 bit halves, the others are spread over all four lanes*/
+		v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+		s1 += (unsigned)_mm_cvtsi128_si32(v_s1);
+		v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+		v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+		s2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+
+		s1 %= 65521;
+		s2 %= 65521;
+	}
+
+	return (s2 << 16) | s1;
+}
+
+static LODEPNG_TARGET("avx2") unsigned update_adler32_avx2(unsigned adler, const unsigned char* data, unsigned blocks)
 {
 	unsigned s1 = adler & 0xffff;
 	unsigned s2 = (adler >> 16) & 0xffff;
+	const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+		48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33);
+	const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+		16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi16(1);
+
+	while (blocks)
+	{
+		unsigned n = ADLER32_NMAX / 64;
+		__m256i v_ps, v_s1, v_s2;
+		__m128i h1, h2;
+		if (n > blocks) n = blocks;
+		blocks -= n;
+
+		v_ps = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+		v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+		v_s1 = zero;
+		do
+		{
+			__m256i bytes1 = _mm256_loadu_si256((const __m256i*)data);
+			__m256i bytes2 = _mm256_loadu_si256((const __m256i*)(data + 32));
+			v_ps = _mm256_add_epi32(v_ps, v_s1);
+			v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes1, zero));
+			v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+			v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes2, zero));
+			v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+			data += 64;
+		} while (--n);
+		v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 6));
+
+		h1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+		h1 = _mm_add_epi32(h1, _mm_shuffle_epi32(h1, _MM_SHUFFLE(1, 0, 3, 2)));
+		s1 += (unsigned)_mm_cvtsi128_si32(h1);
+		h2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+		h2 = _mm_add_epi32(h2, _mm_shuffle_epi32(h2, _MM_SHUFFLE(2, 3, 0, 1)));
+		h2 = _mm_add_epi32(h2, _mm_shuffle_epi32(h2, _MM_SHUFFLE(1, 0, 3, 2)));
+		s2 = (unsigned)_mm_cvtsi128_si32(h2);
+
+		s1 %= 65521;
+		s2 %= 65521;
+	}
+
+	return (s2 << 16) | s1;
+}
+#endif /*LODEPNG_X86_SIMD*/
+
+static unsigned update_adler32(unsigned adler, const unsigned char* data, unsigned len)
+{
+	unsigned s1, s2;
+
+#ifdef LODEPNG_X86_SIMD
+	unsigned features = lodepng_cpu_features();
+	if (features & CPU_FEATURE_AVX2)
+	{
+		unsigned blocks = len / 64;
+		adler = update_adler32_avx2(adler, data, blocks);
+		data += blocks * 64;
+		len -= blocks * 64;
+	}
+	else if (features & CPU_FEATURE_SSSE3)
+	{
+		unsigned blocks = len / 32;
+		adler = update_adler32_ssse3(adler, data, blocks);
+		data += blocks * 32;
+		len -= blocks * 32;
+	}
+#endif
+
+	s1 = adler & 0xffff;
+	s2 = (adler >> 16) & 0xffff;
 
 	while (len > 0)
 	{
-		/*at least 5550 sums can be done before the sums overflow, saving a lot of module divisions*/
-		unsigned amount = len > 5550 ? 5550 : len;
+		/*ADLER32_NMAX sums can be done before the sums overflow, saving a lot of modulo divisions*/
+		unsigned amount = len > ADLER32_NMAX ? ADLER32_NMAX : len;
 		len -= amount;
 		while (amount > 0)
 		{
@@ -2183,20 +2835,295 @@ static unsigned zlib_decompress(unsigned char** out, size_t* outsize, const unsi
 	}
 }
 
-#endif /*LODEPNG_COMPILE_DECODER*/
-
-#ifdef LODEPNG_COMPILE_ENCODER
+/*
+Resumable zlib decompression, for decoding PNGs whose IDAT data arrives in pieces. Compressed data is
+appended to the input buffer as it comes in, and zlibStream_run decodes as far as that allows. Decoding
+only ever pauses in between two symbols or block headers: while more input can still come, a symbol is
+only decoded with at least 48 bits (a whole length/distance pair) buffered, and a block header with
+1K (enough for the largest dynamic tree). The output goes to a window that keeps the last 32K for back
+references. Each run decodes up to ZLIBSTREAM_CHUNK new bytes, window[outbegin, windowend), and the
+caller has to take them all before the next run slides them out of the window.
+*/
+#define ZLIBSTREAM_HISTORY 32768
+#define ZLIBSTREAM_CHUNK 65536
+
+typedef enum ZlibStreamState
+{
+	ZLIBSTREAM_HEADER, ZLIBSTREAM_BLOCK, ZLIBSTREAM_HUFFMAN, ZLIBSTREAM_STORED, ZLIBSTREAM_ADLER, ZLIBSTREAM_DONE
+} ZlibStreamState;
+
+typedef struct ZlibStream
+{
+	ucvector in; /*compressed data not consumed yet, bp counts from its start*/
+	size_t bp;
+	unsigned char* window; /*ZLIBSTREAM_HISTORY + ZLIBSTREAM_CHUNK + 258 bytes*/
+	size_t windowend; /*amount of window in use*/
+	size_t outbegin; /*start of the output of the last run in window*/
+	size_t checked; /*window up to here is in adler*/
+	ZlibStreamState state;
+	unsigned final; /*the current block is the last one*/
+	unsigned stored; /*bytes left of the current stored block*/
+	HuffmanTree tree_ll;
+	HuffmanTree tree_d;
+	unsigned adler;
+} ZlibStream;
+
+static unsigned zlibStream_init(ZlibStream* zs)
+{
+	ucvector_init(&zs->in);
+	zs->bp = 0;
+	zs->window = (unsigned char*)lodepng_malloc(ZLIBSTREAM_HISTORY + ZLIBSTREAM_CHUNK + 258);
+	zs->windowend = zs->outbegin = zs->checked = 0;
+	zs->state = ZLIBSTREAM_HEADER;
+	zs->final = 0;
+	zs->stored = 0;
+	HuffmanTree_init(&zs->tree_ll);
+	HuffmanTree_init(&zs->tree_d);
+	zs->adler = 1;
+	return zs->window ? 0 : 83; /*alloc fail*/
+}
+
+static void zlibStream_cleanup(ZlibStream* zs)
+{
+	ucvector_cleanup(&zs->in);
+	lodepng_free(zs->window);
+	HuffmanTree_cleanup(&zs->tree_ll);
+	HuffmanTree_cleanup(&zs->tree_d);
+}
+
+static unsigned zlibStream_feed(ZlibStream* zs, const unsigned char* data, size_t size)
+{
+	size_t oldsize = zs->in.size;
+	if (!size) return 0;
+	if (!ucvector_resize(&zs->in, oldsize + size)) return 83; /*alloc fail*/
+	memcpy(zs->in.data + oldsize, data, size);
+	return 0;
+}
 
-unsigned lodepng_zlib_compress(unsigned char** out, size_t* outsize, const unsigned char* in,
-	size_t insize, const LodePNGCompressSettings* settings)
+/*decodes the symbols of a Huffman block until the end code, until limit bytes are in the window or until
+the input runs low, see above*/
+static unsigned zlibStream_huffman(ZlibStream* zs, LodePNGBitReader* reader, unsigned last, size_t limit)
 {
-	/*initially, *out must be NULL and outsize 0, if you just give some random *out
-	that's pointing to a non allocated buffer, this'll crash*/
-	ucvector outv;
-	size_t i;
-	unsigned error;
-	unsigned char* deflatedata = 0;
-	size_t deflatesize = 0;
+	unsigned char* window = zs->window;
+	size_t pos = zs->windowend;
+	unsigned error = 0;
+
+	while (pos < limit)
+	{
+		unsigned code_ll;
+		if (!last && reader->bitsize - reader->bp < 48) break;
+		ensureBits(reader, 48);
+		code_ll = huffmanDecodeSymbol(reader, &zs->tree_ll);
+		if (code_ll <= 255)
+		{
+			window[pos++] = (unsigned char)code_ll;
+		}
+		else if (code_ll >= FIRST_LENGTH_CODE_INDEX && code_ll <= LAST_LENGTH_CODE_INDEX)
+		{
+			unsigned code_d, distance;
+			size_t length, backward;
+
+			length = LENGTHBASE[code_ll - FIRST_LENGTH_CODE_INDEX];
+			length += readBits(reader, LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX]);
+
+			code_d = huffmanDecodeSymbol(reader, &zs->tree_d);
+			if (code_d > 29)
+			{
+				if (code_d == INVALIDSYMBOL) error = reader->bp > reader->bitsize ? 10 : 11;
+				else error = 18; /*error: invalid distance code (30-31 are never used)*/
+				break;
+			}
+			distance = DISTANCEBASE[code_d];
+			distance += readBits(reader, DISTANCEEXTRA[code_d]);
+
+			if (reader->bp > reader->bitsize) ERROR_BREAK(51); /*error, bit pointer jumped past memory*/
+			/*the window holds all output if there's less than 32K of it*/
+			if (distance > pos) ERROR_BREAK(52); /*too long backward distance*/
+			backward = pos - distance;
+
+			if (distance < length)
+			{
+				/*overlapping, copy in chunks that double every time like inflateHuffmanBlock*/
+				size_t forward;
+				for (forward = 0; forward < length;)
+				{
+					size_t chunk = pos - backward;
+					if (chunk > length - forward) chunk = length - forward;
+					memcpy(window + pos, window + backward, chunk);
+					pos += chunk;
+					forward += chunk;
+				}
+			}
+			else
+			{
+				memcpy(window + pos, window + backward, length);
+				pos += length;
+			}
+		}
+		else if (code_ll == 256)
+		{
+			zs->state = zs->final ? ZLIBSTREAM_ADLER : ZLIBSTREAM_BLOCK;
+			break;
+		}
+		else
+		{
+			error = (reader->bp > reader->bitsize) ? 10 : 11;
+			break;
+		}
+		if (reader->bp > reader->bitsize) ERROR_BREAK(10); /*error: end of input memory reached without endcode*/
+	}
+
+	zs->windowend = pos;
+	return error;
+}
+
+/*last: all compressed data has been fed, so running out of it is an error now*/
+static unsigned zlibStream_run(ZlibStream* zs, unsigned last, const LodePNGDecompressSettings* settings)
+{
+	LodePNGBitReader reader;
+	size_t limit = ZLIBSTREAM_HISTORY + ZLIBSTREAM_CHUNK;
+	unsigned error = 0;
+
+	/*drop the input that's been read*/
+	if (zs->bp >= 8)
+	{
+		size_t drop = zs->bp >> 3;
+		memmove(zs->in.data, zs->in.data + drop, zs->in.size - drop);
+		zs->in.size -= drop;
+		zs->bp &= 7;
+	}
+	/*drop the output the caller has, except what back references can still reach*/
+	if (zs->windowend > ZLIBSTREAM_HISTORY)
+	{
+		size_t drop = zs->windowend - ZLIBSTREAM_HISTORY;
+		memmove(zs->window, zs->window + drop, ZLIBSTREAM_HISTORY);
+		zs->windowend -= drop;
+		zs->checked -= drop;
+	}
+	zs->outbegin = zs->windowend;
+
+	LodePNGBitReader_init(&reader, zs->in.data, zs->in.size);
+	LodePNGBitReader_seek(&reader, zs->bp);
+
+	while (!error && zs->windowend < limit && zs->state != ZLIBSTREAM_DONE)
+	{
+		size_t avail = reader.bitsize - reader.bp;
+		if (zs->state == ZLIBSTREAM_HEADER)
+		{
+			unsigned CMF, FLG;
+			if (avail < 16)
+			{
+				if (last) error = 53; /*error, size of zlib data too small*/
+				break;
+			}
+			ensureBits(&reader, 16);
+			CMF = readBits(&reader, 8);
+			FLG = readBits(&reader, 8);
+			/*same checks as lodepng_zlib_decompress*/
+			if ((CMF * 256 + FLG) % 31 != 0) error = 24;
+			else if ((CMF & 15) != 8 || ((CMF >> 4) & 15) > 7) error = 25;
+			else if ((FLG >> 5) & 1) error = 26;
+			zs->state = ZLIBSTREAM_BLOCK;
+		}
+		else if (zs->state == ZLIBSTREAM_BLOCK)
+		{
+			unsigned BTYPE;
+			if (!last && avail < 8192) break;
+			if (reader.bp + 2 >= reader.bitsize) ERROR_BREAK(52); /*error, bit pointer will jump past memory*/
+			ensureBits(&reader, 3);
+			zs->final = readBits(&reader, 1);
+			BTYPE = readBits(&reader, 2);
+
+			if (BTYPE == 3) ERROR_BREAK(20); /*error: invalid BTYPE*/
+			if (BTYPE == 0)
+			{
+				size_t p = (reader.bp + 7) / 8;
+				unsigned LEN, NLEN;
+				if (p + 4 > zs->in.size) ERROR_BREAK(52); /*error, bit pointer will jump past memory*/
+				LEN = zs->in.data[p] + 256u * zs->in.data[p + 1];
+				NLEN = zs->in.data[p + 2] + 256u * zs->in.data[p + 3];
+				if (LEN + NLEN != 65535) ERROR_BREAK(21); /*error: NLEN is not one's complement of LEN*/
+				zs->stored = LEN;
+				LodePNGBitReader_seek(&reader, (p + 4) * 8);
+				zs->state = LEN ? ZLIBSTREAM_STORED : zs->final ? ZLIBSTREAM_ADLER : ZLIBSTREAM_BLOCK;
+			}
+			else
+			{
+				HuffmanTree_cleanup(&zs->tree_ll);
+				HuffmanTree_cleanup(&zs->tree_d);
+				HuffmanTree_init(&zs->tree_ll);
+				HuffmanTree_init(&zs->tree_d);
+				if (BTYPE == 1) getTreeInflateFixed(&zs->tree_ll, &zs->tree_d);
+				else error = getTreeInflateDynamic(&zs->tree_ll, &zs->tree_d, &reader);
+				zs->state = ZLIBSTREAM_HUFFMAN;
+			}
+		}
+		else if (zs->state == ZLIBSTREAM_STORED)
+		{
+			size_t p = reader.bp >> 3; /*stored data is byte aligned*/
+			size_t n = zs->stored;
+			if (n > zs->in.size - p) n = zs->in.size - p;
+			if (n > limit - zs->windowend) n = limit - zs->windowend;
+			if (n == 0)
+			{
+				if (last) error = 23; /*error: reading outside of in buffer*/
+				break;
+			}
+			memcpy(zs->window + zs->windowend, zs->in.data + p, n);
+			zs->windowend += n;
+			zs->stored -= (unsigned)n;
+			LodePNGBitReader_seek(&reader, (p + n) * 8);
+			if (!zs->stored) zs->state = zs->final ? ZLIBSTREAM_ADLER : ZLIBSTREAM_BLOCK;
+		}
+		else if (zs->state == ZLIBSTREAM_HUFFMAN)
+		{
+			error = zlibStream_huffman(zs, &reader, last, limit);
+			/*still in the block with room left in the window means it ran out of input*/
+			if (zs->state == ZLIBSTREAM_HUFFMAN && zs->windowend < limit) break;
+		}
+		else /*ZLIBSTREAM_ADLER*/
+		{
+			size_t p = (reader.bp + 7) / 8;
+			if (p + 4 > zs->in.size)
+			{
+				if (last) error = 52; /*error, bit pointer will jump past memory*/
+				break;
+			}
+			if (!settings->ignore_adler32)
+			{
+				zs->adler = update_adler32(zs->adler, zs->window + zs->checked, (unsigned)(zs->windowend - zs->checked));
+				zs->checked = zs->windowend;
+				/*error, adler checksum not correct, data must be corrupted*/
+				if (zs->adler != lodepng_read32bitInt(&zs->in.data[p])) error = 58;
+			}
+			LodePNGBitReader_seek(&reader, (p + 4) * 8);
+			zs->state = ZLIBSTREAM_DONE;
+		}
+	}
+
+	zs->bp = reader.bp;
+	if (!settings->ignore_adler32)
+	{
+		zs->adler = update_adler32(zs->adler, zs->window + zs->checked, (unsigned)(zs->windowend - zs->checked));
+		zs->checked = zs->windowend;
+	}
+	return error;
+}
+
+#endif /*LODEPNG_COMPILE_DECODER*/
+
+#ifdef LODEPNG_COMPILE_ENCODER
+
+unsigned lodepng_zlib_compress(unsigned char** out, size_t* outsize, const unsigned char* in,
+	size_t insize, const LodePNGCompressSettings* settings)
+{
+	/*initially, *out must be NULL and outsize 0, if you just give some random *out
+	that's pointing to a non allocated buffer, this'll crash*/
+	ucvector outv;
+	size_t i;
+	unsigned error;
+	unsigned char* deflatedata = 0;
+	size_t deflatesize = 0;
 
 	/*zlib data: 1 byte CMF (CM+CINFO), 1 byte FLG, deflate data, 4 byte ADLER32 checksum of the Decompressed data*/
 	unsigned CMF = 120; /*0b01111000: CM 8, CINFO 7. With CINFO 7, any window size up to 32768 can be used.*/
@@ -2281,13 +3208,53 @@ void lodepng_compress_settings_init(LodePNGCompressSettings* settings)
 	settings->minmatch = 3;
 	settings->nicematch = 128;
 	settings->lazymatching = 1;
+	settings->maxchainlength = 0;
+	settings->maxinsert = 0;
+	settings->num_threads = 1;
 
 	settings->custom_zlib = 0;
 	settings->custom_deflate = 0;
 	settings->custom_context = 0;
 }
 
-const LodePNGCompressSettings lodepng_default_compress_settings = { 2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 0 };
+const LodePNGCompressSettings lodepng_default_compress_settings = { 2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 1, 0, 0, 0 };
+
+/*
+windowsize, nicematch, lazymatching, maxchainlength, maxinsert for levels 1 to 9, tuned on filtered PNG data.
+The full window is always worth it: the chain length caps keep the search cost independent of it, and PNG matches
+are often a scanline or more back. Skipping the chain updates inside long matches makes the greedy
+levels much faster, but also loses a lot of matches against the previous scanline, hence only levels 1 and 2.
+*/
+static const unsigned LEVEL_SETTINGS[9][5] = {
+	{ 32768, 32, 0, 4, 16 },
+	{ 32768, 32, 0, 16, 64 },
+	{ 32768, 32, 0, 4, 0 },
+	{ 32768, 32, 1, 4, 0 },
+	{ 32768, 32, 1, 16, 0 },
+	{ 32768, 128, 1, 64, 0 },
+	{ 32768, 128, 1, 256, 0 },
+	{ 32768, 258, 1, 1024, 0 },
+	{ 32768, 258, 1, 4096, 0 }
+};
+
+void lodepng_compress_settings_level(LodePNGCompressSettings* settings, unsigned level)
+{
+	const unsigned* values;
+	if (level == 0)
+	{
+		settings->btype = 0;
+		return;
+	}
+	if (level > 9) level = 9;
+	values = LEVEL_SETTINGS[level - 1];
+	settings->btype = 2;
+	settings->use_lz77 = 1;
+	settings->windowsize = values[0];
+	settings->nicematch = values[1];
+	settings->lazymatching = values[2];
+	settings->maxchainlength = values[3];
+	settings->maxinsert = values[4];
+}
 
 
 #endif /*LODEPNG_COMPILE_ENCODER*/
@@ -2321,52 +3288,408 @@ const LodePNGDecompressSettings lodepng_default_decompress_settings = { 0, 0, 0,
 
 
 #ifndef LODEPNG_NO_COMPILE_CRC
-/* CRC polynomial: 0xedb88320 */
-static unsigned lodepng_crc32_table[256] = {
-	0u, 1996959894u, 3993919788u, 2567524794u,  124634137u, 1886057615u, 3915621685u, 2657392035u,
-	249268274u, 2044508324u, 3772115230u, 2547177864u,  162941995u, 2125561021u, 3887607047u, 2428444049u,
-	498536548u, 1789927666u, 4089016648u, 2227061214u,  450548861u, 1843258603u, 4107580753u, 2211677639u,
-	325883990u, 1684777152u, 4251122042u, 2321926636u,  335633487u, 1661365465u, 4195302755u, 2366115317u,
-	997073096u, 1281953886u, 3579855332u, 2724688242u, 1006888145u, 1258607687u, 3524101629u, 2768942443u,
-	901097722u, 1119000684u, 3686517206u, 2898065728u,  853044451u, 1172266101u, 3705015759u, 2882616665u,
-	651767980u, 1373503546u, 3369554304u, 3218104598u,  565507253u, 1454621731u, 3485111705u, 3099436303u,
-	671266974u, 1594198024u, 3322730930u, 2970347812u,  795835527u, 1483230225u, 3244367275u, 3060149565u,
-	1994146192u,   31158534u, 2563907772u, 4023717930u, 1907459465u,  112637215u, 2680153253u, 3904427059u,
-	2013776290u,  251722036u, 2517215374u, 3775830040u, 2137656763u,  141376813u, 2439277719u, 3865271297u,
-	1802195444u,  476864866u, 2238001368u, 4066508878u, 1812370925u,  453092731u, 2181625025u, 4111451223u,
-	1706088902u,  314042704u, 2344532202u, 4240017532u, 1658658271u,  366619977u, 2362670323u, 4224994405u,
-	1303535960u,  984961486u, 2747007092u, 3569037538u, 1256170817u, 1037604311u, 2765210733u, 3554079995u,
-	1131014506u,  879679996u, 2909243462u, 3663771856u, 1141124467u,  855842277u, 2852801631u, 3708648649u,
-	1342533948u,  654459306u, 3188396048u, 3373015174u, 1466479909u,  544179635u, 3110523913u, 3462522015u,
-	1591671054u,  702138776u, 2966460450u, 3352799412u, 1504918807u,  783551873u, 3082640443u, 3233442989u,
-	3988292384u, 2596254646u,   62317068u, 1957810842u, 3939845945u, 2647816111u,   81470997u, 1943803523u,
-	3814918930u, 2489596804u,  225274430u, 2053790376u, 3826175755u, 2466906013u,  167816743u, 2097651377u,
-	4027552580u, 2265490386u,  503444072u, 1762050814u, 4150417245u, 2154129355u,  426522225u, 1852507879u,
-	4275313526u, 2312317920u,  282753626u, 1742555852u, 4189708143u, 2394877945u,  397917763u, 1622183637u,
-	3604390888u, 2714866558u,  953729732u, 1340076626u, 3518719985u, 2797360999u, 1068828381u, 1219638859u,
-	3624741850u, 2936675148u,  906185462u, 1090812512u, 3747672003u, 2825379669u,  829329135u, 1181335161u,
-	3412177804u, 3160834842u,  628085408u, 1382605366u, 3423369109u, 3138078467u,  570562233u, 1426400815u,
-	3317316542u, 2998733608u,  733239954u, 1555261956u, 3268935591u, 3050360625u,  752459403u, 1541320221u,
-	2607071920u, 3965973030u, 1969922972u,   40735498u, 2617837225u, 3943577151u, 1913087877u,   83908371u,
-	2512341634u, 3803740692u, 2075208622u,  213261112u, 2463272603u, 3855990285u, 2094854071u,  198958881u,
-	2262029012u, 4057260610u, 1759359992u,  534414190u, 2176718541u, 4139329115u, 1873836001u,  414664567u,
-	2282248934u, 4279200368u, 1711684554u,  285281116u, 2405801727u, 4167216745u, 1634467795u,  376229701u,
-	2685067896u, 3608007406u, 1308918612u,  956543938u, 2808555105u, 3495958263u, 1231636301u, 1047427035u,
-	2932959818u, 3654703836u, 1088359270u,  936918000u, 2847714899u, 3736837829u, 1202900863u,  817233897u,
-	3183342108u, 3401237130u, 1404277552u,  615818150u, 3134207493u, 3453421203u, 1423857449u,  601450431u,
-	3009837614u, 3294710456u, 1567103746u,  711928724u, 3020668471u, 3272380065u, 1510334235u,  755167117u
+/*
+CRC polynomial: 0xedb88320. lodepng_crc32_table[0] is the usual byte-at-a-time table, table[k][n] is the CRC of
+byte n followed by k zero bytes. With those, 8 input bytes are folded into the CRC with 8 independent lookups
+("slice-by-8") instead of a chain of 8 dependent ones.
+*/
+static const unsigned lodepng_crc32_table[8][256] = {
+	{
+		0u, 1996959894u, 3993919788u, 2567524794u,  124634137u, 1886057615u, 3915621685u, 2657392035u,
+		249268274u, 2044508324u, 3772115230u, 2547177864u,  162941995u, 2125561021u, 3887607047u, 2428444049u,
+		498536548u, 1789927666u, 4089016648u, 2227061214u,  450548861u, 1843258603u, 4107580753u, 2211677639u,
+		325883990u, 1684777152u, 4251122042u, 2321926636u,  335633487u, 1661365465u, 4195302755u, 2366115317u,
+		997073096u, 1281953886u, 3579855332u, 2724688242u, 1006888145u, 1258607687u, 3524101629u, 2768942443u,
+		901097722u, 1119000684u, 3686517206u, 2898065728u,  853044451u, 1172266101u, 3705015759u, 2882616665u,
+		651767980u, 1373503546u, 3369554304u, 3218104598u,  565507253u, 1454621731u, 3485111705u, 3099436303u,
+		671266974u, 1594198024u, 3322730930u, 2970347812u,  795835527u, 1483230225u, 3244367275u, 3060149565u,
+		1994146192u,   31158534u, 2563907772u, 4023717930u, 1907459465u,  112637215u, 2680153253u, 3904427059u,
+		2013776290u,  251722036u, 2517215374u, 3775830040u, 2137656763u,  141376813u, 2439277719u, 3865271297u,
+		1802195444u,  476864866u, 2238001368u, 4066508878u, 1812370925u,  453092731u, 2181625025u, 4111451223u,
+		1706088902u,  314042704u, 2344532202u, 4240017532u, 1658658271u,  366619977u, 2362670323u, 4224994405u,
+		1303535960u,  984961486u, 2747007092u, 3569037538u, 1256170817u, 1037604311u, 2765210733u, 3554079995u,
+		1131014506u,  879679996u, 2909243462u, 3663771856u, 1141124467u,  855842277u, 2852801631u, 3708648649u,
+		1342533948u,  654459306u, 3188396048u, 3373015174u, 1466479909u,  544179635u, 3110523913u, 3462522015u,
+		1591671054u,  702138776u, 2966460450u, 3352799412u, 1504918807u,  783551873u, 3082640443u, 3233442989u,
+		3988292384u, 2596254646u,   62317068u, 1957810842u, 3939845945u, 2647816111u,   81470997u, 1943803523u,
+		3814918930u, 2489596804u,  225274430u, 2053790376u, 3826175755u, 2466906013u,  167816743u, 2097651377u,
+		4027552580u, 2265490386u,  503444072u, 1762050814u, 4150417245u, 2154129355u,  426522225u, 1852507879u,
+		4275313526u, 2312317920u,  282753626u, 1742555852u, 4189708143u, 2394877945u,  397917763u, 1622183637u,
+		3604390888u, 2714866558u,  953729732u, 1340076626u, 3518719985u, 2797360999u, 1068828381u, 1219638859u,
+		3624741850u, 2936675148u,  906185462u, 1090812512u, 3747672003u, 2825379669u,  829329135u, 1181335161u,
+		3412177804u, 3160834842u,  628085408u, 1382605366u, 3423369109u, 3138078467u,  570562233u, 1426400815u,
+		3317316542u, 2998733608u,  733239954u, 1555261956u, 3268935591u, 3050360625u,  752459403u, 1541320221u,
+		2607071920u, 3965973030u, 1969922972u,   40735498u, 2617837225u, 3943577151u, 1913087877u,   83908371u,
+		2512341634u, 3803740692u, 2075208622u,  213261112u, 2463272603u, 3855990285u, 2094854071u,  198958881u,
+		2262029012u, 4057260610u, 1759359992u,  534414190u, 2176718541u, 4139329115u, 1873836001u,  414664567u,
+		2282248934u, 4279200368u, 1711684554u,  285281116u, 2405801727u, 4167216745u, 1634467795u,  376229701u,
+		2685067896u, 3608007406u, 1308918612u,  956543938u, 2808555105u, 3495958263u, 1231636301u, 1047427035u,
+		2932959818u, 3654703836u, 1088359270u,  936918000u, 2847714899u, 3736837829u, 1202900863u,  817233897u,
+		3183342108u, 3401237130u, 1404277552u,  615818150u, 3134207493u, 3453421203u, 1423857449u,  601450431u,
+		3009837614u, 3294710456u, 1567103746u,  711928724u, 3020668471u, 3272380065u, 1510334235u,  755167117u
+	},
+	{
+		0u,  421212481u,  842424962u,  724390851u, 1684849924u, 2105013317u, 1448781702u, 1329698503u,
+		3369699848u, 3519200073u, 4210026634u, 3824474571u, 2897563404u, 3048111693u, 2659397006u, 2274893007u,
+		1254232657u, 1406739216u, 2029285587u, 1643069842u,  783210325u,  934667796u,  479770071u,   92505238u,
+		2182846553u, 2600511768u, 2955803355u, 2838940570u, 3866582365u, 4285295644u, 3561045983u, 3445231262u,
+		2508465314u, 2359236067u, 2813478432u, 3198777185u, 4058571174u, 3908292839u, 3286139684u, 3670389349u,
+		1566420650u, 1145479147u, 1869335592u, 1987116393u,  959540142u,  539646703u,  185010476u,  303839341u,
+		3745920755u, 3327985586u, 3983561841u, 4100678960u, 3140154359u, 2721170102u, 2300350837u, 2416418868u,
+		396344571u,  243568058u,  631889529u, 1018359608u, 1945336319u, 1793607870u, 1103436669u, 1490954812u,
+		4034481925u, 3915546180u, 3259968903u, 3679722694u, 2484439553u, 2366552896u, 2787371139u, 3208174018u,
+		950060301u,  565965900u,  177645455u,  328046286u, 1556873225u, 1171730760u, 1861902987u, 2011255754u,
+		3132841300u, 2745199637u, 2290958294u, 2442530455u, 3738671184u, 3352078609u, 3974232786u, 4126854035u,
+		1919080284u, 1803150877u, 1079293406u, 1498383519u,  370020952u,  253043481u,  607678682u, 1025720731u,
+		1711106983u, 2095471334u, 1472923941u, 1322268772u,   26324643u,  411738082u,  866634785u,  717028704u,
+		2904875439u, 3024081134u, 2668790573u, 2248782444u, 3376948395u, 3495106026u, 4219356713u, 3798300520u,
+		792689142u,  908347575u,  487136116u,   68299317u, 1263779058u, 1380486579u, 2036719216u, 1618931505u,
+		3890672638u, 4278043327u, 3587215740u, 3435896893u, 2206873338u, 2593195963u, 2981909624u, 2829542713u,
+		998479947u,  580430090u,  162921161u,  279890824u, 1609522511u, 1190423566u, 1842954189u, 1958874764u,
+		4082766403u, 3930137346u, 3245109441u, 3631694208u, 2536953671u, 2385372678u, 2768287173u, 3155920004u,
+		1900120602u, 1750776667u, 1131931800u, 1517083097u,  355290910u,  204897887u,  656092572u, 1040194781u,
+		3113746450u, 2692952403u, 2343461520u, 2461357009u, 3723805974u, 3304059991u, 4022511508u, 4141455061u,
+		2919742697u, 3072101800u, 2620513899u, 2234183466u, 3396041197u, 3547351212u, 4166851439u, 3779471918u,
+		1725839073u, 2143618976u, 1424512099u, 1307796770u,   45282277u,  464110244u,  813994343u,  698327078u,
+		3838160568u, 4259225593u, 3606301754u, 3488152955u, 2158586812u, 2578602749u, 2996767038u, 2877569151u,
+		740041904u,  889656817u,  506086962u,  120682355u, 1215357364u, 1366020341u, 2051441462u, 1667084919u,
+		3422213966u, 3538019855u, 4190942668u, 3772220557u, 2945847882u, 3062702859u, 2644537544u, 2226864521u,
+		52649286u,  439905287u,  823476164u,  672009861u, 1733269570u, 2119477507u, 1434057408u, 1281543041u,
+		2167981343u, 2552493150u, 3004082077u, 2853541596u, 3847487515u, 4233048410u, 3613549209u, 3464057816u,
+		1239502615u, 1358593622u, 2077699477u, 1657543892u,  764250643u,  882293586u,  532408465u,  111204816u,
+		1585378284u, 1197851309u, 1816695150u, 1968414767u,  974272232u,  587794345u,  136598634u,  289367339u,
+		2527558116u, 2411481253u, 2760973158u, 3179948583u, 4073438432u, 3956313505u, 3237863010u, 3655790371u,
+		347922877u,  229101820u,  646611775u, 1066513022u, 1892689081u, 1774917112u, 1122387515u, 1543337850u,
+		3697634229u, 3313392372u, 3998419255u, 4148705398u, 3087642289u, 2702352368u, 2319436851u, 2468674930u
+	},
+	{
+		0u,   29518391u,   59036782u,   38190681u,  118073564u,  114017003u,   76381362u,   89069189u,
+		236147128u,  265370511u,  228034006u,  206958561u,  152762724u,  148411219u,  178138378u,  190596925u,
+		472294256u,  501532999u,  530741022u,  509615401u,  456068012u,  451764635u,  413917122u,  426358261u,
+		305525448u,  334993663u,  296822438u,  275991697u,  356276756u,  352202787u,  381193850u,  393929805u,
+		944588512u,  965684439u, 1003065998u,  973863097u, 1061482044u, 1049003019u, 1019230802u, 1023561829u,
+		912136024u,  933002607u,  903529270u,  874031361u,  827834244u,  815125939u,  852716522u,  856752605u,
+		611050896u,  631869351u,  669987326u,  640506825u,  593644876u,  580921211u,  551983394u,  556069653u,
+		712553512u,  733666847u,  704405574u,  675154545u,  762387700u,  749958851u,  787859610u,  792175277u,
+		1889177024u, 1901651959u, 1931368878u, 1927033753u, 2006131996u, 1985040171u, 1947726194u, 1976933189u,
+		2122964088u, 2135668303u, 2098006038u, 2093965857u, 2038461604u, 2017599123u, 2047123658u, 2076625661u,
+		1824272048u, 1836991623u, 1866005214u, 1861914857u, 1807058540u, 1786244187u, 1748062722u, 1777547317u,
+		1655668488u, 1668093247u, 1630251878u, 1625932113u, 1705433044u, 1684323811u, 1713505210u, 1742760333u,
+		1222101792u, 1226154263u, 1263738702u, 1251046777u, 1339974652u, 1310460363u, 1281013650u, 1301863845u,
+		1187289752u, 1191637167u, 1161842422u, 1149379777u, 1103966788u, 1074747507u, 1112139306u, 1133218845u,
+		1425107024u, 1429406311u, 1467333694u, 1454888457u, 1408811148u, 1379576507u, 1350309090u, 1371438805u,
+		1524775400u, 1528845279u, 1499917702u, 1487177649u, 1575719220u, 1546255107u, 1584350554u, 1605185389u,
+		3778354048u, 3774312887u, 3803303918u, 3816007129u, 3862737756u, 3892238699u, 3854067506u, 3833203973u,
+		4012263992u, 4007927823u, 3970080342u, 3982554209u, 3895452388u, 3924658387u, 3953866378u, 3932773565u,
+		4245928176u, 4241609415u, 4271336606u, 4283762345u, 4196012076u, 4225268251u, 4187931714u, 4166823541u,
+		4076923208u, 4072833919u, 4035198246u, 4047918865u, 4094247316u, 4123732899u, 4153251322u, 4132437965u,
+		3648544096u, 3636082519u, 3673983246u, 3678331705u, 3732010428u, 3753090955u, 3723829714u, 3694611429u,
+		3614117080u, 3601426159u, 3572488374u, 3576541825u, 3496125444u, 3516976691u, 3555094634u, 3525581405u,
+		3311336976u, 3298595879u, 3336186494u, 3340255305u, 3260503756u, 3281337595u, 3251864226u, 3222399125u,
+		3410866088u, 3398419871u, 3368647622u, 3372945905u, 3427010420u, 3448139075u, 3485520666u, 3456284973u,
+		2444203584u, 2423127159u, 2452308526u, 2481530905u, 2527477404u, 2539934891u, 2502093554u, 2497740997u,
+		2679949304u, 2659102159u, 2620920726u, 2650438049u, 2562027300u, 2574714131u, 2603727690u, 2599670141u,
+		2374579504u, 2353749767u, 2383274334u, 2412743529u, 2323684844u, 2336421851u, 2298759554u, 2294686645u,
+		2207933576u, 2186809023u, 2149495014u, 2178734801u, 2224278612u, 2236720739u, 2266437690u, 2262135309u,
+		2850214048u, 2820717207u, 2858812622u, 2879680249u, 2934667388u, 2938704459u, 2909776914u, 2897069605u,
+		2817622296u, 2788420399u, 2759153014u, 2780249921u, 2700618180u, 2704950259u, 2742877610u, 2730399645u,
+		3049550800u, 3020298727u, 3057690558u, 3078802825u, 2999835404u, 3004150075u, 2974355298u, 2961925461u,
+		3151438440u, 3121956959u, 3092510214u, 3113327665u, 3168701108u, 3172786307u, 3210370778u, 3197646061u
+	},
+	{
+		0u, 3099354981u, 2852767883u,  313896942u, 2405603159u,  937357362u,  627793884u, 2648127673u,
+		3316918511u, 2097696650u, 1874714724u, 3607201537u, 1255587768u, 4067088605u, 3772741427u, 1482887254u,
+		1343838111u, 3903140090u, 4195393300u, 1118632049u, 3749429448u, 1741137837u, 1970407491u, 3452858150u,
+		2511175536u,  756094997u, 1067759611u, 2266550430u,  449832999u, 2725482306u, 2965774508u,  142231497u,
+		2687676222u,  412010587u,  171665333u, 2995192016u,  793786473u, 2548850444u, 2237264098u, 1038456711u,
+		1703315409u, 3711623348u, 3482275674u, 1999841343u, 3940814982u, 1381529571u, 1089329165u, 4166106984u,
+		4029413537u, 1217896388u, 1512189994u, 3802027855u, 2135519222u, 3354724499u, 3577784189u, 1845280792u,
+		899665998u, 2367928107u, 2677414085u,  657096608u, 3137160985u,   37822588u,  284462994u, 2823350519u,
+		2601801789u,  598228824u,  824021174u, 2309093331u,  343330666u, 2898962447u, 3195996129u,  113467524u,
+		1587572946u, 3860600759u, 4104763481u, 1276501820u, 3519211397u, 1769898208u, 2076913422u, 3279374443u,
+		3406630818u, 1941006535u, 1627703081u, 3652755532u, 1148164341u, 4241751952u, 3999682686u, 1457141531u,
+		247015245u, 3053797416u, 2763059142u,  470583459u, 2178658330u,  963106687u,  735213713u, 2473467892u,
+		992409347u, 2207944806u, 2435792776u,  697522413u, 3024379988u,  217581361u,  508405983u, 2800865210u,
+		4271038444u, 1177467017u, 1419450215u, 3962007554u, 1911572667u, 3377213406u, 3690561584u, 1665525589u,
+		1799331996u, 3548628985u, 3241568279u, 2039091058u, 3831314379u, 1558270126u, 1314193216u, 4142438437u,
+		2928380019u,  372764438u,   75645176u, 3158189981u,  568925988u, 2572515393u, 2346768303u,  861712586u,
+		3982079547u, 1441124702u, 1196457648u, 4293663189u, 1648042348u, 3666298377u, 3358779879u, 1888390786u,
+		686661332u, 2421291441u, 2196002399u,  978858298u, 2811169155u,  523464422u,  226935048u, 3040519789u,
+		3175145892u,  100435649u,  390670639u, 2952089162u,  841119475u, 2325614998u, 2553003640u,  546822429u,
+		2029308235u, 3225988654u, 3539796416u, 1782671013u, 4153826844u, 1328167289u, 1570739863u, 3844338162u,
+		1298864389u, 4124540512u, 3882013070u, 1608431339u, 3255406162u, 2058742071u, 1744848601u, 3501990332u,
+		2296328682u,  811816591u,  584513889u, 2590678532u,  129869501u, 3204563416u, 2914283062u,  352848211u,
+		494030490u, 2781751807u, 3078325777u,  264757620u, 2450577869u,  715964072u,  941166918u, 2158327331u,
+		3636881013u, 1618608400u, 1926213374u, 3396585883u, 1470427426u, 4011365959u, 4255988137u, 1158766284u,
+		1984818694u, 3471935843u, 3695453837u, 1693991400u, 4180638033u, 1100160564u, 1395044826u, 3952793279u,
+		3019491049u,  189112716u,  435162722u, 2706139399u, 1016811966u, 2217162459u, 2526189877u,  774831696u,
+		643086745u, 2666061564u, 2354934034u,  887166583u, 2838900430u,  294275499u,   54519365u, 3145957664u,
+		3823145334u, 1532818963u, 1240029693u, 4048895640u, 1820460577u, 3560857924u, 3331051178u, 2117577167u,
+		3598663992u, 1858283101u, 2088143283u, 3301633750u, 1495127663u, 3785470218u, 4078182116u, 1269332353u,
+		332098007u, 2876706482u, 3116540252u,   25085497u, 2628386432u,  605395429u,  916469259u, 2384220526u,
+		2254837415u, 1054503362u,  745528876u, 2496903497u,  151290352u, 2981684885u, 2735556987u,  464596510u,
+		1137851976u, 4218313005u, 3923506883u, 1365741990u, 3434129695u, 1946996346u, 1723425172u, 3724871409u
+	},
+	{
+		0u, 1029712304u, 2059424608u, 1201699536u, 4118849216u, 3370159984u, 2403399072u, 2988497936u,
+		812665793u,  219177585u, 1253054625u, 2010132753u, 3320900865u, 4170237105u, 3207642721u, 2186319825u,
+		1625331586u, 1568718386u,  438355170u,  658566482u, 2506109250u, 2818578674u, 4020265506u, 3535817618u,
+		1351670851u, 1844508147u,  709922595u,  389064339u, 2769320579u, 2557498163u, 3754961379u, 3803185235u,
+		3250663172u, 4238411444u, 3137436772u, 2254525908u,  876710340u,  153198708u, 1317132964u, 1944187668u,
+		4054934725u, 3436268917u, 2339452837u, 3054575125u,   70369797u,  961670069u, 2129760613u, 1133623509u,
+		2703341702u, 2621542710u, 3689016294u, 3867263574u, 1419845190u, 1774270454u,  778128678u,  318858390u,
+		2438067015u, 2888948471u, 3952189479u, 3606153623u, 1691440519u, 1504803895u,  504432359u,  594620247u,
+		1492342857u, 1704161785u,  573770537u,  525542041u, 2910060169u, 2417219385u, 3618876905u, 3939730521u,
+		1753420680u, 1440954936u,  306397416u,  790849880u, 2634265928u, 2690882808u, 3888375336u, 3668168600u,
+		940822475u,   91481723u, 1121164459u, 2142483739u, 3448989963u, 4042473659u, 3075684971u, 2318603227u,
+		140739594u,  889433530u, 1923340138u, 1338244826u, 4259521226u, 3229813626u, 2267247018u, 3124975642u,
+		2570221389u, 2756861693u, 3824297005u, 3734113693u, 1823658381u, 1372780605u,  376603373u,  722643805u,
+		2839690380u, 2485261628u, 3548540908u, 4007806556u, 1556257356u, 1638052860u,  637716780u,  459464860u,
+		4191346895u, 3300051327u, 2199040943u, 3195181599u,  206718479u,  825388991u, 1989285231u, 1274166495u,
+		3382881038u, 4106388158u, 3009607790u, 2382549470u, 1008864718u,   21111934u, 1189240494u, 2072147742u,
+		2984685714u, 2357631266u, 3408323570u, 4131834434u, 1147541074u, 2030452706u, 1051084082u,   63335554u,
+		2174155603u, 3170292451u, 4216760371u, 3325460867u, 1947622803u, 1232499747u,  248909555u,  867575619u,
+		3506841360u, 3966111392u, 2881909872u, 2527485376u,  612794832u,  434546784u, 1581699760u, 1663499008u,
+		3782634705u, 3692447073u, 2612412337u, 2799048193u,  351717905u,  697754529u, 1849071985u, 1398190273u,
+		1881644950u, 1296545318u,  182963446u,  931652934u, 2242328918u, 3100053734u, 4284967478u, 3255255942u,
+		1079497815u, 2100821479u,  983009079u,  133672583u, 3050795671u, 2293717799u, 3474399735u, 4067887175u,
+		281479188u,  765927844u, 1778867060u, 1466397380u, 3846680276u, 3626469220u, 2676489652u, 2733102084u,
+		548881365u,  500656741u, 1517752501u, 1729575173u, 3577210133u, 3898068133u, 2952246901u, 2459410373u,
+		3910527195u, 3564487019u, 2480257979u, 2931134987u,  479546907u,  569730987u, 1716854139u, 1530213579u,
+		3647316762u, 3825568426u, 2745561210u, 2663766474u,  753206746u,  293940330u, 1445287610u, 1799716618u,
+		2314567513u, 3029685993u, 4080348217u, 3461678473u, 2088098201u, 1091956777u,  112560889u, 1003856713u,
+		3112514712u, 2229607720u, 3276105720u, 4263857736u, 1275433560u, 1902492648u,  918929720u,  195422344u,
+		685033439u,  364179055u, 1377080511u, 1869921551u, 3713294623u, 3761522863u, 2811507327u, 2599689167u,
+		413436958u,  633644462u, 1650777982u, 1594160846u, 3978570462u, 3494118254u, 2548332990u, 2860797966u,
+		1211387997u, 1968470509u,  854852413u,  261368461u, 3182753437u, 2161434413u, 3346310653u, 4195650637u,
+		2017729436u, 1160000044u,   42223868u, 1071931724u, 2378480988u, 2963576044u, 4144295484u, 3395602316u
+	},
+	{
+		0u, 3411858341u, 1304994059u, 2257875630u, 2609988118u, 1355649459u, 3596215069u,  486879416u,
+		3964895853u,  655315400u, 2711298918u, 1791488195u, 2009251963u, 3164476382u,  973758832u, 4048990933u,
+		64357019u, 3364540734u, 1310630800u, 2235723829u, 2554806413u, 1394316072u, 3582976390u,  517157411u,
+		4018503926u,  618222419u, 2722963965u, 1762783832u, 1947517664u, 3209171269u,  970744811u, 4068520014u,
+		128714038u, 3438335635u, 1248109629u, 2167961496u, 2621261600u, 1466012805u, 3522553387u,  447296910u,
+		3959392091u,  547575038u, 2788632144u, 1835791861u, 1886307661u, 3140622056u, 1034314822u, 4143626211u,
+		75106221u, 3475428360u, 1236444838u, 2196665603u, 2682996155u, 1421317662u, 3525567664u,  427767573u,
+		3895035328u,  594892389u, 2782995659u, 1857943406u, 1941489622u, 3101955187u, 1047553757u, 4113347960u,
+		257428076u, 3288652233u, 1116777319u, 2311878850u, 2496219258u, 1603640287u, 3640781169u,  308099796u,
+		3809183745u,  676813732u, 2932025610u, 1704983215u, 2023410199u, 3016104370u,  894593820u, 4262377657u,
+		210634999u, 3352484690u, 1095150076u, 2316991065u, 2535410401u, 1547934020u, 3671583722u,  294336591u,
+		3772615322u,  729897279u, 2903845777u, 1716123700u, 2068629644u, 2953845545u,  914647431u, 4258839074u,
+		150212442u, 3282623743u, 1161604689u, 2388688372u, 2472889676u, 1480171241u, 3735940167u,  368132066u,
+		3836185911u,  805002898u, 2842635324u, 1647574937u, 2134298401u, 3026852996u,  855535146u, 4188192143u,
+		186781121u, 3229539940u, 1189784778u, 2377547631u, 2427670487u, 1542429810u, 3715886812u,  371670393u,
+		3882979244u,  741170185u, 2864262823u, 1642462466u, 2095107514u, 3082559007u,  824732849u, 4201955092u,
+		514856152u, 3589064573u, 1400419795u, 2552522358u, 2233554638u, 1316849003u, 3370776517u,   62202976u,
+		4075001525u,  968836368u, 3207280574u, 1954014235u, 1769133219u, 2720925446u,  616199592u, 4024870413u,
+		493229635u, 3594175974u, 1353627464u, 2616354029u, 2264355925u, 1303087088u, 3409966430u,    6498043u,
+		4046820398u,  979978123u, 3170710821u, 2007099008u, 1789187640u, 2717386141u,  661419827u, 3962610838u,
+		421269998u, 3527459403u, 1423225061u, 2676515648u, 2190300152u, 1238466653u, 3477467891u,   68755798u,
+		4115633027u, 1041448998u, 3095868040u, 1943789869u, 1860096405u, 2776760880u,  588673182u, 3897205563u,
+		449450869u, 3516317904u, 1459794558u, 2623431131u, 2170245475u, 1242006214u, 3432247400u,  131015629u,
+		4137259288u, 1036337853u, 3142660115u, 1879958454u, 1829294862u, 2790523051u,  549483013u, 3952910752u,
+		300424884u, 3669282065u, 1545650111u, 2541513754u, 2323209378u, 1092980487u, 3350330793u,  216870412u,
+		4256931033u,  921128828u, 2960342482u, 2066738807u, 1714085583u, 2910195050u,  736264132u, 3770592353u,
+		306060335u, 3647131530u, 1610005796u, 2494197377u, 2309971513u, 1123257756u, 3295149874u,  255536279u,
+		4268596802u,  892423655u, 3013951305u, 2029645036u, 1711070292u, 2929725425u,  674528607u, 3815288570u,
+		373562242u, 3709388839u, 1535949449u, 2429577516u, 2379569556u, 1183418929u, 3223189663u,  188820282u,
+		4195850735u,  827017802u, 3084859620u, 2089020225u, 1636228089u, 2866415708u,  743340786u, 3876759895u,
+		361896217u, 3738094268u, 1482340370u, 2466671543u, 2382584591u, 1163888810u, 3284924932u,  144124321u,
+		4190215028u,  849168593u, 3020503679u, 2136336858u, 1649465698u, 2836138695u,  798521449u, 3838094284u
+	},
+	{
+		0u, 2792819636u, 2543784233u,  837294749u, 4098827283u, 1379413927u, 1674589498u, 3316072078u,
+		871321191u, 2509784531u, 2758827854u,   34034938u, 3349178996u, 1641505216u, 1346337629u, 4131942633u,
+		1742642382u, 3249117050u, 4030828007u, 1446413907u, 2475800797u,  904311657u,   68069876u, 2725880384u,
+		1412551337u, 4064729373u, 3283010432u, 1708771380u, 2692675258u,  101317902u,  937551763u, 2442587175u,
+		3485284764u, 1774858792u, 1478633653u, 4266992385u, 1005723023u, 2642744891u, 2892827814u,  169477906u,
+		4233263099u, 1512406095u, 1808623314u, 3451546982u,  136139752u, 2926205020u, 2676114113u,  972376437u,
+		2825102674u,  236236518u, 1073525883u, 2576072655u, 1546420545u, 4200303349u, 3417542760u, 1841601500u,
+		2609703733u, 1039917185u,  202635804u, 2858742184u, 1875103526u, 3384067218u, 4166835727u, 1579931067u,
+		1141601657u, 3799809741u, 3549717584u, 1977839588u, 2957267306u,  372464350u,  668680259u, 2175552503u,
+		2011446046u, 3516084394u, 3766168119u, 1175200131u, 2209029901u,  635180217u,  338955812u, 2990736784u,
+		601221559u, 2242044419u, 3024812190u,  306049834u, 3617246628u, 1911408144u, 1074125965u, 3866285881u,
+		272279504u, 3058543716u, 2275784441u,  567459149u, 3832906691u, 1107462263u, 1944752874u, 3583875422u,
+		2343980261u,  767641425u,  472473036u, 3126744696u, 2147051766u, 3649987394u, 3899029983u, 1309766251u,
+		3092841090u,  506333494u,  801510315u, 2310084639u, 1276520081u, 3932237093u, 3683203000u, 2113813516u,
+		3966292011u, 1243601823u, 2079834370u, 3716205238u,  405271608u, 3192979340u, 2411259153u,  701492901u,
+		3750207052u, 2045810168u, 1209569125u, 4000285905u,  734575199u, 2378150379u, 3159862134u,  438345922u,
+		2283203314u,  778166598u,  529136603u, 3120492655u, 2086260449u, 3660498261u, 3955679176u, 1303499900u,
+		3153699989u,  495890209u,  744928700u, 2316418568u, 1337360518u, 3921775410u, 3626602927u, 2120129051u,
+		4022892092u, 1237286280u, 2018993941u, 3726666913u,  461853231u, 3186645403u, 2350400262u,  711936178u,
+		3693557851u, 2052076527u, 1270360434u, 3989775046u,  677911624u, 2384402428u, 3220639073u,  427820757u,
+		1202443118u, 3789347034u, 3493118535u, 1984154099u, 3018127229u,  362020041u,  612099668u, 2181885408u,
+		1950653705u, 3526596285u, 3822816288u, 1168934804u, 2148251930u,  645706414u,  395618355u, 2984485767u,
+		544559008u, 2248295444u, 3085590153u,  295523645u, 3560598451u, 1917673479u, 1134918298u, 3855773998u,
+		328860103u, 3052210803u, 2214924526u,  577903450u, 3889505748u, 1101147744u, 1883911421u, 3594338121u,
+		3424493451u, 1785369663u, 1535282850u, 4260726038u,  944946072u, 2653270060u, 2949491377u,  163225861u,
+		4294103532u, 1501944408u, 1752023237u, 3457862513u,  196998655u, 2915761739u, 2619532502u,  978710370u,
+		2881684293u,  229902577u, 1012666988u, 2586515928u, 1603020630u, 4193987810u, 3356702335u, 1852063179u,
+		2553040162u, 1046169238u,  263412747u, 2848217023u, 1818454321u, 3390333573u, 4227627032u, 1569420204u,
+		60859927u, 2782375331u, 2487203646u,  843627658u, 4159668740u, 1368951216u, 1617990445u, 3322386585u,
+		810543216u, 2520310724u, 2815490393u,   27783917u, 3288386659u, 1652017111u, 1402985802u, 4125677310u,
+		1685994201u, 3255382381u, 4091620336u, 1435902020u, 2419138250u,  910562686u,  128847843u, 2715354199u,
+		1469150398u, 4058414858u, 3222168983u, 1719234083u, 2749255853u,   94984985u,  876691844u, 2453031472u
+	},
+	{
+		0u, 3433693342u, 1109723005u, 2391738339u, 2219446010u, 1222643300u, 3329165703u,  180685081u,
+		3555007413u,  525277995u, 2445286600u, 1567235158u, 1471092047u, 2600801745u,  361370162u, 3642757804u,
+		2092642603u, 2953916853u, 1050555990u, 4063508168u, 4176560081u,  878395215u, 3134470316u, 1987983410u,
+		2942184094u, 1676945920u, 3984272867u,  567356797u,  722740324u, 3887998202u, 1764827929u, 2778407815u,
+		4185285206u,  903635656u, 3142804779u, 2012833205u, 2101111980u, 2979425330u, 1058630609u, 4088621903u,
+		714308067u, 3862526333u, 1756790430u, 2753330688u, 2933487385u, 1651734407u, 3975966820u,  542535930u,
+		2244825981u, 1231508451u, 3353891840u,  188896414u,   25648519u, 3442302233u, 1134713594u, 2399689316u,
+		1445480648u, 2592229462u,  336416693u, 3634843435u, 3529655858u,  516441772u, 2420588879u, 1559052753u,
+		698204909u, 3845636723u, 1807271312u, 2803025166u, 2916600855u, 1635634313u, 4025666410u,  593021940u,
+		4202223960u,  919787974u, 3093159461u, 1962401467u, 2117261218u, 2996361020u, 1008193759u, 4038971457u,
+		1428616134u, 2576151384u,  386135227u, 3685348389u, 3513580860u,  499580322u, 2471098945u, 1608776415u,
+		2260985971u, 1248454893u, 3303468814u,  139259792u,   42591881u, 3458459159u, 1085071860u, 2349261162u,
+		3505103035u,  474062885u, 2463016902u, 1583654744u, 1419882049u, 2550902495u,  377792828u, 3660491170u,
+		51297038u, 3483679632u, 1093385331u, 2374089965u, 2269427188u, 1273935210u, 3311514249u,  164344343u,
+		2890961296u, 1627033870u, 4000683757u,  585078387u,  672833386u, 3836780532u, 1782552599u, 2794821769u,
+		2142603813u, 3005188795u, 1032883544u, 4047146438u, 4227826911u,  928351297u, 3118105506u, 1970307900u,
+		1396409818u, 2677114180u,  287212199u, 3719594553u, 3614542624u,  467372990u, 2505346141u, 1509854403u,
+		2162073199u, 1282711281u, 3271268626u,  240228748u,   76845205u, 3359543307u, 1186043880u, 2317064054u,
+		796964081u, 3811226735u, 1839575948u, 2702160658u, 2882189835u, 1734392469u, 3924802934u,  625327592u,
+		4234522436u,  818917338u, 3191908409u, 1927981223u, 2016387518u, 3028656416u,  973776579u, 4137723485u,
+		2857232268u, 1726474002u, 3899187441u,  616751215u,  772270454u, 3803048424u, 1814228491u, 2693328533u,
+		2041117753u, 3036871847u,  999160644u, 4146592730u, 4259508931u,  826864221u, 3217552830u, 1936586016u,
+		3606501031u,  442291769u, 2496909786u, 1484378436u, 1388107869u, 2652297411u,  278519584u, 3694387134u,
+		85183762u, 3384397196u, 1194773103u, 2342308593u, 2170143720u, 1307820918u, 3279733909u,  265733131u,
+		2057717559u, 3054258089u,  948125770u, 4096344276u, 4276898253u,  843467091u, 3167309488u, 1885556270u,
+		2839764098u, 1709792284u, 3949353983u,  667704161u,  755585656u, 3785577190u, 1865176325u, 2743489947u,
+		102594076u, 3401021058u, 1144549729u, 2291298815u, 2186770662u, 1325234296u, 3228729243u,  215514885u,
+		3589828009u,  424832311u, 2547870420u, 1534552650u, 1370645331u, 2635621325u,  328688686u, 3745342640u,
+		2211456353u, 1333405183u, 3254067740u,  224338562u,  127544219u, 3408931589u, 1170156774u, 2299866232u,
+		1345666772u, 2627681866u,  303053225u, 3736746295u, 3565105198u,  416624816u, 2522494803u, 1525692365u,
+		4285207626u,  868291796u, 3176010551u, 1910772649u, 2065767088u, 3079346734u,  956571085u, 4121828691u,
+		747507711u, 3760459617u, 1856702594u, 2717976604u, 2831417605u, 1684930971u, 3940615800u,  642451174u
+	}
 };
 
-/*Return the CRC of the bytes buf[0..len-1].*/
-unsigned lodepng_crc32(const unsigned char* data, size_t length)
+/*r is the running CRC, not yet inverted*/
+static unsigned lodepng_crc32_slice8(unsigned r, const unsigned char* data, size_t length)
 {
-	unsigned r = 0xffffffffu;
-	size_t i;
-	for (i = 0; i < length; ++i)
+	while (length >= 8)
 	{
-		r = lodepng_crc32_table[(r ^ data[i]) & 0xff] ^ (r >> 8);
+		unsigned one = r ^ ((unsigned)data[0] | ((unsigned)data[1] << 8) | ((unsigned)data[2] << 16) | ((unsigned)data[3] << 24));
+		unsigned two = (unsigned)data[4] | ((unsigned)data[5] << 8) | ((unsigned)data[6] << 16) | ((unsigned)data[7] << 24);
+		r = lodepng_crc32_table[7][one & 0xff] ^ lodepng_crc32_table[6][(one >> 8) & 0xff]
+			^ lodepng_crc32_table[5][(one >> 16) & 0xff] ^ lodepng_crc32_table[4][one >> 24]
+			^ lodepng_crc32_table[3][two & 0xff] ^ lodepng_crc32_table[2][(two >> 8) & 0xff]
+			^ lodepng_crc32_table[1][(two >> 16) & 0xff] ^ lodepng_crc32_table[0][two >> 24];
+		data += 8;
+		length -= 8;
 	}
-	return r ^ 0xffffffffu;
+	while (length--)
+	{
+		r = lodepng_crc32_table[0][(r ^ *data++) & 0xff] ^ (r >> 8);
+	}
+	return r;
+}
+
+#ifdef LODEPNG_X86_SIMD
+/*
+CRC by folding with carry-less multiplication, as in Intel's "Fast CRC Computation for Generic Polynomials
+Using PCLMULQDQ Instruction". Four 128 bit accumulators are folded forward 64 bytes at a time, then into one,
+then reduced to 32 bits with a Barrett reduction. The constants are x^n mod P for the fold distances, bit
+reflected like the polynomial. length must be at least 64 and a multiple of 16.
+*/
+static LODEPNG_TARGET("sse2,pclmul") unsigned lodepng_crc32_pclmul(unsigned r, const unsigned char* data, size_t length)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll); /*fold by 512 bits*/
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll); /*fold by 128 bits*/
+	const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124ll); /*64 to 32 bits*/
+	const __m128i poly = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll); /*P and mu for the Barrett reduction*/
+	const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + 0x00)), _mm_cvtsi32_si128((int)r));
+	x2 = _mm_loadu_si128((const __m128i*)(data + 0x10));
+	x3 = _mm_loadu_si128((const __m128i*)(data + 0x20));
+	x4 = _mm_loadu_si128((const __m128i*)(data + 0x30));
+	data += 64;
+	length -= 64;
+
+	x0 = k1k2;
+	while (length >= 64)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(data + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(data + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(data + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(data + 0x30)));
+		data += 64;
+		length -= 64;
+	}
+
+	/*fold the four accumulators into one*/
+	x0 = k3k4;
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	/*remaining 16 byte blocks*/
+	while (length >= 16)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)data)), x5);
+		data += 16;
+		length -= 16;
+	}
+
+	/*128 to 64 bits*/
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+	/*Barrett reduction to 32 bits*/
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+#endif /*LODEPNG_X86_SIMD*/
+
+/*Continue the CRC register r (not inverted) over the bytes data[0..length-1].*/
+static unsigned lodepng_crc32_update(unsigned r, const unsigned char* data, size_t length)
+{
+#ifdef LODEPNG_X86_SIMD
+	/*the folding needs a few blocks to get going, short chunks like IHDR and IEND aren't worth it*/
+	if (length >= 64 && (lodepng_cpu_features() & CPU_FEATURE_PCLMUL))
+	{
+		size_t folded = length & ~(size_t)15;
+		r = lodepng_crc32_pclmul(r, data, folded);
+		data += folded;
+		length -= folded;
+	}
+#endif
+	return lodepng_crc32_slice8(r, data, length);
+}
+
+/*Return the CRC of the bytes buf[0..len-1].*/
+unsigned lodepng_crc32(const unsigned char* data, size_t length)
+{
+	return lodepng_crc32_update(0xffffffffu, data, length) ^ 0xffffffffu;
 }
 #else /* !LODEPNG_NO_COMPILE_CRC */
 unsigned lodepng_crc32(const unsigned char* data, size_t length);
@@ -3962,6 +5285,236 @@ unsigned lodepng_inspect(unsigned* w, unsigned* h, LodePNGState* state,
 	return state->error;
 }
 
+#ifdef LODEPNG_X86_SIMD
+/*
+SIMD unfiltering for 3 and 4 bytes per pixel (RGB and RGBA at 8 bits). Sub, Average and Paeth depend on the
+pixel to the left, so those go one pixel per step with the left pixel kept in a register, except Sub which
+can use a prefix sum over a whole register. Up has no such dependency and goes 16 or 32 bytes at a time.
+Like in unfilterScanline, recon and scanline may be the same memory, so every byte is read before it is written.
+*/
+
+/*
+3 byte pixels are assembled in a register: going through memory there means a 4 byte load right after
+narrower stores, which can't be forwarded and stalls every pixel
+*/
+static LODEPNG_TARGET("sse2") __m128i loadPixel(const unsigned char* p, size_t bytewidth)
+{
+	unsigned v;
+	if (bytewidth == 4) memcpy(&v, p, 4);
+	else v = (unsigned)p[0] | ((unsigned)p[1] << 8) | ((unsigned)p[2] << 16);
+	return _mm_cvtsi32_si128((int)v);
+}
+
+static LODEPNG_TARGET("sse2") void storePixel(unsigned char* p, __m128i v, size_t bytewidth)
+{
+	unsigned x = (unsigned)_mm_cvtsi128_si32(v);
+	if (bytewidth == 4) memcpy(p, &x, 4);
+	else memcpy(p, &x, 3);
+}
+
+static LODEPNG_TARGET("sse2") void unfilterUpSSE2(unsigned char* recon, const unsigned char* scanline,
+	const unsigned char* precon, size_t length)
+{
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(precon + i));
+		_mm_storeu_si128((__m128i*)(recon + i), _mm_add_epi8(x, b));
+	}
+	for (; i != length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+static LODEPNG_TARGET("avx2") void unfilterUpAVX2(unsigned char* recon, const unsigned char* scanline,
+	const unsigned char* precon, size_t length)
+{
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(scanline + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(precon + i));
+		_mm256_storeu_si256((__m256i*)(recon + i), _mm256_add_epi8(x, b));
+	}
+	unfilterUpSSE2(recon + i, scanline + i, precon + i, length - i);
+}
+
+static LODEPNG_TARGET("sse2") void unfilterSubSSE2(unsigned char* recon, const unsigned char* scanline,
+	size_t bytewidth, size_t length)
+{
+	size_t i = 0;
+	__m128i a = _mm_setzero_si128();
+	if (bytewidth == 4)
+	{
+		/*prefix sum over 4 pixels: add the register shifted by one pixel, then by two, then the last pixel before*/
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, a);
+			_mm_storeu_si128((__m128i*)(recon + i), x);
+			a = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	}
+	for (; i + bytewidth <= length; i += bytewidth)
+	{
+		a = _mm_add_epi8(a, loadPixel(scanline + i, bytewidth));
+		storePixel(recon + i, a, bytewidth);
+	}
+}
+
+static LODEPNG_TARGET("ssse3") void unfilterSub3SSSE3(unsigned char* recon, const unsigned char* scanline, size_t length)
+{
+	/*4 pixels per step out of a 16 byte load, the last pixel is broadcast for the next step with pshufb*/
+	const __m128i last = _mm_setr_epi8(9, 10, 11, 9, 10, 11, 9, 10, 11, 9, 10, 11, -1, -1, -1, -1);
+	size_t i = 0;
+	__m128i a = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 12)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+		x = _mm_add_epi8(x, a);
+		/*12 bytes only, the 4 after them are the next pixels' input*/
+		_mm_storel_epi64((__m128i*)(recon + i), x);
+		storePixel(recon + i + 8, _mm_srli_si128(x, 8), 4);
+		a = _mm_shuffle_epi8(x, last);
+	}
+	for (; i + 3 <= length; i += 3)
+	{
+		a = _mm_add_epi8(a, loadPixel(scanline + i, 3));
+		storePixel(recon + i, a, 3);
+	}
+}
+
+/*4 bytes from a 3 byte pixel, the 4th is garbage that never gets stored. p + 4 must still be inside the scanline*/
+static LODEPNG_TARGET("sse2") __m128i loadPixelPadded(const unsigned char* p)
+{
+	unsigned v;
+	memcpy(&v, p, 4);
+	return _mm_cvtsi32_si128((int)v);
+}
+
+static LODEPNG_TARGET("sse2") __m128i avgPixel(__m128i a, __m128i b, __m128i x)
+{
+	/*pavgb rounds up, (a + b) >> 1 rounds down: subtract the carry that pavgb added*/
+	__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+	return _mm_add_epi8(avg, x);
+}
+
+static LODEPNG_TARGET("sse2") void unfilterAvgSSE2(unsigned char* recon, const unsigned char* scanline,
+	const unsigned char* precon, size_t bytewidth, size_t length)
+{
+	size_t i = 0;
+	__m128i a = _mm_setzero_si128();
+	/*the last pixel can't be loaded padded, all others can*/
+	for (; i + 4 <= length; i += bytewidth)
+	{
+		a = avgPixel(a, loadPixelPadded(precon + i), loadPixelPadded(scanline + i));
+		storePixel(recon + i, a, bytewidth);
+	}
+	for (; i + bytewidth <= length; i += bytewidth)
+	{
+		a = avgPixel(a, loadPixel(precon + i, bytewidth), loadPixel(scanline + i, bytewidth));
+		storePixel(recon + i, a, bytewidth);
+	}
+}
+
+/*
+Paeth on 16 bit lanes. With p = a + b - c: pa = |p - a| = |b - c|, pb = |p - b| = |a - c| and pc = |p - c|
+which is |(b - c) + (a - c)|. The predictor is whichever of a, b, c has the smallest distance, ties going in
+that order. abs is the only thing SSSE3 adds, SSE2 does it with max(x, -x).
+*/
+#define PAETH_PIXEL(ABS, LOADED_B, LOADED_X)\
+{\
+	__m128i b = _mm_unpacklo_epi8(LOADED_B, zero);\
+	__m128i x = _mm_unpacklo_epi8(LOADED_X, zero);\
+	__m128i pa = _mm_sub_epi16(b, c);\
+	__m128i pb = _mm_sub_epi16(a, c);\
+	__m128i pc = _mm_add_epi16(pa, pb);\
+	__m128i smallest, use_a, use_b, pred;\
+	pa = ABS(pa);\
+	pb = ABS(pb);\
+	pc = ABS(pc);\
+	smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));\
+	use_a = _mm_cmpeq_epi16(smallest, pa);\
+	use_b = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(smallest, pb));\
+	pred = _mm_or_si128(_mm_and_si128(use_a, a), _mm_andnot_si128(use_a, c));\
+	pred = _mm_or_si128(_mm_and_si128(use_b, b), _mm_andnot_si128(use_b, pred));\
+	/*16 bit lanes: wrap the sum to a byte before it becomes the next a*/\
+	a = _mm_and_si128(_mm_add_epi16(pred, x), lowbyte);\
+	storePixel(recon + i, _mm_packus_epi16(a, a), bytewidth);\
+	c = b;\
+}
+
+/*a and c start out as 0, which makes the first pixel come out as scanline + precon, as it should*/
+#define PAETH_LOOP(ABS)\
+	size_t i = 0;\
+	const __m128i zero = _mm_setzero_si128();\
+	const __m128i lowbyte = _mm_set1_epi16(0xff);\
+	__m128i a = zero, c = zero;\
+	for (; i + 4 <= length; i += bytewidth) PAETH_PIXEL(ABS, loadPixelPadded(precon + i), loadPixelPadded(scanline + i))\
+	for (; i + bytewidth <= length; i += bytewidth) PAETH_PIXEL(ABS, loadPixel(precon + i, bytewidth), loadPixel(scanline + i, bytewidth))
+
+static LODEPNG_TARGET("sse2") __m128i absSSE2(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static LODEPNG_TARGET("sse2") void unfilterPaethSSE2(unsigned char* recon, const unsigned char* scanline,
+	const unsigned char* precon, size_t bytewidth, size_t length)
+{
+	PAETH_LOOP(absSSE2)
+}
+
+static LODEPNG_TARGET("ssse3") void unfilterPaethSSSE3(unsigned char* recon, const unsigned char* scanline,
+	const unsigned char* precon, size_t bytewidth, size_t length)
+{
+	PAETH_LOOP(_mm_abs_epi16)
+}
+#undef PAETH_LOOP
+#undef PAETH_PIXEL
+
+/*
+returns 1 if the scanline was unfiltered here. Otherwise the scalar code does it: other pixel sizes,
+the first scanline, CPUs without SSE2
+*/
+static unsigned unfilterScanlineSIMD(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+	size_t bytewidth, unsigned char filterType, size_t length)
+{
+	unsigned features = lodepng_cpu_features();
+	if (!(features & CPU_FEATURE_SSE2)) return 0;
+	/*only Sub can be done without a previous scanline, the others are trivial then anyway*/
+	if (!precon && filterType != 1) return 0;
+
+	/*Up doesn't care about the pixel size*/
+	if (filterType == 2)
+	{
+		if (features & CPU_FEATURE_AVX2) unfilterUpAVX2(recon, scanline, precon, length);
+		else unfilterUpSSE2(recon, scanline, precon, length);
+		return 1;
+	}
+
+	if ((bytewidth != 3 && bytewidth != 4) || length % bytewidth != 0) return 0;
+
+	switch (filterType)
+	{
+	case 1:
+		if (bytewidth == 3 && (features & CPU_FEATURE_SSSE3)) unfilterSub3SSSE3(recon, scanline, length);
+		else unfilterSubSSE2(recon, scanline, bytewidth, length);
+		return 1;
+	case 3:
+		unfilterAvgSSE2(recon, scanline, precon, bytewidth, length);
+		return 1;
+	case 4:
+		if (features & CPU_FEATURE_SSSE3) unfilterPaethSSSE3(recon, scanline, precon, bytewidth, length);
+		else unfilterPaethSSE2(recon, scanline, precon, bytewidth, length);
+		return 1;
+	default: return 0;
+	}
+}
+#endif /*LODEPNG_X86_SIMD*/
+
 static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
 	size_t bytewidth, unsigned char filterType, size_t length)
 {
@@ -3975,6 +5528,9 @@ static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scan
 	*/
 
 	size_t i;
+#ifdef LODEPNG_X86_SIMD
+	if (unfilterScanlineSIMD(recon, scanline, precon, bytewidth, filterType, length)) return 0;
+#endif
 	switch (filterType)
 	{
 	case 0:
@@ -4514,25 +6070,135 @@ static unsigned readChunk_pHYs(LodePNGInfo* info, const unsigned char* data, siz
 }
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
-static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
-	LodePNGState* state,
-	const unsigned char* in, size_t insize)
+/*
+Reads a chunk that isn't IHDR, IDAT or IEND into the state. Sets *unknown if the chunk type isn't one
+that's read, critical_pos tells where unknown chunks were: 1 = after IHDR, 2 = after PLTE, 3 = after IDAT.
+*/
+static unsigned readChunk(LodePNGState* state, const unsigned char* chunk, unsigned* critical_pos, unsigned* unknown)
 {
-	unsigned char IEND = 0;
-	const unsigned char* chunk;
-	size_t i;
-	ucvector idat; /*the data from idat chunks*/
-	ucvector scanlines;
-	size_t predict;
-	size_t numpixels;
-	size_t outsize = 0;
+	unsigned error = 0;
+	unsigned chunkLength = lodepng_chunk_length(chunk);
+	const unsigned char* data = lodepng_chunk_data_const(chunk);
 
-	/*for unknown chunk order*/
-	unsigned unknown = 0;
+	*unknown = 0;
+	/*palette chunk (PLTE)*/
+	if (lodepng_chunk_type_equals(chunk, "PLTE"))
+	{
+		error = readChunk_PLTE(&state->info_png.color, data, chunkLength);
+		if (error) return error;
+		*critical_pos = 2;
+	}
+	/*palette transparency chunk (tRNS)*/
+	else if (lodepng_chunk_type_equals(chunk, "tRNS"))
+	{
+		error = readChunk_tRNS(&state->info_png.color, data, chunkLength);
+		if (error) return error;
+	}
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
-	unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
+	/*background color chunk (bKGD)*/
+	else if (lodepng_chunk_type_equals(chunk, "bKGD"))
+	{
+		error = readChunk_bKGD(&state->info_png, data, chunkLength);
+		if (error) return error;
+	}
+	/*text chunk (tEXt)*/
+	else if (lodepng_chunk_type_equals(chunk, "tEXt"))
+	{
+		if (state->decoder.read_text_chunks)
+		{
+			error = readChunk_tEXt(&state->info_png, data, chunkLength);
+			if (error) return error;
+		}
+	}
+	/*compressed text chunk (zTXt)*/
+	else if (lodepng_chunk_type_equals(chunk, "zTXt"))
+	{
+		if (state->decoder.read_text_chunks)
+		{
+			error = readChunk_zTXt(&state->info_png, &state->decoder.zlibsettings, data, chunkLength);
+			if (error) return error;
+		}
+	}
+	/*international text chunk (iTXt)*/
+	else if (lodepng_chunk_type_equals(chunk, "iTXt"))
+	{
+		if (state->decoder.read_text_chunks)
+		{
+			error = readChunk_iTXt(&state->info_png, &state->decoder.zlibsettings, data, chunkLength);
+			if (error) return error;
+		}
+	}
+	else if (lodepng_chunk_type_equals(chunk, "tIME"))
+	{
+		error = readChunk_tIME(&state->info_png, data, chunkLength);
+		if (error) return error;
+	}
+	else if (lodepng_chunk_type_equals(chunk, "pHYs"))
+	{
+		error = readChunk_pHYs(&state->info_png, data, chunkLength);
+		if (error) return error;
+	}
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
+	else /*it's not an implemented chunk type, so ignore it: skip over the data*/
+	{
+		/*error: unknown critical chunk (5th bit of first byte of chunk type is 0)*/
+		if (!lodepng_chunk_ancillary(chunk)) return 69;
+
+		*unknown = 1;
+#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
+		if (state->decoder.remember_unknown_chunks)
+		{
+			error = lodepng_chunk_append(&state->info_png.unknown_chunks_data[*critical_pos - 1],
+				&state->info_png.unknown_chunks_size[*critical_pos - 1], chunk);
+			if (error) return error;
+		}
+#endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
+	}
+
+	return error;
+}
+
+/*size of the decompressed IDAT data, the filtered scanlines of all passes including their filter bytes*/
+static size_t predictScanlinesSize(unsigned w, unsigned h, const LodePNGInfo* info_png)
+{
+	const LodePNGColorMode* color = &info_png->color;
+	size_t predict = 0;
+	if (info_png->interlace_method == 0)
+	{
+		/*The extra h is added because this are the filter bytes every scanline starts with*/
+		predict = lodepng_get_raw_size_idat(w, h, color) + h;
+	}
+	else
+	{
+		/*Adam-7 interlaced: predicted size is the sum of the 7 sub-images sizes*/
+		predict += lodepng_get_raw_size_idat((w + 7) >> 3, (h + 7) >> 3, color) + ((h + 7) >> 3);
+		if (w > 4) predict += lodepng_get_raw_size_idat((w + 3) >> 3, (h + 7) >> 3, color) + ((h + 7) >> 3);
+		predict += lodepng_get_raw_size_idat((w + 3) >> 2, (h + 3) >> 3, color) + ((h + 3) >> 3);
+		if (w > 2) predict += lodepng_get_raw_size_idat((w + 1) >> 2, (h + 3) >> 2, color) + ((h + 3) >> 2);
+		predict += lodepng_get_raw_size_idat((w + 1) >> 1, (h + 1) >> 2, color) + ((h + 1) >> 2);
+		if (w > 1) predict += lodepng_get_raw_size_idat((w + 0) >> 1, (h + 1) >> 1, color) + ((h + 1) >> 1);
+		predict += lodepng_get_raw_size_idat((w + 0), (h + 0) >> 1, color) + ((h + 0) >> 1);
+	}
+	return predict;
+}
+
+/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
+static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize)
+{
+	unsigned char IEND = 0;
+	const unsigned char* chunk;
+	size_t i;
+	ucvector idat; /*the data from idat chunks*/
+	ucvector scanlines;
+	size_t predict;
+	size_t numpixels;
+	size_t outsize = 0;
+
+	/*for unknown chunk order*/
+	unsigned unknown = 0;
+	unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
 
 							   /*provide some proper output values if error will happen*/
 	*out = 0;
@@ -4572,6 +6238,7 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 		}
 
 		data = lodepng_chunk_data_const(chunk);
+		unknown = 0;
 
 		/*IDAT chunk, containing compressed image data*/
 		if (lodepng_chunk_type_equals(chunk, "IDAT"))
@@ -4579,90 +6246,18 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 			size_t oldsize = idat.size;
 			if (!ucvector_resize(&idat, oldsize + chunkLength)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
 			for (i = 0; i != chunkLength; ++i) idat.data[oldsize + i] = data[i];
-#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
 			critical_pos = 3;
-#endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 		}
 		/*IEND chunk*/
 		else if (lodepng_chunk_type_equals(chunk, "IEND"))
 		{
 			IEND = 1;
 		}
-		/*palette chunk (PLTE)*/
-		else if (lodepng_chunk_type_equals(chunk, "PLTE"))
-		{
-			state->error = readChunk_PLTE(&state->info_png.color, data, chunkLength);
-			if (state->error) break;
-#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
-			critical_pos = 2;
-#endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
-		}
-		/*palette transparency chunk (tRNS)*/
-		else if (lodepng_chunk_type_equals(chunk, "tRNS"))
-		{
-			state->error = readChunk_tRNS(&state->info_png.color, data, chunkLength);
-			if (state->error) break;
-		}
-#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
-		/*background color chunk (bKGD)*/
-		else if (lodepng_chunk_type_equals(chunk, "bKGD"))
-		{
-			state->error = readChunk_bKGD(&state->info_png, data, chunkLength);
-			if (state->error) break;
-		}
-		/*text chunk (tEXt)*/
-		else if (lodepng_chunk_type_equals(chunk, "tEXt"))
-		{
-			if (state->decoder.read_text_chunks)
-			{
-				state->error = readChunk_tEXt(&state->info_png, data, chunkLength);
-				if (state->error) break;
-			}
-		}
-		/*compressed text chunk (zTXt)*/
-		else if (lodepng_chunk_type_equals(chunk, "zTXt"))
-		{
-			if (state->decoder.read_text_chunks)
-			{
-				state->error = readChunk_zTXt(&state->info_png, &state->decoder.zlibsettings, data, chunkLength);
-				if (state->error) break;
-			}
-		}
-		/*international text chunk (iTXt)*/
-		else if (lodepng_chunk_type_equals(chunk, "iTXt"))
-		{
-			if (state->decoder.read_text_chunks)
-			{
-				state->error = readChunk_iTXt(&state->info_png, &state->decoder.zlibsettings, data, chunkLength);
-				if (state->error) break;
-			}
-		}
-		else if (lodepng_chunk_type_equals(chunk, "tIME"))
-		{
-			state->error = readChunk_tIME(&state->info_png, data, chunkLength);
-			if (state->error) break;
-		}
-		else if (lodepng_chunk_type_equals(chunk, "pHYs"))
+		else
 		{
-			state->error = readChunk_pHYs(&state->info_png, data, chunkLength);
+			state->error = readChunk(state, chunk, &critical_pos, &unknown);
 			if (state->error) break;
 		}
-#endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
-		else /*it's not an implemented chunk type, so ignore it: skip over the data*/
-		{
-			/*error: unknown critical chunk (5th bit of first byte of chunk type is 0)*/
-			if (!lodepng_chunk_ancillary(chunk)) CERROR_BREAK(state->error, 69);
-
-			unknown = 1;
-#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
-			if (state->decoder.remember_unknown_chunks)
-			{
-				state->error = lodepng_chunk_append(&state->info_png.unknown_chunks_data[critical_pos - 1],
-					&state->info_png.unknown_chunks_size[critical_pos - 1], chunk);
-				if (state->error) break;
-			}
-#endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
-		}
 
 		if (!state->decoder.ignore_crc && !unknown) /*check CRC if wanted, only on known chunk types*/
 		{
@@ -4675,24 +6270,7 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 	ucvector_init(&scanlines);
 	/*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
 	If the decompressed size does not match the prediction, the image must be corrupt.*/
-	if (state->info_png.interlace_method == 0)
-	{
-		/*The extra *h is added because this are the filter bytes every scanline starts with*/
-		predict = lodepng_get_raw_size_idat(*w, *h, &state->info_png.color) + *h;
-	}
-	else
-	{
-		/*Adam-7 interlaced: predicted size is the sum of the 7 sub-images sizes*/
-		const LodePNGColorMode* color = &state->info_png.color;
-		predict = 0;
-		predict += lodepng_get_raw_size_idat((*w + 7) >> 3, (*h + 7) >> 3, color) + ((*h + 7) >> 3);
-		if (*w > 4) predict += lodepng_get_raw_size_idat((*w + 3) >> 3, (*h + 7) >> 3, color) + ((*h + 7) >> 3);
-		predict += lodepng_get_raw_size_idat((*w + 3) >> 2, (*h + 3) >> 3, color) + ((*h + 3) >> 3);
-		if (*w > 2) predict += lodepng_get_raw_size_idat((*w + 1) >> 2, (*h + 3) >> 2, color) + ((*h + 3) >> 2);
-		predict += lodepng_get_raw_size_idat((*w + 1) >> 1, (*h + 1) >> 2, color) + ((*h + 1) >> 2);
-		if (*w > 1) predict += lodepng_get_raw_size_idat((*w + 0) >> 1, (*h + 1) >> 1, color) + ((*h + 1) >> 1);
-		predict += lodepng_get_raw_size_idat((*w + 0), (*h + 0) >> 1, color) + ((*h + 0) >> 1);
-	}
+	predict = predictScanlinesSize(*w, *h, &state->info_png);
 	if (!state->error && !ucvector_reserve(&scanlines, predict)) state->error = 83; /*alloc fail*/
 	if (!state->error)
 	{
@@ -4808,6 +6386,382 @@ unsigned lodepng_decode24_file(unsigned char** out, unsigned* w, unsigned* h, co
 }
 #endif /*LODEPNG_COMPILE_DISK*/
 
+/*
+The streaming decoder walks the chunk structure as the bytes come in. IDAT data goes straight on to a
+ZlibStream and from there into two scanline buffers, all other chunks are collected whole and read like
+decodeGeneric does.
+*/
+typedef enum LodePNGStreamPhase
+{
+	STREAM_SIGNATURE, STREAM_CHUNK_HEADER, STREAM_CHUNK, STREAM_IDAT, STREAM_IDAT_CRC, STREAM_END
+} LodePNGStreamPhase;
+
+struct LodePNGStreamDecoder
+{
+	LodePNGState* state;
+	LodePNGRowCallback callback;
+	void* user;
+	unsigned bottom_up;
+	unsigned w, h;
+
+	LodePNGStreamPhase phase;
+	ucvector chunk; /*what's there of the signature, a chunk header or a whole chunk other than IDAT*/
+	size_t need; /*size chunk has to reach, or the IDAT data left in STREAM_IDAT*/
+	unsigned chunks; /*chunks read so far, the first must be IHDR*/
+	unsigned critical_pos;
+	unsigned crc; /*CRC register of the IDAT chunk being read*/
+
+	ZlibStream zs;
+	unsigned rows_ready; /*set up at the first IDAT, the palette is known by then*/
+	unsigned convert; /*the rows go through lodepng_convert*/
+	size_t linebytes; /*bytes per row, without the filter byte*/
+	size_t bytewidth;
+	unsigned char* scanline; /*current and previous scanline, each with its filter byte*/
+	unsigned char* converted; /*a row in the info_raw color mode*/
+	size_t filled; /*bytes of the current scanline there so far*/
+	unsigned y; /*row the current scanline belongs to*/
+	ucvector interlaced; /*Adam7 images are decompressed whole and deinterlaced at the end*/
+};
+
+static unsigned streamEmitRow(LodePNGStreamDecoder* dec, const unsigned char* row, unsigned y)
+{
+	LodePNGState* state = dec->state;
+	if (dec->convert)
+	{
+		unsigned error = lodepng_convert(dec->converted, row, &state->info_raw, &state->info_png.color, dec->w, 1);
+		if (error) return error;
+		row = dec->converted;
+	}
+	return dec->callback(dec->user, row, dec->bottom_up ? dec->h - 1 - y : y, dec->w, dec->h);
+}
+
+static unsigned streamBeginRows(LodePNGStreamDecoder* dec)
+{
+	LodePNGState* state = dec->state;
+	const LodePNGColorMode* color = &state->info_png.color;
+	unsigned bpp = lodepng_get_bpp(color);
+	unsigned error;
+
+	if (!state->decoder.color_convert)
+	{
+		/*like lodepng_decode, info_raw tells the color type of the rows*/
+		error = lodepng_color_mode_copy(&state->info_raw, color);
+		if (error) return error;
+	}
+	dec->convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, color);
+	if (dec->convert)
+	{
+		if (!(state->info_raw.colortype == LCT_RGB || state->info_raw.colortype == LCT_RGBA)
+			&& !(state->info_raw.bitdepth == 8))
+		{
+			return 56; /*unsupported color mode conversion*/
+		}
+		dec->converted = (unsigned char*)lodepng_malloc(lodepng_get_raw_size(dec->w, 1, &state->info_raw));
+		if (!dec->converted) return 83; /*alloc fail*/
+	}
+
+	dec->linebytes = lodepng_get_raw_size_idat(dec->w, 1, color);
+	dec->bytewidth = (bpp + 7) / 8;
+	dec->scanline = (unsigned char*)lodepng_malloc(2 * (1 + dec->linebytes));
+	if (!dec->scanline) return 83; /*alloc fail*/
+
+	error = zlibStream_init(&dec->zs);
+	dec->rows_ready = 1;
+	return error;
+}
+
+/*takes decompressed data: unfilters it scanline by scanline, or keeps it for deinterlacing*/
+static unsigned streamScanlines(LodePNGStreamDecoder* dec, const unsigned char* data, size_t size)
+{
+	LodePNGState* state = dec->state;
+	size_t stride = 1 + dec->linebytes;
+
+	if (state->info_png.interlace_method != 0)
+	{
+		size_t oldsize = dec->interlaced.size;
+		if (oldsize + size > predictScanlinesSize(dec->w, dec->h, &state->info_png)) return 91;
+		if (!ucvector_resize(&dec->interlaced, oldsize + size)) return 83; /*alloc fail*/
+		if (size) memcpy(dec->interlaced.data + oldsize, data, size);
+		return 0;
+	}
+
+	while (size)
+	{
+		unsigned char* cur = dec->scanline + (dec->y & 1) * stride;
+		const unsigned char* prev = dec->y ? dec->scanline + ((dec->y + 1) & 1) * stride + 1 : 0;
+		size_t n = stride - dec->filled;
+		if (n > size) n = size;
+		if (dec->y >= dec->h) return 91; /*decompressed size doesn't match prediction*/
+
+		memcpy(cur + dec->filled, data, n);
+		dec->filled += n;
+		data += n;
+		size -= n;
+
+		if (dec->filled == stride)
+		{
+			unsigned error = unfilterScanline(cur + 1, cur + 1, prev, dec->bytewidth, cur[0], dec->linebytes);
+			if (!error) error = streamEmitRow(dec, cur + 1, dec->y);
+			if (error) return error;
+			dec->filled = 0;
+			++dec->y;
+		}
+	}
+	return 0;
+}
+
+/*decompresses all the IDAT data there is, last means it's complete*/
+static unsigned streamInflate(LodePNGStreamDecoder* dec, unsigned last)
+{
+	ZlibStream* zs = &dec->zs;
+	unsigned error;
+	do
+	{
+		error = zlibStream_run(zs, last, &dec->state->decoder.zlibsettings);
+		if (!error) error = streamScanlines(dec, zs->window + zs->outbegin, zs->windowend - zs->outbegin);
+	}
+	while (!error && zs->windowend != zs->outbegin);
+	if (!error && last && zs->state != ZLIBSTREAM_DONE) error = 52; /*the zlib data ends early*/
+	return error;
+}
+
+/*the rows of an Adam7 image, once all of it is there*/
+static unsigned streamDeinterlace(LodePNGStreamDecoder* dec)
+{
+	LodePNGState* state = dec->state;
+	unsigned bpp = lodepng_get_bpp(&state->info_png.color);
+	size_t outsize = lodepng_get_raw_size(dec->w, dec->h, &state->info_png.color);
+	unsigned char* image;
+	unsigned error, y;
+
+	if (dec->interlaced.size != predictScanlinesSize(dec->w, dec->h, &state->info_png)) return 91;
+	image = (unsigned char*)lodepng_malloc(outsize);
+	if (!image) return 83; /*alloc fail*/
+	memset(image, 0, outsize);
+	error = postProcessScanlines(image, dec->interlaced.data, dec->w, dec->h, &state->info_png);
+
+	for (y = 0; !error && y != dec->h; ++y)
+	{
+		const unsigned char* row = image + y * dec->linebytes;
+		if ((dec->w * bpp) & 7)
+		{
+			/*below 8 bits per pixel the rows of the image aren't byte aligned, but the rows handed out are*/
+			size_t ibp = (size_t)y * dec->w * bpp, obp = 0, i;
+			for (i = 0; i != (size_t)dec->w * bpp; ++i)
+			{
+				setBitOfReversedStream(&obp, dec->scanline, readBitFromReversedStream(&ibp, image));
+			}
+			for (; obp & 7; ) setBitOfReversedStream(&obp, dec->scanline, 0);
+			row = dec->scanline;
+		}
+		error = streamEmitRow(dec, row, y);
+	}
+
+	lodepng_free(image);
+	return error;
+}
+
+/*IEND: the last of the compressed data is there*/
+static unsigned streamEnd(LodePNGStreamDecoder* dec)
+{
+	unsigned error;
+	if (!dec->rows_ready) return 53; /*no IDAT at all, like an empty zlib stream*/
+	error = streamInflate(dec, 1);
+	if (error) return error;
+	if (dec->state->info_png.interlace_method != 0) return streamDeinterlace(dec);
+	if (dec->y != dec->h || dec->filled) return 91; /*decompressed size doesn't match prediction*/
+	return 0;
+}
+
+/*the buffered signature, chunk header or chunk is complete*/
+static unsigned streamChunk(LodePNGStreamDecoder* dec)
+{
+	LodePNGState* state = dec->state;
+	unsigned error = 0;
+
+	if (dec->phase == STREAM_SIGNATURE)
+	{
+		const unsigned char* in = dec->chunk.data;
+		if (in[0] != 137 || in[1] != 80 || in[2] != 78 || in[3] != 71
+			|| in[4] != 13 || in[5] != 10 || in[6] != 26 || in[7] != 10)
+		{
+			return 28; /*error: the first 8 bytes are not the correct PNG signature*/
+		}
+		/*the signature stays in the buffer, lodepng_inspect wants it in front of IHDR*/
+		dec->phase = STREAM_CHUNK_HEADER;
+		dec->need = 16;
+	}
+	else if (dec->phase == STREAM_CHUNK_HEADER)
+	{
+		const unsigned char* header = dec->chunk.data + dec->chunk.size - 8;
+		unsigned chunkLength = lodepng_chunk_length(header);
+		/*error: chunk length larger than the max PNG chunk size*/
+		if (chunkLength > 2147483647) return 63;
+
+		if (dec->chunks == 0)
+		{
+			/*checked before collecting the chunk, to not wait for gigabytes of something that isn't a PNG*/
+			if (chunkLength != 13) return 94; /*error: header size must be 13 bytes*/
+			if (!lodepng_chunk_type_equals(header, "IHDR")) return 29; /*error: it doesn't start with a IHDR chunk!*/
+		}
+
+		if (dec->chunks != 0 && lodepng_chunk_type_equals(header, "IDAT"))
+		{
+			if (!dec->rows_ready) error = streamBeginRows(dec);
+#ifndef LODEPNG_NO_COMPILE_CRC
+			dec->crc = lodepng_crc32_update(0xffffffffu, header + 4, 4);
+#endif /*LODEPNG_NO_COMPILE_CRC*/
+			dec->critical_pos = 3;
+			dec->phase = STREAM_IDAT;
+			dec->need = chunkLength;
+			if (!chunkLength)
+			{
+				dec->phase = STREAM_IDAT_CRC;
+				dec->need = 4;
+				dec->chunk.size = 0;
+			}
+		}
+		else
+		{
+			dec->phase = STREAM_CHUNK;
+			dec->need = dec->chunk.size + chunkLength + 4;
+		}
+	}
+	else if (dec->phase == STREAM_IDAT_CRC)
+	{
+#ifndef LODEPNG_NO_COMPILE_CRC
+		if (!state->decoder.ignore_crc && lodepng_read32bitInt(dec->chunk.data) != (dec->crc ^ 0xffffffffu))
+		{
+			return 57; /*invalid CRC*/
+		}
+#endif /*LODEPNG_NO_COMPILE_CRC*/
+		++dec->chunks;
+		dec->phase = STREAM_CHUNK_HEADER;
+		dec->need = 8;
+		dec->chunk.size = 0;
+	}
+	else /*STREAM_CHUNK*/
+	{
+		const unsigned char* chunk = dec->chunk.data;
+		unsigned unknown = 0;
+
+		if (dec->chunks == 0)
+		{
+			/*reads header and resets other parameters in state->info_png*/
+			error = lodepng_inspect(&dec->w, &dec->h, state, dec->chunk.data, dec->chunk.size);
+			if (error) return error;
+			/*multiplication overflow, see decodeGeneric*/
+			if ((size_t)dec->w * dec->h / dec->h != dec->w) return 92;
+			if ((size_t)dec->w * dec->h > 268435455) return 92;
+		}
+		else if (lodepng_chunk_type_equals(chunk, "IEND"))
+		{
+			if (!state->decoder.ignore_crc && lodepng_chunk_check_crc(chunk)) return 57; /*invalid CRC*/
+			dec->phase = STREAM_END;
+			return streamEnd(dec);
+		}
+		else
+		{
+			error = readChunk(state, chunk, &dec->critical_pos, &unknown);
+			if (error) return error;
+			/*check CRC if wanted, only on known chunk types*/
+			if (!state->decoder.ignore_crc && !unknown && lodepng_chunk_check_crc(chunk)) return 57;
+		}
+
+		++dec->chunks;
+		dec->phase = STREAM_CHUNK_HEADER;
+		dec->need = 8;
+		dec->chunk.size = 0;
+	}
+	return error;
+}
+
+LodePNGStreamDecoder* lodepng_stream_new(LodePNGState* state, LodePNGRowCallback callback, void* user,
+	unsigned bottom_up)
+{
+	LodePNGStreamDecoder* dec = (LodePNGStreamDecoder*)lodepng_malloc(sizeof(LodePNGStreamDecoder));
+	if (!dec) return 0;
+	dec->state = state;
+	dec->callback = callback;
+	dec->user = user;
+	dec->bottom_up = bottom_up;
+	dec->w = dec->h = 0;
+	dec->phase = STREAM_SIGNATURE;
+	ucvector_init(&dec->chunk);
+	dec->need = 8;
+	dec->chunks = 0;
+	dec->critical_pos = 1;
+	dec->crc = 0;
+	dec->rows_ready = 0;
+	dec->convert = 0;
+	dec->linebytes = dec->bytewidth = 0;
+	dec->scanline = 0;
+	dec->converted = 0;
+	dec->filled = 0;
+	dec->y = 0;
+	ucvector_init(&dec->interlaced);
+	state->error = 0;
+	return dec;
+}
+
+unsigned lodepng_stream_feed(LodePNGStreamDecoder* dec, const unsigned char* in, size_t insize)
+{
+	LodePNGState* state = dec->state;
+	while (insize && !state->error)
+	{
+		size_t n = insize;
+		if (dec->phase == STREAM_IDAT)
+		{
+			if (n > dec->need) n = dec->need;
+#ifndef LODEPNG_NO_COMPILE_CRC
+			dec->crc = lodepng_crc32_update(dec->crc, in, n);
+#endif /*LODEPNG_NO_COMPILE_CRC*/
+			state->error = zlibStream_feed(&dec->zs, in, n);
+			if (!state->error) state->error = streamInflate(dec, 0);
+			dec->need -= n;
+			if (!dec->need)
+			{
+				dec->phase = STREAM_IDAT_CRC;
+				dec->need = 4;
+				dec->chunk.size = 0;
+			}
+		}
+		else if (dec->phase != STREAM_END) /*anything after IEND is ignored*/
+		{
+			size_t oldsize = dec->chunk.size;
+			if (n > dec->need - oldsize) n = dec->need - oldsize;
+			if (!ucvector_resize(&dec->chunk, oldsize + n)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
+			memcpy(dec->chunk.data + oldsize, in, n);
+			if (dec->chunk.size == dec->need) state->error = streamChunk(dec);
+		}
+		in += n;
+		insize -= n;
+	}
+	return state->error;
+}
+
+unsigned lodepng_stream_finish(LodePNGStreamDecoder* dec)
+{
+	LodePNGState* state = dec->state;
+	if (!state->error && dec->phase != STREAM_END)
+	{
+		/*error: the PNG ended before its header, or in the middle of the chunks*/
+		state->error = dec->chunks == 0 ? 27 : 30;
+	}
+	return state->error;
+}
+
+void lodepng_stream_delete(LodePNGStreamDecoder* dec)
+{
+	if (!dec) return;
+	ucvector_cleanup(&dec->chunk);
+	if (dec->rows_ready) zlibStream_cleanup(&dec->zs);
+	lodepng_free(dec->scanline);
+	lodepng_free(dec->converted);
+	ucvector_cleanup(&dec->interlaced);
+	lodepng_free(dec);
+}
+
 void lodepng_decoder_settings_init(LodePNGDecoderSettings* settings)
 {
 	settings->color_convert = 1;
@@ -5202,46 +7156,20 @@ static float flog2(float f)
 	return result + 1.442695f * (f * f * f / 3 - 3 * f * f / 2 + 3 * f - 1.83333f);
 }
 
-static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w, unsigned h,
-	const LodePNGColorMode* info, const LodePNGEncoderSettings* settings)
+/*
+Filters the rows [y0, y1) with the given strategy. Each row only depends on the unfiltered previous row, so
+any range of rows can be done independently of the others.
+*/
+static unsigned filterRows(unsigned char* out, const unsigned char* in, size_t linebytes, size_t bytewidth,
+	unsigned y0, unsigned y1, LodePNGFilterStrategy strategy, const LodePNGEncoderSettings* settings)
 {
-	/*
-	For PNG filter method 0
-	out must be a buffer with as size: h + (w * h * bpp + 7) / 8, because there are
-	the scanlines with 1 extra byte per scanline
-	*/
-
-	unsigned bpp = lodepng_get_bpp(info);
-	/*the width of a scanline in bytes, not including the filter type*/
-	size_t linebytes = (w * bpp + 7) / 8;
-	/*bytewidth is used for filtering, is 1 when bpp < 8, number of bytes per pixel otherwise*/
-	size_t bytewidth = (bpp + 7) / 8;
-	const unsigned char* prevline = 0;
+	const unsigned char* prevline = y0 == 0 ? 0 : &in[(y0 - 1) * linebytes];
 	unsigned x, y;
 	unsigned error = 0;
-	LodePNGFilterStrategy strategy = settings->filter_strategy;
-
-	/*
-	There is a heuristic called the minimum sum of absolute differences heuristic, suggested by the PNG standard:
-	*  If the image type is Palette, or the bit depth is smaller than 8, then do not filter the image (i.e.
-	use fixed filtering, with the filter None).
-	* (The other case) If the image type is Grayscale or RGB (with or without Alpha), and the bit depth is
-	not smaller than 8, then use adaptive filtering heuristic as follows: independently for each row, apply
-	all five filters and select the filter that produces the smallest sum of absolute values per row.
-	This heuristic is used if filter strategy is LFS_MINSUM and filter_palette_zero is true.
-
-	If filter_palette_zero is true and filter_strategy is not LFS_MINSUM, the above heuristic is followed,
-	but for "the other case", whatever strategy filter_strategy is set to instead of the minimum sum
-	heuristic is used.
-	*/
-	if (settings->filter_palette_zero &&
-		(info->colortype == LCT_PALETTE || info->bitdepth < 8)) strategy = LFS_ZERO;
-
-	if (bpp == 0) return 31; /*error: invalid color type*/
 
 	if (strategy == LFS_ZERO)
 	{
-		for (y = 0; y != h; ++y)
+		for (y = y0; y != y1; ++y)
 		{
 			size_t outindex = (1 + linebytes) * y; /*the extra filterbyte added to each row*/
 			size_t inindex = linebytes * y;
@@ -5266,7 +7194,7 @@ static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w,
 
 		if (!error)
 		{
-			for (y = 0; y != h; ++y)
+			for (y = y0; y != y1; ++y)
 			{
 				/*try the 5 filter types*/
 				for (type = 0; type != 5; ++type)
@@ -5323,7 +7251,7 @@ static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w,
 			if (!attempt[type]) return 83; /*alloc fail*/
 		}
 
-		for (y = 0; y != h; ++y)
+		for (y = y0; y != y1; ++y)
 		{
 			/*try the 5 filter types*/
 			for (type = 0; type != 5; ++type)
@@ -5357,7 +7285,7 @@ static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w,
 	}
 	else if (strategy == LFS_PREDEFINED)
 	{
-		for (y = 0; y != h; ++y)
+		for (y = y0; y != y1; ++y)
 		{
 			size_t outindex = (1 + linebytes) * y; /*the extra filterbyte added to each row*/
 			size_t inindex = linebytes * y;
@@ -5387,12 +7315,14 @@ static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w,
 		images only, so disable it*/
 		zlibsettings.custom_zlib = 0;
 		zlibsettings.custom_deflate = 0;
+		/*rows are already spread over the threads, and these attempts are tiny*/
+		zlibsettings.num_threads = 1;
 		for (type = 0; type != 5; ++type)
 		{
 			attempt[type] = (unsigned char*)lodepng_malloc(linebytes);
 			if (!attempt[type]) return 83; /*alloc fail*/
 		}
-		for (y = 0; y != h; ++y) /*try the 5 filter types*/
+		for (y = y0; y != y1; ++y) /*try the 5 filter types*/
 		{
 			for (type = 0; type != 5; ++type)
 			{
@@ -5422,6 +7352,92 @@ static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w,
 	return error;
 }
 
+typedef struct FilterJobs
+{
+	unsigned char* out;
+	const unsigned char* in;
+	size_t linebytes;
+	size_t bytewidth;
+	unsigned h;
+	unsigned rowsperjob;
+	LodePNGFilterStrategy strategy;
+	const LodePNGEncoderSettings* settings;
+	unsigned* errors;
+} FilterJobs;
+
+static void filterJob(void* context, size_t index)
+{
+	FilterJobs* jobs = (FilterJobs*)context;
+	unsigned y0 = (unsigned)index * jobs->rowsperjob;
+	unsigned y1 = y0 + jobs->rowsperjob;
+	if (y1 > jobs->h) y1 = jobs->h;
+	jobs->errors[index] = filterRows(jobs->out, jobs->in, jobs->linebytes, jobs->bytewidth, y0, y1,
+		jobs->strategy, jobs->settings);
+}
+
+static unsigned filter(unsigned char* out, const unsigned char* in, unsigned w, unsigned h,
+	const LodePNGColorMode* info, const LodePNGEncoderSettings* settings)
+{
+	/*
+	For PNG filter method 0
+	out must be a buffer with as size: h + (w * h * bpp + 7) / 8, because there are
+	the scanlines with 1 extra byte per scanline
+	*/
+
+	unsigned bpp = lodepng_get_bpp(info);
+	/*the width of a scanline in bytes, not including the filter type*/
+	size_t linebytes = (w * bpp + 7) / 8;
+	/*bytewidth is used for filtering, is 1 when bpp < 8, number of bytes per pixel otherwise*/
+	size_t bytewidth = (bpp + 7) / 8;
+	unsigned numthreads = lodepng_num_threads(settings->zlibsettings.num_threads);
+	unsigned error = 0;
+	LodePNGFilterStrategy strategy = settings->filter_strategy;
+
+	/*
+	There is a heuristic called the minimum sum of absolute differences heuristic, suggested by the PNG standard:
+	*  If the image type is Palette, or the bit depth is smaller than 8, then do not filter the image (i.e.
+	use fixed filtering, with the filter None).
+	* (The other case) If the image type is Grayscale or RGB (with or without Alpha), and the bit depth is
+	not smaller than 8, then use adaptive filtering heuristic as follows: independently for each row, apply
+	all five filters and select the filter that produces the smallest sum of absolute values per row.
+	This heuristic is used if filter strategy is LFS_MINSUM and filter_palette_zero is true.
+
+	If filter_palette_zero is true and filter_strategy is not LFS_MINSUM, the above heuristic is followed,
+	but for "the other case", whatever strategy filter_strategy is set to instead of the minimum sum
+	heuristic is used.
+	*/
+	if (settings->filter_palette_zero &&
+		(info->colortype == LCT_PALETTE || info->bitdepth < 8)) strategy = LFS_ZERO;
+
+	if (bpp == 0) return 31; /*error: invalid color type*/
+
+
+	if (numthreads > 1 && h > 1)
+	{
+		/*a few jobs per thread, the strategies that try all filters take longer on busy rows*/
+		FilterJobs jobs;
+		size_t i, numjobs;
+		jobs.out = out;
+		jobs.in = in;
+		jobs.linebytes = linebytes;
+		jobs.bytewidth = bytewidth;
+		jobs.h = h;
+		jobs.rowsperjob = (h + numthreads * 4 - 1) / (numthreads * 4);
+		jobs.strategy = strategy;
+		jobs.settings = settings;
+		numjobs = (h + jobs.rowsperjob - 1) / jobs.rowsperjob;
+		jobs.errors = (unsigned*)lodepng_malloc(sizeof(unsigned) * numjobs);
+		if (!jobs.errors) return 83; /*alloc fail*/
+
+		lodepng_run_jobs(filterJob, &jobs, numjobs, numthreads);
+		for (i = 0; i != numjobs && !error; ++i) error = jobs.errors[i];
+		lodepng_free(jobs.errors);
+		return error;
+	}
+
+	return filterRows(out, in, linebytes, bytewidth, 0, h, strategy, settings);
+}
+
 static void addPaddingBits(unsigned char* out, const unsigned char* in,
 	size_t olinebits, size_t ilinebits, unsigned h)
 {
@@ -6152,6 +8168,65 @@ namespace lodepng
 		if (error) return error;
 		return decode(out, w, h, buffer, colortype, bitdepth);
 	}
+
+	struct StreamRows
+	{
+		std::vector<unsigned char>* out;
+		const LodePNGColorMode* color;
+		size_t rowbytes;
+	};
+
+	static unsigned streamRowsCallback(void* user, const unsigned char* row, unsigned y, unsigned w, unsigned h)
+	{
+		StreamRows* rows = (StreamRows*)user;
+		if (rows->out->empty())
+		{
+			rows->rowbytes = lodepng_get_raw_size(w, 1, rows->color);
+			rows->out->resize(rows->rowbytes * h);
+		}
+		memcpy(&(*rows->out)[y * rows->rowbytes], row, rows->rowbytes);
+		return 0;
+	}
+
+	unsigned decode_streaming(std::vector<unsigned char>& out, unsigned& w, unsigned& h, const std::string& filename,
+		LodePNGColorType colortype, unsigned bitdepth, bool bottom_up)
+	{
+		unsigned char buffer[65536];
+		StreamRows rows;
+		LodePNGStreamDecoder* decoder;
+		unsigned error;
+		FILE* file = fopen(filename.c_str(), "rb");
+		if (!file) return 78;
+
+		State state;
+		state.info_raw.colortype = colortype;
+		state.info_raw.bitdepth = bitdepth;
+		out.clear();
+		rows.out = &out;
+		rows.color = &state.info_raw;
+		rows.rowbytes = 0;
+		decoder = lodepng_stream_new(&state, streamRowsCallback, &rows, bottom_up ? 1 : 0);
+		if (!decoder)
+		{
+			fclose(file);
+			return 83; /*alloc fail*/
+		}
+
+		error = 0;
+		while (!error)
+		{
+			size_t size = fread(buffer, 1, sizeof(buffer), file);
+			if (size == 0) break;
+			error = lodepng_stream_feed(decoder, buffer, size);
+		}
+		if (!error) error = ferror(file) ? 78 : lodepng_stream_finish(decoder);
+		w = decoder->w;
+		h = decoder->h;
+
+		lodepng_stream_delete(decoder);
+		fclose(file);
+		return error;
+	}
 #endif /* LODEPNG_COMPILE_DECODER */
 #endif /* LODEPNG_COMPILE_DISK */
 
@@ -215,6 +215,15 @@ namespace lodepng
 	unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h,
 		const std::string& filename,
 		LodePNGColorType colortype = LCT_RGBA, unsigned bitdepth = 8);
+
+	/*
+	Same, but reads the file in pieces through the streaming decoder, so there's never more of it in
+	memory than one piece and the output. Every row starts at a byte boundary, which differs from the
+	other decode functions only below 8 bits per pixel. bottom_up stores the rows bottom to top.
+	*/
+	unsigned decode_streaming(std::vector<unsigned char>& out, unsigned& w, unsigned& h,
+		const std::string& filename,
+		LodePNGColorType colortype = LCT_RGBA, unsigned bitdepth = 8, bool bottom_up = false);
 #endif /* LODEPNG_COMPILE_DISK */
 #endif /* LODEPNG_COMPILE_DECODER */
 
@@ -290,6 +299,16 @@ struct LodePNGCompressSettings /*deflate = compress*/
 	unsigned minmatch; /*mininum lz77 length. 3 is normally best, 6 can be better for some PNGs. Default: 0*/
 	unsigned nicematch; /*stop searching if >= this length found. Set to 258 for best compression. Default: 128*/
 	unsigned lazymatching; /*use lazy matching: better compression but a bit slower. Default: true*/
+	/*how many hash chain links to follow per position. 0 means windowsize / 8, or all of them for a windowsize
+	of 8192 and up. Default: 0*/
+	unsigned maxchainlength;
+	/*without lazymatching: matches longer than this don't add the positions they cover to the hash chains, which
+	is a lot faster on long runs at the cost of missing some matches right after them. 0 adds every position. Default: 0*/
+	unsigned maxinsert;
+	/*threads for the built in deflate and the PNG encoder's filter selection. 0 means one per hardware thread.
+	With more than 1, the data is deflated in independent chunks that each end on a byte boundary, which costs a
+	few bytes per chunk. Default: 1*/
+	unsigned num_threads;
 
 						   /*use custom zlib encoder instead of built in one (default: null)*/
 	unsigned(*custom_zlib)(unsigned char**, size_t*,
@@ -307,6 +326,9 @@ struct LodePNGCompressSettings /*deflate = compress*/
 
 extern const LodePNGCompressSettings lodepng_default_compress_settings;
 void lodepng_compress_settings_init(LodePNGCompressSettings* settings);
+/*set up the LZ77 settings for a compression level like zlib's: 0 stores without compression, 1 is the fastest
+and 9 compresses the most. Only the block type and LZ77 settings are changed.*/
+void lodepng_compress_settings_level(LodePNGCompressSettings* settings, unsigned level);
 #endif /*LODEPNG_COMPILE_ENCODER*/
 
 #ifdef LODEPNG_COMPILE_PNG
@@ -659,6 +681,35 @@ information is placed in the info_png field of the LodePNGState.
 unsigned lodepng_inspect(unsigned* w, unsigned* h,
 	LodePNGState* state,
 	const unsigned char* in, size_t insize);
+
+/*
+Streaming decoder: the PNG is given in pieces of any size, and the rows come out through a callback as
+soon as they're decompressed, instead of going to one buffer. Apart from the rows and chunks other than
+IDAT, it holds two scanlines and the 32K zlib window, so neither the file nor the image has to fit in
+memory at once. Adam7 interlaced images are the exception: their rows are only known at the end, so all
+of it is kept and the rows come out during the IEND chunk.
+The state is used like lodepng_decode does: info_raw is the color type to convert to (or gets the one of
+the PNG if color_convert is off), info_png is filled in as the chunks arrive, and state->error has the
+error. The zlib data is always decompressed by lodepng, custom_zlib and custom_inflate are not used.
+*/
+typedef struct LodePNGStreamDecoder LodePNGStreamDecoder;
+
+/*
+Gets every row once, top to bottom as they are in the file. row has lodepng_get_raw_size(w, 1, color)
+bytes in the info_raw color type, and is only valid during the call. With bottom_up, y counts from the
+bottom instead (y = h - 1 - row in the file), handy for OpenGL textures.
+Returning something else than 0 stops the decoding, with that as the error code.
+*/
+typedef unsigned (*LodePNGRowCallback)(void* user, const unsigned char* row, unsigned y, unsigned w, unsigned h);
+
+/*state must be initialized and stay around until lodepng_stream_delete. Returns 0 if out of memory.*/
+LodePNGStreamDecoder* lodepng_stream_new(LodePNGState* state, LodePNGRowCallback callback, void* user,
+	unsigned bottom_up);
+/*Takes the next insize bytes of the PNG. Returns the error code, which sticks for later calls.*/
+unsigned lodepng_stream_feed(LodePNGStreamDecoder* decoder, const unsigned char* in, size_t insize);
+/*After the whole file was fed, returns an error if the PNG was incomplete. All rows are out by then.*/
+unsigned lodepng_stream_finish(LodePNGStreamDecoder* decoder);
+void lodepng_stream_delete(LodePNGStreamDecoder* decoder);
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 
@@ -0,0 +1,46 @@
+#include "offscreen.h"
+
+#include <cstdio>
+
+int offscreen_create(offscreen_t *o, int width, int height) {
+	o->width = width;
+	o->height = height;
+
+	glGenRenderbuffers(1, &o->color_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, o->color_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &o->depth_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, o->depth_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &o->fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, o->fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, o->color_rb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, o->depth_rb);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		printf("offscreen_create: framebuffer incomplete (status 0x%X)\n", status);
+		return 0;
+	}
+
+	glViewport(0, 0, width, height);
+	return 1;
+}
+
+void offscreen_read_pixels(const offscreen_t *o, unsigned char *rgba) {
+	glBindFramebuffer(GL_FRAMEBUFFER, o->fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, o->width, o->height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
+void offscreen_destroy(offscreen_t *o) {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &o->fbo);
+	glDeleteRenderbuffers(1, &o->color_rb);
+	glDeleteRenderbuffers(1, &o->depth_rb);
+	o->fbo = o->color_rb = o->depth_rb = 0;
+}
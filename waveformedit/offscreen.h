@@ -0,0 +1,17 @@
+#pragma once
+
+#include "glext_loader.h"
+
+// a framebuffer object with RGBA8 color and 24-bit depth renderbuffers, the stand-in for the window's
+// back buffer when there's no window
+struct offscreen_t {
+	GLuint fbo;
+	GLuint color_rb, depth_rb;
+	int width, height;
+};
+
+// leaves the framebuffer bound and the viewport set to its size. returns 0 if it's incomplete
+int offscreen_create(offscreen_t *o, int width, int height);
+// bottom-up RGBA8 rows, width*height*4 bytes
+void offscreen_read_pixels(const offscreen_t *o, unsigned char *rgba);
+void offscreen_destroy(offscreen_t *o);
@@ -0,0 +1,151 @@
+#include "oversample.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <xmmintrin.h>
+
+#define PI 3.14159265358979
+
+// per quality: K for the stages running at the higher rates, and for the last (most critical) stage
+static const int quality_K[3][2] = {
+	{ 2, 4 },	// low: 7 and 15 taps
+	{ 4, 8 },	// medium: 15 and 31 taps
+	{ 6, 16 }	// high: 23 and 63 taps
+};
+
+void halfband_t::allocate(int max_input_samples) {
+	max_input = max_input_samples;
+	even = new float[2 * HALFBAND_MAX_K + max_input / 2];
+	odd = new float[HALFBAND_MAX_K + max_input / 2];
+	reset();
+}
+
+void halfband_t::cleanup() {
+	delete[] even;
+	delete[] odd;
+	even = odd = NULL;
+}
+
+void halfband_t::design(int a_K) {
+	K = a_K;
+
+	const int L = 4 * K - 1;
+	const int C = 2 * K - 1;
+
+	// windowed sinc with the cutoff at a quarter of the input rate. the odd-distance taps around the center
+	// are the only nonzero ones besides the center itself (which is exactly 0.5)
+	float sum = 0;
+	for (int j = 0; j < 2 * K; ++j) {
+		int i = 2 * j;
+		int t = i - C;
+		double sinc = sin(PI * t / 2.0) / (PI * t);
+
+		// 4-term blackman-harris
+		double x = 2.0 * PI * (i + 1) / (double)(L + 1);
+		double w = 0.35875 - 0.48829*cos(x) + 0.14128*cos(2 * x) - 0.01168*cos(3 * x);
+
+		coefs[j] = (float)(sinc * w);
+		sum += coefs[j];
+	}
+
+	// unity gain at DC: the center tap gives 0.5, so the even phase has to sum to the other 0.5
+	for (int j = 0; j < 2 * K; ++j) {
+		coefs[j] *= 0.5f / sum;
+	}
+
+	reset();
+}
+
+void halfband_t::reset() {
+	if (even) memset(even, 0, (2 * HALFBAND_MAX_K + max_input / 2) * sizeof(float));
+	if (odd) memset(odd, 0, (HALFBAND_MAX_K + max_input / 2) * sizeof(float));
+}
+
+void halfband_t::process(const float *in, int n, float *out) {
+	const int taps = 2 * K;
+	const int hist_e = taps - 1;
+	const int hist_o = K;
+	const int n_out = n / 2;
+
+	// split into the two phases behind the saved history
+	float *e = even + hist_e;
+	float *o = odd + hist_o;
+	for (int m = 0; m < n_out; ++m) {
+		e[m] = in[2 * m];
+		o[m] = in[2 * m + 1];
+	}
+
+	// y[m] = sum_j coefs[j] * x_even[m - j] + 0.5 * x_odd[m - K]
+	// four outputs at a time, so every tap is one broadcast and one unaligned load, no horizontal sums
+	const __m128 half = _mm_set1_ps(0.5f);
+	int m = 0;
+	for (; m + 4 <= n_out; m += 4) {
+		__m128 acc = _mm_mul_ps(half, _mm_loadu_ps(&odd[m]));
+		for (int j = 0; j < taps; ++j) {
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(coefs[j]), _mm_loadu_ps(&e[m - j])));
+		}
+		_mm_storeu_ps(&out[m], acc);
+	}
+	for (; m < n_out; ++m) {
+		float acc = 0.5f * odd[m];
+		for (int j = 0; j < taps; ++j) {
+			acc += coefs[j] * e[m - j];
+		}
+		out[m] = acc;
+	}
+
+	memmove(even, even + n_out, hist_e * sizeof(float));
+	memmove(odd, odd + n_out, hist_o * sizeof(float));
+}
+
+void decimator_t::allocate(int max_output_frames) {
+	int n = max_output_frames * OVERSAMPLE_MAX_FACTOR;
+	for (int s = 0; s < HALFBAND_MAX_STAGES; ++s) {
+		stages[s].allocate(n);
+		n /= 2;
+	}
+	scratch[0] = new float[max_output_frames * OVERSAMPLE_MAX_FACTOR / 2];
+	scratch[1] = new float[max_output_frames * OVERSAMPLE_MAX_FACTOR / 4];
+}
+
+void decimator_t::cleanup() {
+	for (int s = 0; s < HALFBAND_MAX_STAGES; ++s) {
+		stages[s].cleanup();
+	}
+	delete[] scratch[0];
+	delete[] scratch[1];
+	scratch[0] = scratch[1] = NULL;
+}
+
+void decimator_t::setup(int a_factor, int a_quality) {
+	factor = a_factor;
+	quality = a_quality;
+
+	num_stages = 0;
+	for (int f = factor; f > 1; f >>= 1) {
+		++num_stages;
+	}
+
+	for (int s = 0; s < num_stages; ++s) {
+		bool last = (s == num_stages - 1);
+		stages[s].design(quality_K[quality][last ? 1 : 0]);
+	}
+}
+
+void decimator_t::process(const float *in, int n_out, float *out) {
+	if (num_stages == 0) {
+		memcpy(out, in, n_out * sizeof(float));
+		return;
+	}
+
+	const float *src = in;
+	int n = n_out * factor;
+
+	for (int s = 0; s < num_stages; ++s) {
+		float *dst = (s == num_stages - 1) ? out : scratch[s & 1];
+		stages[s].process(src, n, dst);
+		src = dst;
+		n /= 2;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+// Decimation back to the device rate after oversampled synthesis. Each 2:1 step is a half-band FIR
+// in polyphase form: every other tap of a half-band filter is zero, so the odd input phase only
+// contributes through the center tap and the even phase goes through a short symmetric FIR.
+// Factors 2x/4x/8x chain 1-3 such stages.
+
+#define OVERSAMPLE_MAX_FACTOR 8
+#define HALFBAND_MAX_STAGES 3
+#define HALFBAND_MAX_K 16	// a half-band filter with K taps per side of each phase has 4K-1 taps in total
+
+enum {
+	OVERSAMPLE_QUALITY_LOW = 0,
+	OVERSAMPLE_QUALITY_MEDIUM = 1,
+	OVERSAMPLE_QUALITY_HIGH = 2
+};
+
+struct halfband_t {
+	int K;
+	float coefs[2 * HALFBAND_MAX_K];	// even phase taps, h[0], h[2], ..., h[4K-2]
+
+	// input phases, each prefixed with the history the FIR needs from the previous block
+	float *even;
+	float *odd;
+	int max_input;
+
+	halfband_t() : K(0), even(NULL), odd(NULL), max_input(0) {}
+
+	void allocate(int max_input_samples);
+	void cleanup();
+
+	void design(int K);
+	void reset();
+
+	// n input samples (even) -> n/2 output samples
+	void process(const float *in, int n, float *out);
+};
+
+struct decimator_t {
+	int factor;
+	int quality;
+	int num_stages;
+	halfband_t stages[HALFBAND_MAX_STAGES];
+	float *scratch[2];
+
+	decimator_t() : factor(1), quality(OVERSAMPLE_QUALITY_MEDIUM), num_stages(0) { scratch[0] = scratch[1] = NULL; }
+
+	// allocates everything for up to OVERSAMPLE_MAX_FACTOR, after this setup() and process() never allocate
+	void allocate(int max_output_frames);
+	void cleanup();
+
+	// factor is 1, 2, 4 or 8
+	void setup(int factor, int quality);
+
+	// reads n_out * factor samples from in, writes n_out samples to out
+	void process(const float *in, int n_out, float *out);
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// where the GL context comes from. the editor gets it from its window through WGL (glwindow.cpp), the
+// headless path creates one without any window and renders into an offscreen framebuffer instead: through
+// a hidden WGL window on windows (platform_wgl.cpp), through EGL everywhere else (platform_egl.cpp), which
+// with mesa's llvmpipe needs no GPU at all. that's what the frame-time benchmarks and the pixel regression
+// checks in headless.cpp run on.
+
+void *platform_get_proc_address(const char *name);
+void platform_swap_interval(int interval);
+
+// creates a context, makes it current, loads the GL extensions and binds a width x height offscreen
+// framebuffer (see offscreen.h) for drawing. returns 0 on failure
+int platform_headless_create(int width, int height);
+// bottom-up RGBA8 rows of the offscreen framebuffer, width*height*4 bytes
+void platform_headless_read_pixels(unsigned char *rgba);
+void platform_headless_destroy();
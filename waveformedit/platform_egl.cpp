@@ -0,0 +1,101 @@
+#ifndef _WIN32
+
+#include "platform.h"
+#include "glext_loader.h"
+#include "offscreen.h"
+
+#include <cstdio>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// headless contexts through EGL without any surface (EGL_KHR_surfaceless_context), drawing goes to the
+// offscreen framebuffer. on a machine without a GPU mesa picks llvmpipe. link with -lEGL -lGL
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static offscreen_t offscreen;
+
+void *platform_get_proc_address(const char *name) {
+	return (void*)eglGetProcAddress(name);
+}
+
+void platform_swap_interval(int interval) {
+	// nothing to swap
+	(void)interval;
+}
+
+static EGLDisplay get_display() {
+	// the surfaceless platform doesn't need an X server or a render node
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (eglGetPlatformDisplayEXT) {
+		EGLDisplay d = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (d != EGL_NO_DISPLAY) {
+			return d;
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+int platform_headless_create(int width, int height) {
+	display = get_display();
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		printf("platform_headless_create: no EGL display (error 0x%X)\n", eglGetError());
+		return 0;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		printf("platform_headless_create: EGL has no desktop GL\n");
+		return 0;
+	}
+
+	// tessellation needs 4.0, and the compatibility profile keeps the same rules as the WGL context
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 0,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	// no surface means no config is needed either (EGL_KHR_no_config_context), but take one if there is
+	const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = (EGLConfig)0;
+	EGLint num_configs = 0;
+	eglChooseConfig(display, config_attribs, &config, 1, &num_configs);
+
+	context = eglCreateContext(display, num_configs > 0 ? config : (EGLConfig)0, EGL_NO_CONTEXT, context_attribs);
+	if (context == EGL_NO_CONTEXT) {
+		printf("platform_headless_create: eglCreateContext failed (error 0x%X)\n", eglGetError());
+		return 0;
+	}
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		printf("platform_headless_create: eglMakeCurrent failed (error 0x%X)\n", eglGetError());
+		return 0;
+	}
+
+	printf("headless: EGL %d.%d, %s, %s\n", major, minor, (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+	if (!load_GL_extensions()) {
+		return 0;
+	}
+	return offscreen_create(&offscreen, width, height);
+}
+
+void platform_headless_read_pixels(unsigned char *rgba) {
+	offscreen_read_pixels(&offscreen, rgba);
+}
+
+void platform_headless_destroy() {
+	if (context != EGL_NO_CONTEXT) {
+		offscreen_destroy(&offscreen);
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		context = EGL_NO_CONTEXT;
+	}
+	if (display != EGL_NO_DISPLAY) {
+		eglTerminate(display);
+		display = EGL_NO_DISPLAY;
+	}
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifdef _WIN32
+
+#include "platform.h"
+#include "glext_loader.h"
+#include "offscreen.h"
+
+#include <cstdio>
+#include <cstring>
+
+typedef BOOL (APIENTRYP PFNWGLSWAPINTERVALEXTPROC) (int interval);
+
+void *platform_get_proc_address(const char *name) {
+	void *p = (void*)wglGetProcAddress(name);
+	// some drivers return small integers instead of NULL, and the 1.1 functions only come from opengl32.dll
+	if (p == NULL || p == (void*)1 || p == (void*)2 || p == (void*)3 || p == (void*)-1) {
+		p = (void*)GetProcAddress(GetModuleHandleA("opengl32.dll"), name);
+	}
+	return p;
+}
+
+void platform_swap_interval(int interval) {
+	static PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)platform_get_proc_address("wglSwapIntervalEXT");
+	if (wglSwapIntervalEXT) {
+		wglSwapIntervalEXT(interval);
+	}
+}
+
+// headless on windows still needs a window for the pixel format, it just never gets shown
+
+static HWND headless_hWnd = NULL;
+static HDC headless_hDC = NULL;
+static HGLRC headless_hRC = NULL;
+static offscreen_t offscreen;
+
+int platform_headless_create(int width, int height) {
+	HINSTANCE hInstance = GetModuleHandle(NULL);
+
+	WNDCLASSA wc;
+	memset(&wc, 0, sizeof(wc));
+	wc.style = CS_OWNDC;
+	wc.lpfnWndProc = DefWindowProcA;
+	wc.hInstance = hInstance;
+	wc.lpszClassName = "wfedit_headless";
+	RegisterClassA(&wc);
+
+	headless_hWnd = CreateWindowExA(0, "wfedit_headless", "", WS_POPUP, 0, 0, 1, 1, NULL, NULL, hInstance, NULL);
+	if (!headless_hWnd || !(headless_hDC = GetDC(headless_hWnd))) {
+		printf("platform_headless_create: couldn't create the hidden window\n");
+		return 0;
+	}
+
+	PIXELFORMATDESCRIPTOR pfd;
+	memset(&pfd, 0, sizeof(pfd));
+	pfd.nSize = sizeof(pfd);
+	pfd.nVersion = 1;
+	pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+	pfd.iPixelType = PFD_TYPE_RGBA;
+	pfd.cColorBits = 32;
+	pfd.iLayerType = PFD_MAIN_PLANE;
+
+	int format = ChoosePixelFormat(headless_hDC, &pfd);
+	if (!format || !SetPixelFormat(headless_hDC, format, &pfd)) {
+		printf("platform_headless_create: no pixel format\n");
+		return 0;
+	}
+	if (!(headless_hRC = wglCreateContext(headless_hDC)) || !wglMakeCurrent(headless_hDC, headless_hRC)) {
+		printf("platform_headless_create: couldn't create the GL context\n");
+		return 0;
+	}
+
+	printf("headless: WGL, %s, %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+	if (!load_GL_extensions()) {
+		return 0;
+	}
+	return offscreen_create(&offscreen, width, height);
+}
+
+void platform_headless_read_pixels(unsigned char *rgba) {
+	offscreen_read_pixels(&offscreen, rgba);
+}
+
+void platform_headless_destroy() {
+	if (headless_hRC) {
+		offscreen_destroy(&offscreen);
+		wglMakeCurrent(NULL, NULL);
+		wglDeleteContext(headless_hRC);
+		headless_hRC = NULL;
+	}
+	if (headless_hDC) {
+		ReleaseDC(headless_hWnd, headless_hDC);
+		headless_hDC = NULL;
+	}
+	if (headless_hWnd) {
+		DestroyWindow(headless_hWnd);
+		headless_hWnd = NULL;
+	}
+	UnregisterClassA("wfedit_headless", GetModuleHandle(NULL));
+}
+
+#endif
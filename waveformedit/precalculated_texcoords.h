@@ -1,102 +0,0 @@
-// generated by means of a python script.
-// Works with the 128x128 texture dina_all.bmp
-static float glyph_texcoords[][8] = {
-{ 0.0, 1.0, 0.0, 0.90625, 0.046875, 0.90625, 0.046875, 1.0 },
-{ 0.0546875, 1.0, 0.0546875, 0.90625, 0.1015625, 0.90625, 0.1015625, 1.0 },
-{ 0.109375, 1.0, 0.109375, 0.90625, 0.15625, 0.90625, 0.15625, 1.0 },
-{ 0.1640625, 1.0, 0.1640625, 0.90625, 0.2109375, 0.90625, 0.2109375, 1.0 },
-{ 0.21875, 1.0, 0.21875, 0.90625, 0.265625, 0.90625, 0.265625, 1.0 },
-{ 0.2734375, 1.0, 0.2734375, 0.90625, 0.3203125, 0.90625, 0.3203125, 1.0 },
-{ 0.328125, 1.0, 0.328125, 0.90625, 0.375, 0.90625, 0.375, 1.0 },
-{ 0.3828125, 1.0, 0.3828125, 0.90625, 0.4296875, 0.90625, 0.4296875, 1.0 },
-{ 0.4375, 1.0, 0.4375, 0.90625, 0.484375, 0.90625, 0.484375, 1.0 },
-{ 0.4921875, 1.0, 0.4921875, 0.90625, 0.5390625, 0.90625, 0.5390625, 1.0 },
-{ 0.546875, 1.0, 0.546875, 0.90625, 0.59375, 0.90625, 0.59375, 1.0 },
-{ 0.6015625, 1.0, 0.6015625, 0.90625, 0.6484375, 0.90625, 0.6484375, 1.0 },
-{ 0.65625, 1.0, 0.65625, 0.90625, 0.703125, 0.90625, 0.703125, 1.0 },
-{ 0.7109375, 1.0, 0.7109375, 0.90625, 0.7578125, 0.90625, 0.7578125, 1.0 },
-{ 0.0, 0.8984375, 0.0, 0.8046875, 0.046875, 0.8046875, 0.046875, 0.8984375 },
-{ 0.0546875, 0.8984375, 0.0546875, 0.8046875, 0.1015625, 0.8046875, 0.1015625, 0.8984375 },
-{ 0.109375, 0.8984375, 0.109375, 0.8046875, 0.15625, 0.8046875, 0.15625, 0.8984375 },
-{ 0.1640625, 0.8984375, 0.1640625, 0.8046875, 0.2109375, 0.8046875, 0.2109375, 0.8984375 },
-{ 0.21875, 0.8984375, 0.21875, 0.8046875, 0.265625, 0.8046875, 0.265625, 0.8984375 },
-{ 0.2734375, 0.8984375, 0.2734375, 0.8046875, 0.3203125, 0.8046875, 0.3203125, 0.8984375 },
-{ 0.328125, 0.8984375, 0.328125, 0.8046875, 0.375, 0.8046875, 0.375, 0.8984375 },
-{ 0.3828125, 0.8984375, 0.3828125, 0.8046875, 0.4296875, 0.8046875, 0.4296875, 0.8984375 },
-{ 0.4375, 0.8984375, 0.4375, 0.8046875, 0.484375, 0.8046875, 0.484375, 0.8984375 },
-{ 0.4921875, 0.8984375, 0.4921875, 0.8046875, 0.5390625, 0.8046875, 0.5390625, 0.8984375 },
-{ 0.546875, 0.8984375, 0.546875, 0.8046875, 0.59375, 0.8046875, 0.59375, 0.8984375 },
-{ 0.6015625, 0.8984375, 0.6015625, 0.8046875, 0.6484375, 0.8046875, 0.6484375, 0.8984375 },
-{ 0.65625, 0.8984375, 0.65625, 0.8046875, 0.703125, 0.8046875, 0.703125, 0.8984375 },
-{ 0.7109375, 0.8984375, 0.7109375, 0.8046875, 0.7578125, 0.8046875, 0.7578125, 0.8984375 },
-{ 0.0, 0.796875, 0.0, 0.703125, 0.046875, 0.703125, 0.046875, 0.796875 },
-{ 0.0546875, 0.796875, 0.0546875, 0.703125, 0.1015625, 0.703125, 0.1015625, 0.796875 },
-{ 0.109375, 0.796875, 0.109375, 0.703125, 0.15625, 0.703125, 0.15625, 0.796875 },
-{ 0.1640625, 0.796875, 0.1640625, 0.703125, 0.2109375, 0.703125, 0.2109375, 0.796875 },
-{ 0.21875, 0.796875, 0.21875, 0.703125, 0.265625, 0.703125, 0.265625, 0.796875 },
-{ 0.2734375, 0.796875, 0.2734375, 0.703125, 0.3203125, 0.703125, 0.3203125, 0.796875 },
-{ 0.328125, 0.796875, 0.328125, 0.703125, 0.375, 0.703125, 0.375, 0.796875 },
-{ 0.3828125, 0.796875, 0.3828125, 0.703125, 0.4296875, 0.703125, 0.4296875, 0.796875 },
-{ 0.4375, 0.796875, 0.4375, 0.703125, 0.484375, 0.703125, 0.484375, 0.796875 },
-{ 0.4921875, 0.796875, 0.4921875, 0.703125, 0.5390625, 0.703125, 0.5390625, 0.796875 },
-{ 0.546875, 0.796875, 0.546875, 0.703125, 0.59375, 0.703125, 0.59375, 0.796875 },
-{ 0.6015625, 0.796875, 0.6015625, 0.703125, 0.6484375, 0.703125, 0.6484375, 0.796875 },
-{ 0.65625, 0.796875, 0.65625, 0.703125, 0.703125, 0.703125, 0.703125, 0.796875 },
-{ 0.7109375, 0.796875, 0.7109375, 0.703125, 0.7578125, 0.703125, 0.7578125, 0.796875 },
-{ 0.0, 0.6953125, 0.0, 0.6015625, 0.046875, 0.6015625, 0.046875, 0.6953125 },
-{ 0.0546875, 0.6953125, 0.0546875, 0.6015625, 0.1015625, 0.6015625, 0.1015625, 0.6953125 },
-{ 0.109375, 0.6953125, 0.109375, 0.6015625, 0.15625, 0.6015625, 0.15625, 0.6953125 },
-{ 0.1640625, 0.6953125, 0.1640625, 0.6015625, 0.2109375, 0.6015625, 0.2109375, 0.6953125 },
-{ 0.21875, 0.6953125, 0.21875, 0.6015625, 0.265625, 0.6015625, 0.265625, 0.6953125 },
-{ 0.2734375, 0.6953125, 0.2734375, 0.6015625, 0.3203125, 0.6015625, 0.3203125, 0.6953125 },
-{ 0.328125, 0.6953125, 0.328125, 0.6015625, 0.375, 0.6015625, 0.375, 0.6953125 },
-{ 0.3828125, 0.6953125, 0.3828125, 0.6015625, 0.4296875, 0.6015625, 0.4296875, 0.6953125 },
-{ 0.4375, 0.6953125, 0.4375, 0.6015625, 0.484375, 0.6015625, 0.484375, 0.6953125 },
-{ 0.4921875, 0.6953125, 0.4921875, 0.6015625, 0.5390625, 0.6015625, 0.5390625, 0.6953125 },
-{ 0.546875, 0.6953125, 0.546875, 0.6015625, 0.59375, 0.6015625, 0.59375, 0.6953125 },
-{ 0.6015625, 0.6953125, 0.6015625, 0.6015625, 0.6484375, 0.6015625, 0.6484375, 0.6953125 },
-{ 0.65625, 0.6953125, 0.65625, 0.6015625, 0.703125, 0.6015625, 0.703125, 0.6953125 },
-{ 0.7109375, 0.6953125, 0.7109375, 0.6015625, 0.7578125, 0.6015625, 0.7578125, 0.6953125 },
-{ 0.0, 0.59375, 0.0, 0.5, 0.046875, 0.5, 0.046875, 0.59375 },
-{ 0.0546875, 0.59375, 0.0546875, 0.5, 0.1015625, 0.5, 0.1015625, 0.59375 },
-{ 0.109375, 0.59375, 0.109375, 0.5, 0.15625, 0.5, 0.15625, 0.59375 },
-{ 0.1640625, 0.59375, 0.1640625, 0.5, 0.2109375, 0.5, 0.2109375, 0.59375 },
-{ 0.21875, 0.59375, 0.21875, 0.5, 0.265625, 0.5, 0.265625, 0.59375 },
-{ 0.2734375, 0.59375, 0.2734375, 0.5, 0.3203125, 0.5, 0.3203125, 0.59375 },
-{ 0.328125, 0.59375, 0.328125, 0.5, 0.375, 0.5, 0.375, 0.59375 },
-{ 0.3828125, 0.59375, 0.3828125, 0.5, 0.4296875, 0.5, 0.4296875, 0.59375 },
-{ 0.4375, 0.59375, 0.4375, 0.5, 0.484375, 0.5, 0.484375, 0.59375 },
-{ 0.4921875, 0.59375, 0.4921875, 0.5, 0.5390625, 0.5, 0.5390625, 0.59375 },
-{ 0.546875, 0.59375, 0.546875, 0.5, 0.59375, 0.5, 0.59375, 0.59375 },
-{ 0.6015625, 0.59375, 0.6015625, 0.5, 0.6484375, 0.5, 0.6484375, 0.59375 },
-{ 0.65625, 0.59375, 0.65625, 0.5, 0.703125, 0.5, 0.703125, 0.59375 },
-{ 0.7109375, 0.59375, 0.7109375, 0.5, 0.7578125, 0.5, 0.7578125, 0.59375 },
-{ 0.0, 0.4921875, 0.0, 0.3984375, 0.046875, 0.3984375, 0.046875, 0.4921875 },
-{ 0.0546875, 0.4921875, 0.0546875, 0.3984375, 0.1015625, 0.3984375, 0.1015625, 0.4921875 },
-{ 0.109375, 0.4921875, 0.109375, 0.3984375, 0.15625, 0.3984375, 0.15625, 0.4921875 },
-{ 0.1640625, 0.4921875, 0.1640625, 0.3984375, 0.2109375, 0.3984375, 0.2109375, 0.4921875 },
-{ 0.21875, 0.4921875, 0.21875, 0.3984375, 0.265625, 0.3984375, 0.265625, 0.4921875 },
-{ 0.2734375, 0.4921875, 0.2734375, 0.3984375, 0.3203125, 0.3984375, 0.3203125, 0.4921875 },
-{ 0.328125, 0.4921875, 0.328125, 0.3984375, 0.375, 0.3984375, 0.375, 0.4921875 },
-{ 0.3828125, 0.4921875, 0.3828125, 0.3984375, 0.4296875, 0.3984375, 0.4296875, 0.4921875 },
-{ 0.4375, 0.4921875, 0.4375, 0.3984375, 0.484375, 0.3984375, 0.484375, 0.4921875 },
-{ 0.4921875, 0.4921875, 0.4921875, 0.3984375, 0.5390625, 0.3984375, 0.5390625, 0.4921875 },
-{ 0.546875, 0.4921875, 0.546875, 0.3984375, 0.59375, 0.3984375, 0.59375, 0.4921875 },
-{ 0.6015625, 0.4921875, 0.6015625, 0.3984375, 0.6484375, 0.3984375, 0.6484375, 0.4921875 },
-{ 0.65625, 0.4921875, 0.65625, 0.3984375, 0.703125, 0.3984375, 0.703125, 0.4921875 },
-{ 0.7109375, 0.4921875, 0.7109375, 0.3984375, 0.7578125, 0.3984375, 0.7578125, 0.4921875 },
-{ 0.0, 0.390625, 0.0, 0.296875, 0.046875, 0.296875, 0.046875, 0.390625 },
-{ 0.0546875, 0.390625, 0.0546875, 0.296875, 0.1015625, 0.296875, 0.1015625, 0.390625 },
-{ 0.109375, 0.390625, 0.109375, 0.296875, 0.15625, 0.296875, 0.15625, 0.390625 },
-{ 0.1640625, 0.390625, 0.1640625, 0.296875, 0.2109375, 0.296875, 0.2109375, 0.390625 },
-{ 0.21875, 0.390625, 0.21875, 0.296875, 0.265625, 0.296875, 0.265625, 0.390625 },
-{ 0.2734375, 0.390625, 0.2734375, 0.296875, 0.3203125, 0.296875, 0.3203125, 0.390625 },
-{ 0.328125, 0.390625, 0.328125, 0.296875, 0.375, 0.296875, 0.375, 0.390625 },
-{ 0.3828125, 0.390625, 0.3828125, 0.296875, 0.4296875, 0.296875, 0.4296875, 0.390625 },
-{ 0.4375, 0.390625, 0.4375, 0.296875, 0.484375, 0.296875, 0.484375, 0.390625 },
-{ 0.4921875, 0.390625, 0.4921875, 0.296875, 0.5390625, 0.296875, 0.5390625, 0.390625 },
-{ 0.546875, 0.390625, 0.546875, 0.296875, 0.59375, 0.296875, 0.59375, 0.390625 },
-{ 0.6015625, 0.390625, 0.6015625, 0.296875, 0.6484375, 0.296875, 0.6484375, 0.390625 },
-{ 0.65625, 0.390625, 0.65625, 0.296875, 0.703125, 0.296875, 0.703125, 0.390625 },
-{ 0.7109375, 0.390625, 0.7109375, 0.296875, 0.7578125, 0.296875, 0.7578125, 0.390625 }
-};
@@ -0,0 +1,50 @@
+#include "ramp.h"
+
+#include <xmmintrin.h>
+
+void ramp_t::reset(float v) {
+	value = target = v;
+	step = 0;
+	remaining = 0;
+}
+
+void ramp_t::set_target(float t, int num_samples) {
+	if (num_samples <= 0) {
+		reset(t);
+		return;
+	}
+	target = t;
+	step = (t - value) / (float)num_samples;
+	remaining = num_samples;
+}
+
+void ramp_t::fill(float *out, int n) {
+	int i = 0;
+	int ramp_len = remaining < n ? remaining : n;
+
+	if (ramp_len > 0) {
+		// the values are computed from the block start rather than accumulated, so there's no drift
+		const __m128 offsets = _mm_set_ps(4, 3, 2, 1);
+		const __m128 vstep = _mm_set1_ps(step);
+		const float start = value;
+
+		for (; i + 4 <= ramp_len; i += 4) {
+			__m128 k = _mm_add_ps(_mm_set1_ps((float)i), offsets);
+			_mm_storeu_ps(&out[i], _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(k, vstep)));
+		}
+		for (; i < ramp_len; ++i) {
+			out[i] = start + (float)(i + 1) * step;
+		}
+
+		remaining -= ramp_len;
+		value = remaining > 0 ? start + (float)ramp_len * step : target;
+	}
+
+	const __m128 vt = _mm_set1_ps(value);
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(&out[i], vt);
+	}
+	for (; i < n; ++i) {
+		out[i] = value;
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// Linear parameter ramp, evaluated a block at a time. Used wherever a value that the user edits
+// reaches the audio thread, so that changes glide over a number of samples instead of stepping.
+
+struct ramp_t {
+	float value;
+	float target;
+	float step;
+	int remaining;	// samples left until value == target
+
+	ramp_t() : value(0), target(0), step(0), remaining(0) {}
+
+	void reset(float v);
+	void set_target(float t, int num_samples);
+	bool ramping() const { return remaining > 0; }
+
+	// writes the next n per-sample values to out and advances the ramp
+	void fill(float *out, int n);
+};
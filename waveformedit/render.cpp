@@ -0,0 +1,554 @@
+#include "render.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "lin_alg.h"
+#include "glstate.h"
+#include "texture.h"
+#include "text.h"
+#include "glyphs.h"
+#include "tilecache.h"
+#include "wavelod.h"
+#include "gputimer.h"
+#include "stats.h"
+
+static const float control_x[4] = { 0.0, 0.33, 0.66, 1.0 };
+
+// the curve area the view starts out showing (and always shows vertically)
+#define VIEW_LEFT -0.1
+#define VIEW_RIGHT 1.1
+#define VIEW_BOTTOM -1.5
+#define VIEW_TOP 1.5
+
+// the material in the view: the edited cycle looped this many times
+#define VIEW_PERIODS (1 << 20)
+
+// a pixel is (VIEW_RIGHT - VIEW_LEFT) / width * 2^-zoom curve units. zoomed all the way out a period is
+// still a couple of pixels wide
+#define VIEW_ZOOM_MIN -9
+#define VIEW_ZOOM_MAX 4
+
+// shaders/grid/fs has the same
+#define GRID_MIN_SPACING_PX 12.0
+
+// with periods narrower than this the wave is drawn from the reduced columns (see wavelod.h), the 64 segment
+// patches would be under a pixel each
+#define WAVE_LOD_PERIOD_PX 64.0
+
+// missing tiles past the edges of the view rendered per frame, for the pan that's likely next. the visible
+// ones are always rendered
+#define TILE_PREFETCH 2
+
+static int viewport_width = 1, viewport_height = 1;
+
+static double view_left = VIEW_LEFT;
+static int view_zoom = 0;
+
+// the curve the cached tiles show
+static render_curve_t tiles_curve;
+static bool have_tiles_curve = false;
+
+// false if the atlas framebuffer couldn't be made, then the wave is drawn straight to the view every frame
+static bool tiles_available = false;
+
+static GLuint wave_VAOid;
+
+// marker positions stream through this, each draw maps the next free range without waiting on the GPU and the
+// storage is orphaned when it runs out
+#define MARKER_STREAM_BYTES (1 << 20)
+static GLuint marker_VBOid, marker_VAOid;
+static GLsizeiptr marker_stream_pos = 0;
+
+// half extents of a marker in curve units
+#define MARKER_SIZE_X 0.01
+#define MARKER_SIZE_Y 0.026
+
+enum { MARKER_TRIANGLE, MARKER_CIRCLE };
+static const GLsizei marker_vertices[2] = { 3, 4 };
+
+void render_curve_at(float time, render_curve_t *curve) {
+	curve->y[0] = 0.0;
+	curve->y[1] = sin(time);
+	curve->y[2] = -sin(time);
+	curve->y[3] = 0.0;
+}
+
+void render_init() {
+	glClearColor(0.0, 0.0, 0.0, 1.0);
+	glEnable(GL_DEPTH_TEST);
+
+	// only enabled for the markers
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	gls_patch_parameteri(GL_PATCH_VERTICES, 1);
+
+	// no attributes, a patch per period and the period comes from gl_VertexID
+	glGenVertexArrays(1, &wave_VAOid);
+
+	// the markers, one vec2 per instance, the corners come from gl_VertexID
+	glGenVertexArrays(1, &marker_VAOid);
+	gls_bind_vertex_array(marker_VAOid);
+
+	glEnableVertexAttribArray(ATTRIB_POSITION);
+	glVertexAttribDivisor(ATTRIB_POSITION, 1);
+
+	glGenBuffers(1, &marker_VBOid);
+	gls_bind_buffer(GL_ARRAY_BUFFER, marker_VBOid);
+	glBufferData(GL_ARRAY_BUFFER, MARKER_STREAM_BYTES, NULL, GL_STREAM_DRAW);
+
+	gls_bind_vertex_array(0);
+	gls_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+	wave_lod_init();
+	text_init();
+	gpu_timer_init();
+}
+
+// curve units per pixel
+static double view_px() {
+	return (VIEW_RIGHT - VIEW_LEFT) / viewport_width * pow(2.0, -view_zoom);
+}
+
+static double view_right() {
+	return view_left + viewport_width * view_px();
+}
+
+// keeps some of the material in view and puts the left edge on a whole pixel, so the tiles land 1:1
+static void snap_view() {
+	double px = view_px();
+	double half = 0.5 * viewport_width * px;
+	if (view_left < -half) view_left = -half;
+	if (view_left > VIEW_PERIODS - half) view_left = VIEW_PERIODS - half;
+	view_left = floor(view_left / px + 0.5) * px;
+}
+
+void render_resize(int width, int height) {
+	// the tiles are keyed on the zoom level, what that means in curve units goes with the width
+	if (width != viewport_width) {
+		tile_cache_invalidate(-HUGE_VAL, HUGE_VAL);
+	}
+	viewport_width = width;
+	viewport_height = height;
+	snap_view();
+	tiles_available = tile_cache_init(height) != 0;
+}
+
+void render_pan(double px) {
+	view_left += px * view_px();
+	snap_view();
+}
+
+void render_zoom(int steps, double anchor_px) {
+	double anchor = view_left + anchor_px * view_px();
+	view_zoom += steps;
+	if (view_zoom < VIEW_ZOOM_MIN) view_zoom = VIEW_ZOOM_MIN;
+	if (view_zoom > VIEW_ZOOM_MAX) view_zoom = VIEW_ZOOM_MAX;
+	view_left = anchor - anchor_px * view_px();
+	snap_view();
+}
+
+void render_view_reset() {
+	view_left = VIEW_LEFT;
+	view_zoom = 0;
+	snap_view();
+}
+
+static mat4 view_mvp() {
+	return mat4::proj_ortho(view_left, view_right(), VIEW_BOTTOM, VIEW_TOP, -1.0, 1.0);
+}
+
+// where the grid puts its ticks for a pixel size of px curve units
+static double grid_tick_spacing(double px) {
+	return 10.0 * pow(10.0, ceil(log10(GRID_MIN_SPACING_PX * px)));
+}
+
+// far into the material the curve coordinates are too big for floats to place pixels, so the grid and the
+// tiles work relative to this. a multiple of the coarsest grid spacing, the grid lines stay where they are
+static double view_origin() {
+	double coarsest = 10.0 * grid_tick_spacing(view_px());
+	return floor(view_left / coarsest) * coarsest;
+}
+
+// time labels under the time axis, amplitude labels left of the amplitude axis (or the view's left edge)
+static void print_axis_labels() {
+	double px_x = view_px();
+	double px_y = (VIEW_TOP - VIEW_BOTTOM) / viewport_height;
+	char label[32];
+
+	double step = grid_tick_spacing(px_x);
+	int decimals = step < 1.0 ? (int)ceil(-log10(step) - 1e-9) : 0;
+	double x_end = view_right() < VIEW_PERIODS ? view_right() : VIEW_PERIODS;
+	for (double i = ceil((view_left > 0 ? view_left : 0) / step); i * step <= x_end + 1e-9; i += 1) {
+		snprintf(label, sizeof(label), "%.*f", decimals, i * step);
+		float sx = (float)((i * step - view_left) / px_x);
+		float sy = (float)(VIEW_TOP / px_y);
+		text_print(sx - 0.5f * text_width(label), sy + 6, TEXT_COLOR_LABEL, label);
+	}
+
+	step = grid_tick_spacing(px_y);
+	for (int i = (int)ceil(-1.0 / step - 1e-6); i * step <= 1.0 + 1e-6; ++i) {
+		snprintf(label, sizeof(label), "%g", i * step);
+		float sx = (float)(-view_left / px_x);
+		if (sx < text_width(label) + 8) sx = (float)(text_width(label) + 8);
+		float sy = (float)((VIEW_TOP - i * step) / px_y);
+		text_print(sx - text_width(label) - 8, sy - 0.5f * GLYPH_HEIGHT, TEXT_COLOR_LABEL, label);
+	}
+}
+
+// the wave program turns the control points into the cubic's coefficients with this
+static mat4 curve_coefs_inv() {
+	mat4 m = mat4(
+		vec4(0, 0, 0, 1),
+		vec4((0.33*0.33*0.33), (0.33*0.33), 0.33, 1),
+		vec4((0.66*0.66*0.66), (0.66*0.66), 0.66, 1),
+		vec4(1, 1, 1, 1));
+	m.invert();
+	return m;
+}
+
+// one period of the curve for the column reduction, the same cubic the tessellated wave draws
+static void sample_cycle(const render_curve_t *curve, float *samples) {
+	vec4 coefs = curve_coefs_inv().transposed() * vec4(curve->y[0], curve->y[1], curve->y[2], curve->y[3]);
+	for (int i = 0; i < WAVE_LOD_CYCLE_SAMPLES; ++i) {
+		float x = (float)i / (float)WAVE_LOD_CYCLE_SAMPLES;
+		float x2 = x*x;
+		samples[i] = dot4(coefs, vec4(x2*x, x2, x, 1));
+	}
+}
+
+static bool view_lod(const render_programs_t *programs) {
+	return programs->wave_lod && 1.0 / view_px() < WAVE_LOD_PERIOD_PX;
+}
+
+double render_lod_check(const render_programs_t *programs, double *gpu_ms, double *cpu_ms) {
+	return wave_lod_check(programs->wave_reduce, viewport_width, view_left, view_px(), gpu_ms, cpu_ms);
+}
+
+static void clear_tile(const tile_rect_t *r) {
+	glViewport(r->x, r->y, r->width, r->height);
+	glScissor(r->x, r->y, r->width, r->height);
+	glEnable(GL_SCISSOR_TEST);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glClearColor(0.0, 0.0, 0.0, 1.0);
+	glDisable(GL_SCISSOR_TEST);
+}
+
+// the curve x0..x1 into a tile, every period in it is one patch
+static void render_tile(ShaderProgram *wave_shader, const tile_rect_t *r, double x0, double x1) {
+	clear_tile(r);
+
+	// relative to the first period touched, they all look the same
+	double p0 = floor(x0);
+	double first = p0 > 0 ? p0 : 0;
+	double last = ceil(x1) < VIEW_PERIODS ? ceil(x1) : VIEW_PERIODS;
+	if (last <= first) {
+		return;
+	}
+	wave_shader->update_uniform_mat4("uMVP", mat4::proj_ortho(x0 - p0, x1 - p0, VIEW_BOTTOM, VIEW_TOP, -1.0, 1.0));
+	glDrawArrays(GL_PATCHES, (GLint)(first - p0), (GLsizei)(last - first));
+}
+
+// the same from the columns, reduced into the slot's region of the column buffer first
+static void render_tile_lod(const render_programs_t *programs, int slot, const tile_rect_t *r, double x0) {
+	clear_tile(r);
+
+	int first_column = slot * TILE_WIDTH;
+	wave_lod_reduce(programs->wave_reduce, first_column, TILE_WIDTH, x0, view_px());
+
+	// the reduction had the samples on this unit
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, wave_lod_columns_texture());
+	programs->wave_lod->update_uniform_1i("first_column", first_column);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, 2 * TILE_WIDTH);
+}
+
+// the wave (or lod) program for num_columns pixels wide
+static void use_wave_program(const render_programs_t *programs, const render_curve_t *curve, float time, bool lod, int num_columns) {
+	if (lod) {
+		ShaderProgram *lod_shader = programs->wave_lod;
+		gls_use_program(lod_shader->getProgramHandle());
+		lod_shader->update_uniform_1i("columns", 0);
+		lod_shader->update_uniform_1i("num_columns", num_columns);
+		lod_shader->update_uniform_2f("y_range", VIEW_BOTTOM, VIEW_TOP);
+		lod_shader->update_uniform_1f("px_y", (GLfloat)((VIEW_TOP - VIEW_BOTTOM) / viewport_height));
+	}
+	else {
+		ShaderProgram *wave_shader = programs->wave;
+		gls_use_program(wave_shader->getProgramHandle());
+		wave_shader->update_uniform_1f("TIME", time);
+		wave_shader->update_uniform_mat4("coefs_inv", curve_coefs_inv());
+		wave_shader->update_uniform_vec4("y_coords", vec4(curve->y[0], curve->y[1], curve->y[2], curve->y[3]));
+		gls_patch_parameteri(GL_PATCH_VERTICES, 1);
+	}
+	gls_bind_vertex_array(wave_VAOid);
+}
+
+// renders tile i into a fresh slot. the first one of a frame switches to the atlas framebuffer and sets up the
+// wave (or lod) program, tile_pass_end switches back
+struct tile_pass_t {
+	const render_programs_t *programs;
+	const render_curve_t *curve;
+	float time;
+	double tile_units;
+	bool lod;
+	GLint target_fbo;
+	bool rendering;
+	int num_rendered;
+};
+
+static int render_tile_into_cache(tile_pass_t *pass, long long i) {
+	double x0 = i * pass->tile_units, x1 = (i + 1) * pass->tile_units;
+	int slot = tile_cache_insert(view_zoom, i, x0, x1);
+	if (slot < 0) {
+		return -1;
+	}
+
+	if (!pass->rendering) {
+		// the window's back buffer or the headless framebuffer, whichever is drawing
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &pass->target_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, tile_cache_framebuffer());
+		glDisable(GL_DEPTH_TEST);
+		use_wave_program(pass->programs, pass->curve, pass->time, pass->lod, TILE_WIDTH);
+		pass->rendering = true;
+	}
+
+	tile_rect_t r;
+	tile_cache_slot_rect(slot, &r);
+	if (pass->lod) {
+		render_tile_lod(pass->programs, slot, &r, x0);
+	}
+	else {
+		render_tile(pass->programs->wave, &r, x0, x1);
+	}
+	++pass->num_rendered;
+	return slot;
+}
+
+static void tile_pass_end(tile_pass_t *pass) {
+	if (pass->rendering) {
+		glBindFramebuffer(GL_FRAMEBUFFER, pass->target_fbo);
+		glViewport(0, 0, viewport_width, viewport_height);
+		glEnable(GL_DEPTH_TEST);
+	}
+}
+
+static bool tile_in_material(long long i, double tile_units) {
+	return (i + 1) * tile_units > 0 && i * tile_units < VIEW_PERIODS;
+}
+
+// without the tile cache, the visible part of the wave over the grid, all of it every frame
+static void render_wave_direct(const render_programs_t *programs, const render_curve_t *curve, float time) {
+	gpu_timer_begin("gpu wave direct ms");
+	bool lod = view_lod(programs);
+	int columns = viewport_width < WAVE_LOD_COLUMNS ? viewport_width : WAVE_LOD_COLUMNS;
+	use_wave_program(programs, curve, time, lod, columns);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	if (lod) {
+		wave_lod_reduce(programs->wave_reduce, 0, columns, view_left, view_px());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, wave_lod_columns_texture());
+		programs->wave_lod->update_uniform_1i("first_column", 0);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, 2 * columns);
+	}
+	else {
+		// relative to the first period in view like the tiles
+		double x0 = view_left, x1 = view_right();
+		double p0 = floor(x0);
+		double first = p0 > 0 ? p0 : 0;
+		double last = ceil(x1) < VIEW_PERIODS ? ceil(x1) : VIEW_PERIODS;
+		if (last > first) {
+			programs->wave->update_uniform_mat4("uMVP", mat4::proj_ortho(x0 - p0, x1 - p0, VIEW_BOTTOM, VIEW_TOP, -1.0, 1.0));
+			glDrawArrays(GL_PATCHES, (GLint)(first - p0), (GLsizei)(last - first));
+		}
+	}
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	gpu_timer_end();
+}
+
+// the wave from the tile cache: missing visible tiles are rendered into the atlas and the visible ones drawn
+// over the grid. in a frame that found everything cached, a few tiles past the edges get rendered ahead
+static void render_wave(const render_programs_t *programs, const render_curve_t *curve, float time) {
+	// every period shows the same cycle, so an edit touches all of the material
+	if (!have_tiles_curve || memcmp(curve, &tiles_curve, sizeof(*curve)) != 0) {
+		tile_cache_invalidate(-HUGE_VAL, HUGE_VAL);
+		tiles_curve = *curve;
+		have_tiles_curve = true;
+
+		static float samples[WAVE_LOD_CYCLE_SAMPLES];
+		sample_cycle(curve, samples);
+		wave_lod_set_cycle(samples, VIEW_PERIODS);
+	}
+	if (!tiles_available) {
+		render_wave_direct(programs, curve, time);
+		return;
+	}
+	tile_cache_begin_frame();
+
+	// the tiles that get drawn this frame, tessellated or reduced into columns
+	gpu_timer_begin("gpu wave tiles ms");
+	double px = view_px();
+	tile_pass_t pass = { programs, curve, time, TILE_WIDTH * px, view_lod(programs), 0, false, 0 };
+	long long first_visible = (long long)floor(view_left / pass.tile_units);
+	long long last_visible = (long long)ceil(view_right() / pass.tile_units) - 1;
+
+	static const int max_visible = 64;
+	long long visible_index[max_visible];
+	int visible_slot[max_visible];
+	int num_visible = 0, num_cached = 0;
+
+	for (long long i = first_visible; i <= last_visible && num_visible < max_visible; ++i) {
+		if (!tile_in_material(i, pass.tile_units)) {
+			continue;
+		}
+		int slot = tile_cache_find(view_zoom, i);
+		if (slot >= 0) {
+			++num_cached;
+		}
+		else {
+			slot = render_tile_into_cache(&pass, i);
+		}
+		if (slot >= 0) {
+			visible_index[num_visible] = i;
+			visible_slot[num_visible] = slot;
+			++num_visible;
+		}
+	}
+
+	if (pass.num_rendered == 0) {
+		int num_prefetched = 0;
+		for (int d = 1; d <= TILE_PREFETCH && num_prefetched < TILE_PREFETCH; ++d) {
+			long long ahead[2] = { first_visible - d, last_visible + d };
+			for (int k = 0; k < 2 && num_prefetched < TILE_PREFETCH; ++k) {
+				if (tile_in_material(ahead[k], pass.tile_units) && tile_cache_find(view_zoom, ahead[k]) < 0) {
+					render_tile_into_cache(&pass, ahead[k]);
+					++num_prefetched;
+				}
+			}
+		}
+	}
+
+	tile_pass_end(&pass);
+	gpu_timer_end();
+	double tile_units = pass.tile_units;
+
+	// the visible tiles, 1:1 from the atlas
+	gpu_timer_begin("gpu wave composite ms");
+	ShaderProgram *tile_shader = programs->tile;
+	gls_use_program(tile_shader->getProgramHandle());
+	tile_shader->update_uniform_2f("viewport", (GLfloat)viewport_width, (GLfloat)viewport_height);
+	tile_shader->update_uniform_1i("tiles", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tile_cache_texture());
+	gls_bind_vertex_array(wave_VAOid);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	float atlas_w = (float)tile_cache_atlas_width(), atlas_h = (float)tile_cache_atlas_height();
+	for (int k = 0; k < num_visible; ++k) {
+		tile_rect_t r;
+		tile_cache_slot_rect(visible_slot[k], &r);
+		double screen_x = floor((visible_index[k] * tile_units - view_left) / px + 0.5);
+		tile_shader->update_uniform_vec4("screen_rect", vec4((float)screen_x, 0, (float)r.width, (float)r.height));
+		tile_shader->update_uniform_vec4("atlas_rect", vec4(r.x / atlas_w, r.y / atlas_h, r.width / atlas_w, r.height / atlas_h));
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	gpu_timer_end();
+
+	stats_add("wave tiles rendered", pass.num_rendered);
+	stats_add("wave tiles from cache", num_cached);
+}
+
+void render_markers(const render_programs_t *programs, const float *xy, int count) {
+	gpu_timer_begin("gpu markers ms");
+	ShaderProgram *point_shader = programs->point;
+	gls_use_program(point_shader->getProgramHandle());
+	point_shader->update_uniform_mat4("uMVP", view_mvp());
+	point_shader->update_uniform_2f("marker_size", MARKER_SIZE_X, MARKER_SIZE_Y);
+	int shape = MARKER_TRIANGLE;
+	point_shader->update_uniform_1i("shape", shape);
+
+	gls_bind_vertex_array(marker_VAOid);
+	gls_bind_buffer(GL_ARRAY_BUFFER, marker_VBOid);
+	glEnable(GL_BLEND);
+
+	const int max_batch = MARKER_STREAM_BYTES / (2*sizeof(float));
+	while (count > 0) {
+		int n = count < max_batch ? count : max_batch;
+		GLsizeiptr size = n*2*sizeof(float);
+		if (marker_stream_pos + size > MARKER_STREAM_BYTES) {
+			// the GPU may still be reading the old storage, the driver hands out a fresh one
+			glBufferData(GL_ARRAY_BUFFER, MARKER_STREAM_BYTES, NULL, GL_STREAM_DRAW);
+			marker_stream_pos = 0;
+		}
+		void *dst = glMapBufferRange(GL_ARRAY_BUFFER, marker_stream_pos, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (!dst) {
+			break;
+		}
+		memcpy(dst, xy, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (const void*)marker_stream_pos);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, marker_vertices[shape], n);
+
+		marker_stream_pos += size;
+		xy += 2*n;
+		count -= n;
+	}
+
+	glDisable(GL_BLEND);
+	gpu_timer_end();
+}
+
+void render_frame(const render_programs_t *programs, const render_curve_t *curve, float time) {
+
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// grid, first so it's under everything. it writes every pixel, so only depth needs clearing
+	double origin = view_origin();
+	mat4 inv_mvp = mat4::proj_ortho(view_left - origin, view_right() - origin, VIEW_BOTTOM, VIEW_TOP, -1.0, 1.0);
+	inv_mvp.invert();
+
+	gpu_timer_begin("gpu grid ms");
+	ShaderProgram *grid_shader = programs->grid;
+	gls_use_program(grid_shader->getProgramHandle());
+	grid_shader->update_uniform_mat4("inv_mvp", inv_mvp);
+	grid_shader->update_uniform_vec4("bounds", vec4((float)-origin, -1.0, (float)(VIEW_PERIODS - origin), 1.0));
+
+	gls_bind_vertex_array(0);	// no attributes, the triangle comes from gl_VertexID
+	glDisable(GL_DEPTH_TEST);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glEnable(GL_DEPTH_TEST);
+	gpu_timer_end();
+
+	// wave
+	render_wave(programs, curve, time);
+
+	// control points
+	float points[8];
+	for (int i = 0; i < 4; ++i) {
+		points[2*i] = control_x[i];
+		points[2*i + 1] = curve->y[i];
+	}
+	render_markers(programs, points, 4);
+
+	// all the text of the frame in one draw
+	gpu_timer_begin("gpu text ms");
+	if (programs->text && programs->font) {
+		print_axis_labels();
+		text_flush(programs->text, programs->font->id(), viewport_width, viewport_height);
+	}
+	else {
+		text_flush(NULL, 0, 0, 0);
+	}
+	gpu_timer_end();
+
+}
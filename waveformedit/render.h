@@ -0,0 +1,44 @@
+#pragma once
+
+#include "shader.h"
+
+// the editor's drawing, kept apart from the window so the same passes run in a headless context too
+// (see platform.h and headless.cpp)
+
+class Texture;
+
+struct render_programs_t {
+	ShaderProgram *wave, *point, *grid;
+	ShaderProgram *tile;	// draws the cached wave tiles (see tilecache.h)
+	ShaderProgram *wave_lod;	// the zoomed out wave (see wavelod.h)
+	ShaderProgram *wave_reduce;	// its column reduction, NULL to reduce on the CPU
+	ShaderProgram *text;	// NULL for no text
+	Texture *font;			// the glyph atlas, NULL for no text
+};
+
+// the edited curve, control points at x = 0, 0.33, 0.66 and 1
+struct render_curve_t {
+	float y[4];
+};
+
+// the placeholder animation the editor runs until there's real editing
+void render_curve_at(float time, render_curve_t *curve);
+
+// GL state and vertex arrays, the context must be current
+void render_init();
+// the drawable size in pixels
+void render_resize(int width, int height);
+
+// the view over the material (the edited cycle, looped). pan in pixels, zoom in steps of two around the
+// pixel column anchor_px from the left
+void render_pan(double px);
+void render_zoom(int steps, double anchor_px);
+void render_view_reset();
+// the column reduction for the current view on the GPU against the CPU reference, see wave_lod_check
+double render_lod_check(const render_programs_t *programs, double *gpu_ms, double *cpu_ms);
+
+// text printed before this (see text.h) is drawn at the end together with the axis labels
+void render_frame(const render_programs_t *programs, const render_curve_t *curve, float time);
+
+// control point markers (x, y pairs in curve units) as instanced quads, any number of them
+void render_markers(const render_programs_t *programs, const float *xy, int count);
@@ -0,0 +1,135 @@
+#include "resample.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <xmmintrin.h>
+
+#define PI 3.14159265358979
+
+#define KAISER_BETA 8.0
+
+// zeroth order modified bessel function of the first kind, for the kaiser window
+static double bessel_I0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+void resampler_t::init(int in_rate, int out_rate, int channels, int max_output_frames) {
+	ratio = (double)in_rate / (double)out_rate;
+	num_channels = channels;
+
+	// when going down in rate the cutoff has to follow the output nyquist. a bit of margin either way,
+	// the kaiser window's transition band isn't infinitely steep
+	double cutoff = 0.96 * (ratio > 1.0 ? 1.0 / ratio : 1.0);
+
+	const int half = RESAMPLER_TAPS / 2;
+	const double I0_beta = bessel_I0(KAISER_BETA);
+
+	table = new float[(RESAMPLER_PHASES + 1) * RESAMPLER_TAPS];
+
+	for (int p = 0; p <= RESAMPLER_PHASES; ++p) {
+		double frac = (double)p / (double)RESAMPLER_PHASES;
+		float *row = &table[p * RESAMPLER_TAPS];
+		double sum = 0;
+
+		for (int k = 0; k < RESAMPLER_TAPS; ++k) {
+			// tap k reads input[i - half + 1 + k] for an output at position i + frac
+			double d = (double)(k - (half - 1)) - frac;
+			double x = cutoff * d;
+			double sinc = fabs(x) < 1e-9 ? 1.0 : sin(PI * x) / (PI * x);
+
+			double r = d / (double)half;
+			double w = fabs(r) >= 1.0 ? 0.0 : bessel_I0(KAISER_BETA * sqrt(1.0 - r*r)) / I0_beta;
+
+			row[k] = (float)(sinc * w);
+			sum += row[k];
+		}
+
+		// unity DC gain for every phase
+		for (int k = 0; k < RESAMPLER_TAPS; ++k) {
+			row[k] = (float)(row[k] / sum);
+		}
+	}
+
+	input_capacity = RESAMPLER_TAPS + (int)ceil(max_output_frames * ratio) + 4;
+	for (int c = 0; c < num_channels; ++c) {
+		input[c] = new float[input_capacity];
+		memset(input[c], 0, input_capacity * sizeof(float));
+	}
+
+	// start with half a filter of silence behind the read position, so the first output already has its history
+	input_len = half - 1;
+	position = half - 1;
+}
+
+void resampler_t::cleanup() {
+	delete[] table;
+	table = NULL;
+	for (int c = 0; c < RESAMPLER_MAX_CHANNELS; ++c) {
+		delete[] input[c];
+		input[c] = NULL;
+	}
+}
+
+int resampler_t::input_needed(int n_out) const {
+	// the last output reads up to floor(position + (n_out - 1)*ratio) + half
+	double last = position + (double)(n_out - 1) * ratio;
+	int needed = (int)floor(last) + RESAMPLER_TAPS / 2 + 1 - input_len;
+	return needed > 0 ? needed : 0;
+}
+
+static inline float hsum(__m128 v) {
+	__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(v, shuf);
+	shuf = _mm_movehl_ps(shuf, sums);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+void resampler_t::process(float **out, int n_out) {
+	const int half = RESAMPLER_TAPS / 2;
+
+	alignas(16) float coefs[RESAMPLER_TAPS];
+
+	for (int j = 0; j < n_out; ++j) {
+		int i = (int)position;
+		float phase = (float)((position - (double)i) * RESAMPLER_PHASES);
+		int p = (int)phase;
+		__m128 pf = _mm_set1_ps(phase - (float)p);
+
+		const float *t0 = &table[p * RESAMPLER_TAPS];
+		const float *t1 = t0 + RESAMPLER_TAPS;
+
+		for (int k = 0; k < RESAMPLER_TAPS; k += 4) {
+			__m128 a = _mm_loadu_ps(&t0[k]);
+			__m128 b = _mm_loadu_ps(&t1[k]);
+			_mm_store_ps(&coefs[k], _mm_add_ps(a, _mm_mul_ps(pf, _mm_sub_ps(b, a))));
+		}
+
+		for (int c = 0; c < num_channels; ++c) {
+			const float *x = &input[c][i - half + 1];
+			__m128 acc = _mm_setzero_ps();
+			for (int k = 0; k < RESAMPLER_TAPS; k += 4) {
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(&coefs[k]), _mm_loadu_ps(&x[k])));
+			}
+			out[c][j] = hsum(acc);
+		}
+
+		position += ratio;
+	}
+
+	// drop the input that no future output can reach anymore
+	int consumed = (int)position - (half - 1);
+	if (consumed > 0) {
+		if (consumed > input_len) consumed = input_len;
+		for (int c = 0; c < num_channels; ++c) {
+			memmove(input[c], input[c] + consumed, (input_len - consumed) * sizeof(float));
+		}
+		input_len -= consumed;
+		position -= consumed;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// Streaming polyphase sample rate converter for an arbitrary ratio. The windowed-sinc filter is
+// precomputed for RESAMPLER_PHASES fractional positions; the coefficients for the actual position
+// are linearly interpolated between the two nearest phases. Channels are planar, and all channels
+// share one set of interpolated coefficients per output frame.
+
+#define RESAMPLER_TAPS 32		// per output sample, must be a multiple of 4
+#define RESAMPLER_PHASES 256
+#define RESAMPLER_MAX_CHANNELS 2
+
+struct resampler_t {
+	double ratio;	// input rate / output rate
+	int num_channels;
+
+	float *table;	// (RESAMPLER_PHASES + 1) rows of RESAMPLER_TAPS
+	float *input[RESAMPLER_MAX_CHANNELS];
+	int input_len;	// frames currently buffered, including the history the filter needs
+	int input_capacity;
+	double position;	// fractional read position into input[]
+
+	resampler_t() : ratio(1.0), num_channels(0), table(NULL), input_len(0), input_capacity(0), position(0) {
+		for (int c = 0; c < RESAMPLER_MAX_CHANNELS; ++c) input[c] = NULL;
+	}
+
+	// everything is allocated here, max_output_frames is the largest block process() will be asked for
+	void init(int in_rate, int out_rate, int channels, int max_output_frames);
+	void cleanup();
+
+	// how many new input frames have to be appended before process(n_out) can run
+	int input_needed(int n_out) const;
+
+	// where the next input frames for channel c go. write n frames per channel and then commit(n)
+	float *input_ptr(int c) { return input[c] + input_len; }
+	void commit(int n) { input_len += n; }
+
+	// writes n_out frames to out[c] for each channel
+	void process(float **out, int n_out);
+};
@@ -1,8 +1,16 @@
 #include "glext_loader.h"
 #include "shader.h"
+#include "glstate.h"
 #include "lin_alg.h"
+#include "timer.h"
 
-#define PRINT(x, ...) do { printf(x, __VA_ARGS__); } while(0)
+#include <vector>
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#define PRINT(x, ...) do { printf(x, ##__VA_ARGS__); } while(0)
 
 static char logbuffer[1024];
 
@@ -17,85 +25,258 @@ static size_t cpp_getfilesize(std::ifstream& in) {
 	return length;
 }
 
-ShaderProgram::ShaderProgram(const std::string &name_base, const std::unordered_map<GLuint,std::string> &bindattrib_loc_names_map) { 	
+static void set_filenames(std::string *filenames, const std::string &name_base) {
+	filenames[VertexShader] = name_base + "/vs";
+	filenames[TessellationControlShader] = name_base + "/tcs";
+	filenames[TessellationEvaluationShader] = name_base + "/tes";
+	filenames[GeometryShader] = name_base + "/gs";
+	filenames[FragmentShader] = name_base + "/fs";
+	filenames[ComputeShader] = name_base + "/cs";
+}
 
-	for (int i = 0; i < 5; i++) shaderObjIDs[i] = SHADER_NONE;	
+void ShaderProgram::read_sources(const std::string &name_base, shader_sources_t *sources) {
+	std::string filenames[6];
+	set_filenames(filenames, name_base);
+	for (int i = VertexShader; i <= ComputeShader; i++) {
+		sources->len[i] = 0;
+		sources->buf[i] = NULL;
+	}
+	for (int i = VertexShader; i <= FragmentShader; i++) {
+		if (i == TessellationEvaluationShader && !sources->buf[TessellationControlShader]) continue;
+		if (i != VertexShader && !sources->buf[VertexShader]) break;
+		sources->buf[i] = ShaderProgram::readShaderFromFile(filenames[i], &sources->len[i]);
+	}
+	// no vertex shader, so a compute program
+	if (!sources->buf[VertexShader]) {
+		sources->buf[ComputeShader] = ShaderProgram::readShaderFromFile(filenames[ComputeShader], &sources->len[ComputeShader]);
+	}
+}
 
-	bad = false;
+void ShaderProgram::free_sources(shader_sources_t *sources) {
+	for (int i = VertexShader; i <= ComputeShader; i++) {
+		delete[] sources->buf[i];
+		sources->buf[i] = NULL;
+	}
+}
 
-	id_string = name_base;
-	shader_filenames[VertexShader] = name_base + "/vs";
-	shader_filenames[TessellationControlShader] = name_base + "/tcs";
-	shader_filenames[TessellationEvaluationShader] = name_base + "/tes";
-	shader_filenames[GeometryShader] = name_base + "/gs";
-	shader_filenames[FragmentShader] = name_base + "/fs";
+// program binary cache. a linked program is saved with glGetProgramBinary to SHADER_CACHE_DIR, keyed by a
+// hash of the stage sources, the attribute bindings and the driver's vendor/renderer/version strings, and
+// the next launch gets it back with glProgramBinary instead of compiling. a key mismatch or the driver
+// refusing the binary (after a driver update, typically) just means compiling as usual and rewriting the file
+
+#define SHADER_CACHE_DIR "shader_cache"
+#define SHADER_CACHE_MAGIC 0x43534657	// "WFSC"
+
+struct shader_cache_header_t {
+	unsigned magic;
+	unsigned format;
+	unsigned long long key;
+	unsigned length;
+};
+
+static unsigned long long fnv1a(unsigned long long h, const void *data, size_t len) {
+	const unsigned char *p = (const unsigned char*)data;
+	for (size_t i = 0; i < len; ++i) {
+		h ^= p[i];
+		h *= 0x100000001B3ULL;
+	}
+	return h;
+}
 
-	GLsizei vs_len, tcs_len, tes_len, gs_len, fs_len;
+static unsigned long long fnv1a_str(unsigned long long h, const char *str) {
+	if (!str) str = "";
+	return fnv1a(h, str, strlen(str) + 1);
+}
 
-	char *vs_buf = NULL, 
-	     *tcs_buf = NULL,
-	     *tes_buf = NULL,
-	     *gs_buf = NULL, 
-	     *fs_buf = NULL;
+static unsigned long long shader_cache_key(const shader_sources_t *sources, const std::unordered_map<GLuint,std::string> &bindattrib_loc_names_map) {
+	unsigned long long h = 0xCBF29CE484222325ULL;
 
-	
-	// note: program will leak memory on error, but then again these kinds of errors are considered "fatal"
+	for (int i = VertexShader; i <= ComputeShader; i++) {
+		GLsizei len = sources->buf[i] ? sources->len[i] : -1;
+		h = fnv1a(h, &len, sizeof(len));
+		if (sources->buf[i]) h = fnv1a(h, sources->buf[i], len);
+	}
 
-	// read applicable shader source files into buffers, run glCreateShader
+	// the map's iteration order isn't something to rely on
+	std::vector<std::pair<GLuint, std::string>> bindings(bindattrib_loc_names_map.begin(), bindattrib_loc_names_map.end());
+	std::sort(bindings.begin(), bindings.end());
+	for (auto &b : bindings) {
+		h = fnv1a(h, &b.first, sizeof(b.first));
+		h = fnv1a_str(h, b.second.c_str());
+	}
 
-	vs_buf = ShaderProgram::readShaderFromFile(shader_filenames[VertexShader], &vs_len);
-	if (!vs_buf) { set_bad(); goto cleanup; }	// vertex shader is mandatory
-	shaderObjIDs[VertexShader] = glCreateShader(GL_VERTEX_SHADER);
+	h = fnv1a_str(h, (const char*)glGetString(GL_VENDOR));
+	h = fnv1a_str(h, (const char*)glGetString(GL_RENDERER));
+	h = fnv1a_str(h, (const char*)glGetString(GL_VERSION));
+	return h;
+}
 
-	tcs_buf = ShaderProgram::readShaderFromFile(shader_filenames[TessellationControlShader], &tcs_len);
-	if (tcs_buf) {
-		shaderObjIDs[TessellationControlShader] = glCreateShader(GL_TESS_CONTROL_SHADER);
+static bool shader_cache_supported() {
+	if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri) {
+		return false;
+	}
+	GLint num_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	return num_formats > 0;
+}
 
-		tes_buf = ShaderProgram::readShaderFromFile(shader_filenames[TessellationEvaluationShader], &tes_len);
-		if (tes_buf) { 
-			shaderObjIDs[TessellationEvaluationShader] = glCreateShader(GL_TESS_EVALUATION_SHADER);
-		}	
-		else {
-			PRINT("ShaderProgram error: %s: TessellationControlShader enabled but no TessellationEvaluationShader provided.\n", name_base.c_str());
-			set_bad(); goto cleanup;
-		}
+static std::string shader_cache_filename(const std::string &name_base) {
+	std::string name = name_base;
+	std::replace(name.begin(), name.end(), '/', '_');
+	std::replace(name.begin(), name.end(), '\\', '_');
+	return std::string(SHADER_CACHE_DIR) + "/" + name + ".bin";
+}
+
+// returns the program, or 0 if there's no usable binary for this key
+static GLuint shader_cache_load(const std::string &name_base, unsigned long long key) {
+	std::ifstream in(shader_cache_filename(name_base).c_str(), std::ios::in | std::ios::binary);
+	if (!in.is_open()) {
+		return 0;
 	}
 
-	gs_buf = ShaderProgram::readShaderFromFile(shader_filenames[GeometryShader], &gs_len);
-	if (gs_buf) {
-		shaderObjIDs[GeometryShader] = glCreateShader(GL_GEOMETRY_SHADER);
+	shader_cache_header_t header;
+	in.read((char*)&header, sizeof(header));
+	if (!in || header.magic != SHADER_CACHE_MAGIC || header.key != key) {
+		return 0;
+	}
+	// the rest of the file has to be exactly the binary, a truncated or garbled one is just a miss
+	std::streamoff binary_start = in.tellg();
+	in.seekg(0, std::ios::end);
+	std::streamoff file_end = in.tellg();
+	if (binary_start < 0 || header.length == 0 || file_end - binary_start != (std::streamoff)header.length) {
+		return 0;
+	}
+	in.seekg(binary_start);
+	std::vector<char> binary(header.length);
+	in.read(binary.data(), header.length);
+	if (!in) {
+		return 0;
 	}
 
-	fs_buf = ShaderProgram::readShaderFromFile(shader_filenames[FragmentShader], &fs_len);
-	if (!fs_buf) { set_bad(); goto cleanup; } // fragment shader is mandatory
-	shaderObjIDs[FragmentShader] = glCreateShader(GL_FRAGMENT_SHADER);
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), header.length);
 
-	// shader sources
-	glShaderSource(shaderObjIDs[VertexShader], 1, (const GLchar**)&vs_buf,  (const GLint*)&vs_len);
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		PRINT("ShaderProgram %s: cached program binary rejected by the driver, recompiling.\n", name_base.c_str());
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
 
-	if (shaderObjIDs[TessellationControlShader] != SHADER_NONE) {
-		glShaderSource(shaderObjIDs[TessellationControlShader], 1, (const GLchar**)&tcs_buf, (const GLint*)&tcs_len);
+static void shader_cache_store(const std::string &name_base, unsigned long long key, GLuint program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
 	}
-	if (shaderObjIDs[TessellationEvaluationShader] != SHADER_NONE) {
-		glShaderSource(shaderObjIDs[TessellationEvaluationShader], 1, (const GLchar**)&tes_buf, (const GLint*)&tes_len);
+
+	shader_cache_header_t header = {};	// no uninitialized padding in the file
+	header.magic = SHADER_CACHE_MAGIC;
+	header.key = key;
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &written, &format, binary.data());
+	header.format = format;
+	header.length = written;
+
+#ifdef _WIN32
+	CreateDirectoryA(SHADER_CACHE_DIR, NULL);
+#else
+	mkdir(SHADER_CACHE_DIR, 0755);
+#endif
+	std::ofstream out(shader_cache_filename(name_base).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		PRINT("(warning: ShaderProgram: couldn't write the program cache for %s)\n", name_base.c_str());
+		return;
 	}
-	
-	if (shaderObjIDs[GeometryShader] != SHADER_NONE) {
-		glShaderSource(shaderObjIDs[GeometryShader], 1, (const GLchar**)&gs_buf, (const GLint*)&gs_len);
+	out.write((const char*)&header, sizeof(header));
+	out.write(binary.data(), written);
+}
+
+ShaderProgram::ShaderProgram(const std::string &name_base, const std::unordered_map<GLuint,std::string> &bindattrib_loc_names_map) {
+	shader_sources_t sources;
+	read_sources(name_base, &sources);
+	begin_build(name_base, &sources, bindattrib_loc_names_map);
+	free_sources(&sources);
+	finish_link();
+}
+
+ShaderProgram::ShaderProgram(const std::string &name_base, shader_sources_t *sources, const std::unordered_map<GLuint,std::string> &bindattrib_loc_names_map, bool deferred) {
+	begin_build(name_base, sources, bindattrib_loc_names_map);
+	if (!deferred) {
+		finish_link();
 	}
-	glShaderSource(shaderObjIDs[FragmentShader], 1, (const GLchar**)&fs_buf, (const GLint*)&fs_len);
+}
 
-	// compile everything
-	for (int i = VertexShader; i <= FragmentShader; i++) {
-		if (shaderObjIDs[i] != SHADER_NONE) { 
+// first half of the build: hands everything to the driver and returns without asking for any results,
+// so that several programs can be in the compiler at once. finish_link does the status checks
+void ShaderProgram::begin_build(const std::string &name_base, shader_sources_t *sources, const std::unordered_map<GLuint,std::string> &bindattrib_loc_names_map) {
+
+	for (int i = 0; i < 6; i++) shaderObjIDs[i] = SHADER_NONE;	
+	programHandle = 0;	// stays 0 if the sources are rejected
+
+	bad = false;
+	from_cache = false;
+	linking = false;
+	build_ms = 0;
+
+	id_string = name_base;
+	set_filenames(shader_filenames, name_base);
+
+	// a compute shader goes alone (read_sources only looks for one without a vertex shader), otherwise vertex
+	// and fragment shaders are mandatory and tessellation needs both stages
+
+	bool compute = sources->buf[ComputeShader] != NULL;
+	if (compute && !GL_compute_shader) {
+		PRINT("ShaderProgram error: %s: compute shader, but the context doesn't do compute shaders.\n", name_base.c_str());
+		set_bad(); return;
+	}
+	if (!compute && !sources->buf[VertexShader]) { set_bad(); return; }
+	if (!compute && !sources->buf[FragmentShader]) { set_bad(); return; }
+	if (sources->buf[TessellationControlShader] && !sources->buf[TessellationEvaluationShader]) {
+		PRINT("ShaderProgram error: %s: TessellationControlShader enabled but no TessellationEvaluationShader provided.\n", name_base.c_str());
+		set_bad(); return;
+	}
+
+	build_timer.begin();
+
+	use_cache = shader_cache_supported();
+	cache_key = use_cache ? shader_cache_key(sources, bindattrib_loc_names_map) : 0;
+
+	if (use_cache) {
+		programHandle = shader_cache_load(name_base, cache_key);
+		if (programHandle) {
+			from_cache = true;
+			gls_use_program(programHandle);
+			construct_uniform_map();
+			build_ms = build_timer.get_ms();
+			PRINT("ShaderProgram %s: program binary from cache in %.2f ms\n\n", name_base.c_str(), build_ms);
+			return;
+		}
+	}
+
+	static const GLenum stage_types[6] = { GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER };
+
+	// create, give sources and compile everything
+	for (int i = VertexShader; i <= ComputeShader; i++) {
+		if (sources->buf[i]) {
+			shaderObjIDs[i] = glCreateShader(stage_types[i]);
+			glShaderSource(shaderObjIDs[i], 1, (const GLchar**)&sources->buf[i], (const GLint*)&sources->len[i]);
 			glCompileShader(shaderObjIDs[i]);
 		}
 	}
 	programHandle = glCreateProgram();              
+	if (use_cache) {
+		glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 
 	// attach
 	
-	for (int i = VertexShader; i <= FragmentShader; i++) {
+	for (int i = VertexShader; i <= ComputeShader; i++) {
 		if (shaderObjIDs[i] != SHADER_NONE) {
 			glAttachShader(programHandle, shaderObjIDs[i]);
 		}
@@ -109,30 +290,44 @@ ShaderProgram::ShaderProgram(const std::string &name_base, const std::unordered_
 	// if binding is used, it must be done before glLinkProgram is called :P
 
 	glLinkProgram(programHandle);
-	glUseProgram(programHandle);
+	linking = true;
+}
+
+bool ShaderProgram::link_ready() {
+	if (!linking || !GL_parallel_shader_compile) {
+		return true;	// without the extension, finish_link simply blocks until the driver is done
+	}
+	GLint done = GL_FALSE;
+	glGetProgramiv(programHandle, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+void ShaderProgram::finish_link() {
+	if (!linking) {
+		return;
+	}
+	linking = false;
+
+	gls_use_program(programHandle);
 
 	if (!checkShaderCompileStatus_all()) 
 	{
 		set_bad();
-		goto cleanup;
+		return;
 	}
 	if (!checkProgramLinkStatus()) {
 		set_bad();
-		goto cleanup;
+		return;
 	}
 
-	
-	#define my_delete_arr(arr) if(arr) delete [] arr; arr = NULL;
-
 	construct_uniform_map();
 	printStatus();
 
-cleanup:
-	my_delete_arr(vs_buf);
-	my_delete_arr(tcs_buf);
-	my_delete_arr(tes_buf);
-	my_delete_arr(gs_buf); 
-	my_delete_arr(fs_buf);
+	if (use_cache) {
+		shader_cache_store(id_string, cache_key, programHandle);
+	}
+	build_ms = build_timer.get_ms();
+	PRINT("ShaderProgram %s: compiled and linked in %.2f ms\n\n", id_string.c_str(), build_ms);
 }
 
 inline const char* shader_present(const GLuint *objIDs, GLint index) {
@@ -148,6 +343,7 @@ void ShaderProgram::printStatus () const {
 	PRINT("TessEval shader: \t%s\t\t%d\n", shader_present(shaderObjIDs, TessellationEvaluationShader), shaderObjIDs[TessellationEvaluationShader]);
 	PRINT("Geometry shader: \t%s\t\t%d\n", shader_present(shaderObjIDs, GeometryShader), shaderObjIDs[GeometryShader]);
 	PRINT("Fragment shader: \t%s\t\t%d\n", shader_present(shaderObjIDs, FragmentShader), shaderObjIDs[FragmentShader]);
+	PRINT("Compute shader: \t%s\t\t%d\n", shader_present(shaderObjIDs, ComputeShader), shaderObjIDs[ComputeShader]);
 	PRINT("bad flag: %d\n\n", bad);
 }
 
@@ -173,11 +369,11 @@ char* ShaderProgram::readShaderFromFile(const std::string &filename, GLsizei *fi
 GLint ShaderProgram::checkShaderCompileStatus_all() // GL_COMPILE_STATUS
 {	
 	// should check GL_LINK_STATUS as well (glGetProgramInfoLog for linker)
-	GLint succeeded[5] = { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
-	GLchar *log_buffers[5] = { NULL, NULL, NULL, NULL, NULL };
+	GLint succeeded[6] = { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
+	GLchar *log_buffers[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
 	GLint num_errors = 0;
 
-	for (int i = VertexShader; i <= FragmentShader; i++) {
+	for (int i = VertexShader; i <= ComputeShader; i++) {
 		if (shaderObjIDs[i] != SHADER_NONE) {
 			glGetShaderiv(shaderObjIDs[i], GL_COMPILE_STATUS, &succeeded[i]);
 
@@ -194,7 +390,7 @@ GLint ShaderProgram::checkShaderCompileStatus_all() // GL_COMPILE_STATUS
 
 				log_buffers[i][log_length-1] = '\0';
 
-				DeleteFile("shader.log");	// just to be sure :P
+				remove("shader.log");	// just to be sure :P
 
 				std::ofstream logfile("shader.log", std::ios::out | std::ios::app);	
 				logfile << this->shader_filenames[i] << ": \n";
@@ -209,7 +405,7 @@ GLint ShaderProgram::checkShaderCompileStatus_all() // GL_COMPILE_STATUS
 	if (num_errors > 0) {	
 
 		PRINT( "\nShader %s: error log (glGetShaderInfoLog):\n-----------------------------------------------------------------\n\n", id_string.c_str());
-		for (int i = VertexShader; i <= FragmentShader; i++) {
+		for (int i = VertexShader; i <= ComputeShader; i++) {
 			if (succeeded[i] != GL_TRUE) {
 				PRINT( "filename: %s\n\n", shader_filenames[i].c_str());
 				PRINT( "%s\n\n", log_buffers[i]);
@@ -217,7 +413,7 @@ GLint ShaderProgram::checkShaderCompileStatus_all() // GL_COMPILE_STATUS
 		}
 		PRINT( "\n---------------------------------------------------\n");
 	}
-	for (int i = VertexShader; i <= FragmentShader; i++) {	
+	for (int i = VertexShader; i <= ComputeShader; i++) {	
 		if (log_buffers[i]) delete [] log_buffers[i];
 		log_buffers[i] = NULL;
 	}
@@ -257,7 +453,7 @@ GLint ShaderProgram::checkProgramLinkStatus() {
 
 void ShaderProgram::construct_uniform_map() {
 	GLint total = -1;
-	glUseProgram(this->programHandle);
+	gls_use_program(this->programHandle);
 	glGetProgramiv(programHandle, GL_ACTIVE_UNIFORMS, &total);
 #define UNIFORM_NAME_LEN_MAX 64
 	char uniform_name_buf[UNIFORM_NAME_LEN_MAX];
@@ -277,7 +473,7 @@ void ShaderProgram::construct_uniform_map() {
 
 
 bool ShaderProgram::active_uniform(const std::string &name, std::unordered_map<std::string,GLuint>::iterator *iter) {
-	glUseProgram(programHandle);
+	gls_use_program(programHandle);
 	*iter = uniforms.find(name);
 	if (*iter == uniforms.end()) {
 		//PRINT("warning: shaderprogram %s: attempt to update non-present uniform \"%s\"!\n", this->id_string.c_str(), name.c_str());
@@ -310,6 +506,14 @@ void ShaderProgram::update_uniform_1f(const std::string &uniform_name, GLfloat v
 	}
 }
 
+void ShaderProgram::update_uniform_2f(const std::string &uniform_name, GLfloat x, GLfloat y) {
+	std::unordered_map<std::string, GLuint>::iterator iter;
+	if (active_uniform(uniform_name, &iter)) {
+		GLuint uniform_location = iter->second;
+		glUniform2f(uniform_location, x, y);
+	}
+}
+
 void ShaderProgram::update_uniform_1i(const std::string &uniform_name, GLint value) {
 	std::unordered_map<std::string, GLuint>::iterator iter;
 	if (active_uniform(uniform_name, &iter)) {
@@ -11,6 +11,7 @@
 #include <unordered_map>
 
 #include "lin_alg.h"
+#include "timer.h"
 
 #define SHADER_NONE (GLuint)-1
 #define SHADER_SUCCESS GL_TRUE
@@ -27,7 +28,14 @@ enum {
 		TessellationControlShader = 1, 
 		TessellationEvaluationShader = 2, 
 		GeometryShader = 3, 
-		FragmentShader = 4
+		FragmentShader = 4,
+		ComputeShader = 5	// on its own, a program either has a compute shader or the others
+};
+
+// stage sources read ahead of time, so the file i/o can happen off the GL thread (see loader.cpp)
+struct shader_sources_t {
+	char *buf[6];
+	GLsizei len[6];
 };
 
 #define set_bad() do {\
@@ -38,37 +46,58 @@ enum {
 class ShaderProgram {
 	std::unordered_map<std::string, GLuint> uniforms;	// uniform name -> uniform location
 	std::string id_string;
-	std::string shader_filenames[5];
+	std::string shader_filenames[6];
 	GLuint programHandle;
-	GLuint shaderObjIDs[5]; 	// [0] => VS_id, [1] => TCS_id, [2] => TES_id, [3] => GS_id, [4] => FS_id
+	GLuint shaderObjIDs[6]; 	// [0] => VS_id, [1] => TCS_id, [2] => TES_id, [3] => GS_id, [4] => FS_id, [5] => CS_id
 	bool bad;
+	bool from_cache;	// restored from the program binary cache instead of compiled
+	bool linking;		// begin_build done, finish_link not yet
+	bool use_cache;
+	unsigned long long cache_key;
+	perf_timer_t build_timer;
+	double build_ms;
 
-	bool ShaderProgram::active_uniform(const std::string &name, std::unordered_map<std::string,GLuint>::iterator *iter);
+	bool active_uniform(const std::string &name, std::unordered_map<std::string,GLuint>::iterator *iter);
+	void begin_build(const std::string &name_base, shader_sources_t *sources, const std::unordered_map<GLuint, std::string> &bindattrib_loc_names_map);
 
 public:
 	GLuint getProgramHandle() const { return programHandle; }
 	
 	ShaderProgram(const std::string &name_base, const std::unordered_map<GLuint, std::string> &bindattrib_loc_names_map); // extensions are appended to the name base, see shader.cpp
+	ShaderProgram(const std::string &name_base, shader_sources_t *sources, const std::unordered_map<GLuint, std::string> &bindattrib_loc_names_map, bool deferred = false); // sources from read_sources, caller frees them
+
+	// with deferred = true the constructor only starts compiling and linking. kick off every program first,
+	// then poll link_ready (never blocks, uses KHR/ARB_parallel_shader_compile when the driver has it) and
+	// call finish_link for the status checks and uniform lookup. the sources can be freed right after construction
+	bool link_ready();
+	void finish_link();
+	bool is_linking() const { return linking; }
 
 	void printStatus() const;
 	GLint checkShaderCompileStatus_all();
 	GLint checkProgramLinkStatus();
 	bool is_bad() const { return bad; }
+	bool is_from_cache() const { return from_cache; }
+	double get_build_ms() const { return build_ms; }
 
 	void construct_uniform_map();
 	void update_uniform_mat4(const std::string &uniform_name, const mat4 &m);
 	void update_uniform_vec4(const std::string &uniform_name, const vec4 &v);
 	void update_uniform_ivec2(const std::string &uniform_name, const GLint *GLint_doublet);
 	void update_uniform_1f(const std::string &uniform_name, GLfloat value);
+	void update_uniform_2f(const std::string &uniform_name, GLfloat x, GLfloat y);
 	void update_uniform_1i(const std::string &uniform_name, GLint value);	// just wrappers around the glapi calls
 
 	static char* readShaderFromFile(const std::string &filename, GLsizei *filesize);
+	static void read_sources(const std::string &name_base, shader_sources_t *sources);	// no GL calls, safe on any thread
+	static void free_sources(shader_sources_t *sources);
 	std::string get_id_string() const { return id_string; }
 	std::string get_vs_filename() const { return shader_filenames[VertexShader]; }
 	std::string get_tcs_filename() const { return shader_filenames[TessellationControlShader]; }
 	std::string get_tes_filename() const { return shader_filenames[TessellationEvaluationShader]; }
 	std::string get_gs_filename() const { return shader_filenames[GeometryShader]; }
 	std::string get_fs_filename() const { return shader_filenames[FragmentShader]; }
+	std::string get_cs_filename() const { return shader_filenames[ComputeShader]; }
 };
 
 
@@ -8,10 +8,16 @@
 #include <cmath>
 #include <limits>
 #include <mutex>
+#include <atomic>
 
 #include <Avrt.h>
 
 #include "wfedit.h"
+#include "wavetable.h"
+#include "voices.h"
+#include "ramp.h"
+#include "oversample.h"
+#include "resample.h"
 
 // REFERENCE_TIME time units per second and per millisecond
 #define REFTIMES_PER_SEC  10000000.0
@@ -39,8 +45,30 @@ static wave_format_t wformat;
 static UINT32 frame_size;
 static int sound_system_initialized = 0;
 
-static SMPL_TYPE *main_buffer = NULL;
-static std::mutex main_buffer_lock;
+// wavetables[current_wavetable] is what the voices are playing, wavetables[published_wavetable] is the
+// newest finished build. the GL thread always builds into the one that is neither, without holding
+// wavetable_lock; the audio thread only switches over at a period boundary, and then crossfades from
+// the old table to the new one over that whole period so the edit doesn't step.
+#define NUM_WAVETABLES 3
+static wavetable_t wavetables[NUM_WAVETABLES];
+static int current_wavetable = 0;
+static int published_wavetable = 0;
+static std::mutex wavetable_lock;
+
+static ramp_t wavetable_xfade;
+
+static voice_pool_t voices;
+static voice_event_queue_t voice_events;
+
+// the voices run at oversample_factor times the device rate, and decimators[] bring each channel back down
+static decimator_t decimators[2];
+static int oversample_factor = 1;
+static std::atomic<int> requested_oversample_factor(1);
+static std::atomic<int> requested_oversample_quality(OVERSAMPLE_QUALITY_MEDIUM);
+
+// the synth always runs at SYNTH_SAMPLE_RATE; if the device insists on something else, this converts
+static resampler_t resampler;
+static bool resampling = false;
 
 UINT32 SND_get_frame_size() {
 	return frame_size;
@@ -54,32 +82,131 @@ int SND_initialized() {
 	return sound_system_initialized;
 }
 
-size_t SND_write_to_buffer(const float *data) {
-	// data should contain 2*frame_size worth of floats normalized to [-1;1]
-	float max = (std::numeric_limits<short>::max)();
-	
-	main_buffer_lock.lock();
-
-	for (int i = 0; i < frame_size; ++i) {
-		SMPL_TYPE vl = (SMPL_TYPE)(max*data[2*i]);
-		SMPL_TYPE vr = (SMPL_TYPE)(max*data[2*i + 1]);
-		
-		main_buffer[2*i] = vl;
-		main_buffer[2*i + 1] = vr;
+void SND_set_cycle(const float *cycle) {
+	wavetable_lock.lock();
+	int back = 0;
+	while (back == current_wavetable || back == published_wavetable) {
+		++back;
 	}
-	main_buffer_lock.unlock();
+	wavetable_lock.unlock();
 
-	return 1;
+	wavetables[back].build(cycle);
+
+	wavetable_lock.lock();
+	published_wavetable = back;
+	wavetable_lock.unlock();
+}
+
+void SND_note_on(int note, float velocity) {
+	voice_event_t e = { VOICE_EVENT_NOTE_ON, note, velocity };
+	if (!voice_events.push(e)) {
+		printf("SND_note_on: voice event queue full, note %d dropped\n", note);
+	}
+}
+
+void SND_note_off(int note) {
+	voice_event_t e = { VOICE_EVENT_NOTE_OFF, note, 0 };
+	if (!voice_events.push(e)) {
+		printf("SND_note_off: voice event queue full, note %d dropped\n", note);
+	}
+}
+
+void SND_set_oversampling(int factor, int quality) {
+	if (factor != 1 && factor != 2 && factor != 4 && factor != 8) {
+		printf("SND_set_oversampling: unsupported factor %d (1, 2, 4 or 8)\n", factor);
+		return;
+	}
+	requested_oversample_quality = quality;
+	requested_oversample_factor = factor;
+}
+
+static void update_oversampling() {
+	int factor = requested_oversample_factor;
+	int quality = requested_oversample_quality;
+
+	if (factor == oversample_factor && quality == decimators[0].quality) {
+		return;
+	}
+
+	for (int c = 0; c < 2; ++c) {
+		decimators[c].setup(factor, quality);
+	}
+	voices.set_sample_rate((float)(SYNTH_SAMPLE_RATE * factor));
+	oversample_factor = factor;
+}
+
+#define MASTER_GAIN 0.5
+
+static inline SMPL_TYPE to_sample(float v) {
+	static const float max = (std::numeric_limits<SMPL_TYPE>::max)();
+	v *= MASTER_GAIN;
+	v = v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v);
+	return (SMPL_TYPE)(max*v);
+}
+
+static void render_synth(float *out_l, float *out_r, float *xfade, float *os_l, float *os_r, UINT32 num_frames) {
+	// renders num_frames at SYNTH_SAMPLE_RATE into out_l/out_r.
+	// xfade, os_l and os_r are scratch, num_frames * OVERSAMPLE_MAX_FACTOR floats each
+
+	update_oversampling();
+
+	voice_event_t e;
+	while (voice_events.pop(&e)) {
+		voices.handle_event(e);
+	}
+
+	const UINT32 num_os_frames = num_frames * oversample_factor;
+
+	wavetable_lock.lock();
+
+	const wavetable_t *prev = NULL;
+	if (published_wavetable != current_wavetable) {
+		prev = &wavetables[current_wavetable];
+		current_wavetable = published_wavetable;
+
+		wavetable_xfade.reset(0.0);
+		wavetable_xfade.set_target(1.0, num_os_frames);
+		wavetable_xfade.fill(xfade, num_os_frames);
+	}
+
+	voices.render(&wavetables[current_wavetable], prev, xfade, os_l, os_r, num_os_frames);
+	wavetable_lock.unlock();
+
+	decimators[0].process(os_l, num_frames, out_l);
+	decimators[1].process(os_r, num_frames, out_r);
 }
 
+static void render_period(SMPL_TYPE *out, float *mix_l, float *mix_r, float *xfade, float *os_l, float *os_r, UINT32 num_frames) {
+	// out is interleaved stereo at the device rate, num_frames of it. mix_l and mix_r are num_frames floats of scratch each
+
+	if (resampling) {
+		// the synth renders straight into the resampler's input, however many frames it needs this time around
+		int n_in = resampler.input_needed(num_frames);
+		if (n_in > 0) {
+			render_synth(resampler.input_ptr(0), resampler.input_ptr(1), xfade, os_l, os_r, n_in);
+			resampler.commit(n_in);
+		}
+
+		float *mix[2] = { mix_l, mix_r };
+		resampler.process(mix, num_frames);
+	}
+	else {
+		render_synth(mix_l, mix_r, xfade, os_l, os_r, num_frames);
+	}
+
+	for (UINT32 i = 0; i < num_frames; ++i) {
+		out[2*i] = to_sample(mix_l[i]);
+		out[2*i + 1] = to_sample(mix_r[i]);
+	}
+}
 
 static int construct_wave_format_info(int samplerate, int nchannels, int bitdepth, WAVEFORMATEX *WFEX, wave_format_t *wft) {
 
 	WFEX->wFormatTag = WAVE_FORMAT_PCM;
 	WFEX->nChannels = nchannels;
 	WFEX->nSamplesPerSec = samplerate;
-	WFEX->nAvgBytesPerSec = samplerate * 2 * bitdepth / 8;
-	WFEX->nBlockAlign = 2 * bitdepth / 8;
+	WFEX->nAvgBytesPerSec = samplerate * nchannels * bitdepth / 8;
+	WFEX->nBlockAlign = nchannels * bitdepth / 8;
 	WFEX->wBitsPerSample = bitdepth;
 
 	wft->num_channels = nchannels;
@@ -91,6 +218,26 @@ static int construct_wave_format_info(int samplerate, int nchannels, int bitdept
 }
 
 
+// in order of preference. anything other than SYNTH_SAMPLE_RATE goes through the resampler
+static const int candidate_sample_rates[] = { SYNTH_SAMPLE_RATE, 44100, 96000, 88200, 192000 };
+
+static HRESULT negotiate_wave_format(IAudioClient *pAudioClient, WAVEFORMATEX *WFEX, wave_format_t *wft) {
+	HRESULT hr = AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+	for (size_t i = 0; i < sizeof(candidate_sample_rates) / sizeof(candidate_sample_rates[0]); ++i) {
+		construct_wave_format_info(candidate_sample_rates[i], 2, 16, WFEX, wft);
+
+		hr = pAudioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, WFEX, NULL);
+		if (hr == S_OK) {
+			printf("WASAPI: using %d/%dch/%d bit\n", WFEX->nSamplesPerSec, WFEX->nChannels, WFEX->wBitsPerSample);
+			return hr;
+		}
+		printf("WASAPI: default audio device does not support %d/%dch/%d bit\n", WFEX->nSamplesPerSec, WFEX->nChannels, WFEX->wBitsPerSample);
+	}
+
+	return hr;
+}
+
 #define TWO_PI (3.14159265359*2)
 
 static inline float sin01(float alpha) {
@@ -141,6 +288,9 @@ HRESULT PlayAudioStream() {
 	DWORD flags = 0;
 	HANDLE hEvent = NULL;
 	HANDLE hTask = NULL;
+	float *mix_buffer = NULL;	// both channels, planar
+	float *os_buffer = NULL;	// both oversampled channels plus the wavetable crossfade weights
+	UINT32 synth_frames_max = 0;
 
 	WAVEFORMATEX wave_format = {};
 
@@ -156,12 +306,10 @@ HRESULT PlayAudioStream() {
 	hr = pDevice->Activate(IID_IAudioClient, CLSCTX_ALL, NULL, (void**)&pAudioClient);
 	IF_ERROR_EXIT(hr);
 
-	construct_wave_format_info(48000, 2, 16, &wave_format, &wformat);
-
-	hr = pAudioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &wave_format, NULL);
+	hr = negotiate_wave_format(pAudioClient, &wave_format, &wformat);
 
 	if (AUDCLNT_E_UNSUPPORTED_FORMAT == hr) {
-		printf("WASAPI: default audio device does not support the requested WAVEFORMATEX (%d/%dch/%d bit)\n", wave_format.nSamplesPerSec, wave_format.nChannels, wave_format.wBitsPerSample);
+		printf("WASAPI: default audio device supports none of the sample rates we can resample to\n");
 		pAudioClient->Release();
 		return hr;
 	}
@@ -185,33 +333,31 @@ HRESULT PlayAudioStream() {
 	IF_ERROR_EXIT(hr);
 
 
-	const size_t num_samples = frame_size_bytes / sizeof(SMPL_TYPE);
+	resampling = (wave_format.nSamplesPerSec != SYNTH_SAMPLE_RATE);
+	if (resampling) {
+		resampler.init(SYNTH_SAMPLE_RATE, wave_format.nSamplesPerSec, 2, frame_size);
+		printf("resampling %d -> %d Hz\n", SYNTH_SAMPLE_RATE, wave_format.nSamplesPerSec);
+	}
 
-	main_buffer = new SMPL_TYPE[num_samples];
-	memset(main_buffer, 0, sizeof(SMPL_TYPE) * num_samples);
+	// the most synth frames a single period can ask for (the first one, which also fills the filter's lookahead)
+	synth_frames_max = resampling ? resampler.input_needed(frame_size) + 1 : frame_size;
 
-	float min = (float)(std::numeric_limits<SMPL_TYPE>::min)();
-	float max = (float)(std::numeric_limits<SMPL_TYPE>::max)();
-	float halfmax = max / 2.0;
-	float dt = 1.0 / (float)wave_format.nSamplesPerSec;
+	// scratch for the synth, allocated once so the render loop itself never allocates
 
-	float freq = 2*(float)wave_format.nSamplesPerSec / (float)frame_size;
+	mix_buffer = new float[2 * frame_size];
+	os_buffer = new float[3 * OVERSAMPLE_MAX_FACTOR * synth_frames_max];
 
-	wformat.wave_freq = freq;
-	wformat.cycle_duration_ms = 1.0 / freq * 1000.0;
-	
-//float freq = 440;
+	for (int c = 0; c < 2; ++c) {
+		decimators[c].allocate(synth_frames_max);
+		decimators[c].setup(1, OVERSAMPLE_QUALITY_MEDIUM);
+	}
 
-	//for (int i = 0; i < num_samples/2; ++i) {
-	//	float t = (float)i * dt;
-	//	main_buffer[2*i] = sin_minmax_Hz(min, max, freq, t); // L channel
-	//	main_buffer[2*i + 1] = sin_minmax_Hz(min, max, freq, t); // R channel
-	//}
+	voices.init((float)SYNTH_SAMPLE_RATE);
 
 	hr = pRenderClient->GetBuffer(frame_size, &pData);
 	IF_ERROR_EXIT(hr);
 
-	memcpy(pData, main_buffer, frame_size_bytes);
+	memset(pData, 0, frame_size_bytes);
 
 	hr = pRenderClient->ReleaseBuffer(frame_size, flags);
 	IF_ERROR_EXIT(hr);
@@ -238,9 +384,8 @@ HRESULT PlayAudioStream() {
 		hr = pRenderClient->GetBuffer(frame_size, &pData);
 		IF_ERROR_EXIT(hr);
 
-		main_buffer_lock.lock();
-		memcpy(pData, main_buffer, frame_size_bytes);
-		main_buffer_lock.unlock();
+		render_period((SMPL_TYPE*)pData, mix_buffer, mix_buffer + frame_size,
+			os_buffer, os_buffer + OVERSAMPLE_MAX_FACTOR*synth_frames_max, os_buffer + 2*OVERSAMPLE_MAX_FACTOR*synth_frames_max, frame_size);
 
 		hr = pRenderClient->ReleaseBuffer(frame_size, 0);
 		IF_ERROR_EXIT(hr);
@@ -264,6 +409,14 @@ exit_err:
 	if (hTask != NULL) {
 		AvRevertMmThreadCharacteristics(hTask);
 	}
+
+	delete[] mix_buffer;
+	delete[] os_buffer;
+
+	for (int c = 0; c < 2; ++c) {
+		decimators[c].cleanup();
+	}
+	resampler.cleanup();
 	
 	printf("Exiting sound system...\n");
 
@@ -6,15 +6,28 @@
 
 HRESULT PlayAudioStream();
 
+// the rate the synth runs at internally, independent of what the device ends up using
+#define SYNTH_SAMPLE_RATE 48000
+
 struct wave_format_t {
 	int num_channels;
 	int sample_rate;
 	int bit_depth;
-	float wave_freq;
-	float cycle_duration_ms;
 };
 
 UINT32 SND_get_frame_size();
 wave_format_t SND_get_format_info();
 int SND_initialized();
-size_t SND_write_to_buffer(const float *data);
+
+// cycle should contain WT_TABLE_SIZE samples (see wavetable.h) of one period normalized to [-1;1].
+// the band-limited tables are rebuilt from it, so only call this when the curve actually changes
+void SND_set_cycle(const float *cycle);
+
+// note is a MIDI note number (69 == A4 == 440 Hz), velocity in [0;1].
+// these only enqueue an event, the audio thread picks them up at the start of the next period
+void SND_note_on(int note, float velocity);
+void SND_note_off(int note);
+
+// factor is 1 (off), 2, 4 or 8, quality is one of the OVERSAMPLE_QUALITY_* constants in oversample.h.
+// takes effect at the start of the next period
+void SND_set_oversampling(int factor, int quality);
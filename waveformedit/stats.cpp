@@ -0,0 +1,60 @@
+#include "stats.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define STATS_MAX_ENTRIES 32
+
+struct stats_entry_t {
+	const char *name;
+	double sum;
+	double last;	// average of the last report
+};
+
+static stats_entry_t entries[STATS_MAX_ENTRIES];
+static int num_entries = 0;
+static int num_frames = 0;
+
+void stats_add(const char *name, double value) {
+	for (int i = 0; i < num_entries; ++i) {
+		if (entries[i].name == name || strcmp(entries[i].name, name) == 0) {
+			entries[i].sum += value;
+			return;
+		}
+	}
+	if (num_entries < STATS_MAX_ENTRIES) {
+		entries[num_entries].name = name;
+		entries[num_entries].sum = value;
+		entries[num_entries].last = 0;
+		++num_entries;
+	}
+}
+
+void stats_end_frame() {
+	++num_frames;
+	if (num_frames >= STATS_REPORT_FRAMES) {
+		stats_report();
+	}
+}
+
+void stats_report() {
+	if (num_frames == 0) {
+		return;
+	}
+	printf("stats, per frame over %d frames:\n", num_frames);
+	for (int i = 0; i < num_entries; ++i) {
+		entries[i].last = entries[i].sum / num_frames;
+		printf("  %-24s %10.3f\n", entries[i].name, entries[i].last);
+		entries[i].sum = 0;
+	}
+	num_frames = 0;
+}
+
+int stats_last(int i, const char **name, double *value) {
+	if (i < 0 || i >= num_entries) {
+		return 0;
+	}
+	*name = entries[i].name;
+	*value = entries[i].last;
+	return 1;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// per-frame numbers from around the program: cpu timings, GL call counts and the like. values added during
+// a frame are summed, and every STATS_REPORT_FRAMES frames the per-frame averages go to the console.
+// names are expected to be string literals. GL/main thread only
+
+#define STATS_REPORT_FRAMES 300
+
+void stats_add(const char *name, double value);
+void stats_end_frame();
+
+// prints the averages over the frames so far and starts over
+void stats_report();
+
+// the averages of the last report, for an overlay. 0 once i is past the last entry
+int stats_last(int i, const char **name, double *value);
@@ -0,0 +1,134 @@
+#include "text.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+#include "glyphs.h"
+#include "glstate.h"
+#include "shader.h"
+
+// the instance attributes, the shaders have these as explicit locations
+#define TEXT_ATTRIB_GLYPH 0
+#define TEXT_ATTRIB_COLOR 1
+
+// room for a few flushes before the buffer is orphaned
+#define TEXT_STREAM_BYTES ((GLsizeiptr)(4 * TEXT_MAX_GLYPHS * sizeof(text_glyph_t)))
+
+struct text_glyph_t {
+	float x, y;		// top left, pixels
+	float u, v;		// top left in the atlas, glyph table convention
+	unsigned char rgba[4];
+};
+
+static text_glyph_t batch[TEXT_MAX_GLYPHS];
+static int batch_len = 0;
+
+static GLuint text_VAOid, text_VBOid;
+static GLsizeiptr text_stream_pos = 0;
+
+void text_init() {
+	glGenVertexArrays(1, &text_VAOid);
+	gls_bind_vertex_array(text_VAOid);
+
+	glGenBuffers(1, &text_VBOid);
+	gls_bind_buffer(GL_ARRAY_BUFFER, text_VBOid);
+	glBufferData(GL_ARRAY_BUFFER, TEXT_STREAM_BYTES, NULL, GL_STREAM_DRAW);
+
+	glEnableVertexAttribArray(TEXT_ATTRIB_GLYPH);
+	glEnableVertexAttribArray(TEXT_ATTRIB_COLOR);
+	glVertexAttribDivisor(TEXT_ATTRIB_GLYPH, 1);
+	glVertexAttribDivisor(TEXT_ATTRIB_COLOR, 1);
+
+	gls_bind_vertex_array(0);
+	gls_bind_buffer(GL_ARRAY_BUFFER, 0);
+}
+
+void text_print(float x, float y, unsigned color, const char *str) {
+	// whole pixels, the glyphs are drawn 1:1 and stay sharp
+	float pen_x = floor(x), pen_y = floor(y);
+	for (const char *c = str; *c != '\0'; ++c) {
+		if (*c == '\n') {
+			pen_x = floor(x);
+			pen_y += GLYPH_PITCH_Y;
+			continue;
+		}
+		const glyph_t *g = glyph_for(*c);
+		if (g && *c != ' ' && batch_len < TEXT_MAX_GLYPHS) {
+			text_glyph_t *t = &batch[batch_len++];
+			t->x = pen_x;
+			t->y = pen_y;
+			t->u = g->u0;
+			t->v = g->v1;
+			t->rgba[0] = (color >> 24) & 0xFF;
+			t->rgba[1] = (color >> 16) & 0xFF;
+			t->rgba[2] = (color >> 8) & 0xFF;
+			t->rgba[3] = color & 0xFF;
+		}
+		pen_x += GLYPH_PITCH_X;
+	}
+}
+
+void text_printf(float x, float y, unsigned color, const char *fmt, ...) {
+	char buf[512];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	text_print(x, y, color, buf);
+}
+
+int text_width(const char *str) {
+	int longest = 0, len = 0;
+	for (const char *c = str; *c != '\0'; ++c) {
+		len = *c == '\n' ? 0 : len + 1;
+		if (len > longest) longest = len;
+	}
+	return longest * GLYPH_PITCH_X;
+}
+
+void text_flush(ShaderProgram *program, GLuint atlas_texture, int viewport_width, int viewport_height) {
+	int count = batch_len;
+	batch_len = 0;
+	if (count == 0 || !program) {
+		return;
+	}
+
+	gls_bind_vertex_array(text_VAOid);
+	gls_bind_buffer(GL_ARRAY_BUFFER, text_VBOid);
+
+	GLsizeiptr size = count * sizeof(text_glyph_t);
+	if (text_stream_pos + size > TEXT_STREAM_BYTES) {
+		glBufferData(GL_ARRAY_BUFFER, TEXT_STREAM_BYTES, NULL, GL_STREAM_DRAW);
+		text_stream_pos = 0;
+	}
+	void *dst = glMapBufferRange(GL_ARRAY_BUFFER, text_stream_pos, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!dst) {
+		return;
+	}
+	memcpy(dst, batch, size);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	const char *base = (const char*)text_stream_pos;
+	glVertexAttribPointer(TEXT_ATTRIB_GLYPH, 4, GL_FLOAT, GL_FALSE, sizeof(text_glyph_t), base + offsetof(text_glyph_t, x));
+	glVertexAttribPointer(TEXT_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(text_glyph_t), base + offsetof(text_glyph_t, rgba));
+	text_stream_pos += size;
+
+	gls_use_program(program->getProgramHandle());
+	program->update_uniform_2f("viewport", (GLfloat)viewport_width, (GLfloat)viewport_height);
+	program->update_uniform_2f("glyph_px", GLYPH_WIDTH, GLYPH_HEIGHT);
+	program->update_uniform_2f("glyph_uv", glyph_atlas_u(GLYPH_WIDTH), glyph_atlas_u(GLYPH_HEIGHT));
+	program->update_uniform_1i("atlas", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlas_texture);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+}
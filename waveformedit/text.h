@@ -0,0 +1,29 @@
+#pragma once
+
+#include "glext_loader.h"
+
+class ShaderProgram;
+
+// text from the dina glyph atlas (see glyphs.h). the print calls only append glyph instances to a batch,
+// text_flush streams the whole batch into one buffer and draws it with a single instanced call, so there's
+// one draw for all the text of a frame however many strings went in. GL thread only
+
+#define TEXT_MAX_GLYPHS 8192	// per flush, the rest is dropped
+
+// colors are 0xRRGGBBAA
+#define TEXT_COLOR_LABEL 0xA0A0A0FF
+#define TEXT_COLOR_OVERLAY 0x60FF60FF
+
+// the vertex array and the streaming buffer, the context must be current
+void text_init();
+
+// x, y is the top left corner of the first glyph in pixels from the top left of the viewport. '\n' starts
+// a new line under the first glyph
+void text_print(float x, float y, unsigned color, const char *str);
+void text_printf(float x, float y, unsigned color, const char *fmt, ...);
+
+// width in pixels of the longest line
+int text_width(const char *str);
+
+// draws the batch over whatever is there and empties it. with no program or atlas the batch is just dropped
+void text_flush(ShaderProgram *program, GLuint atlas_texture, int viewport_width, int viewport_height);
@@ -1,10 +1,10 @@
-#include <Windows.h>
-#include <gl\GL.h>
+#include <cstdio>
 #include <string>
 #include <vector>
 
 #include "glext_loader.h"
 #include "texture.h"
+#include "glstate.h"
 #include "lodepng.h"
 
 static std::string get_file_extension(const std::string &filename) {
@@ -19,39 +19,153 @@ static std::string get_file_extension(const std::string &filename) {
 }
 
 
-static int loadPNG(const std::string &filename, std::vector<unsigned char> &pixels, unified_header_data *out_header, LodePNGColorType colortype) {
-	unsigned e = lodepng::decode(pixels, out_header->width, out_header->height, filename, colortype);
-	if (colortype == LCT_RGBA) { out_header->bpp = 32; }
-	else if (colortype == LCT_GREY) { out_header->bpp = 8; }
-	else {
-		out_header->bpp = 8;
+// all texture loads go through one pixel unpack buffer. with GL 4.4 it's allocated with glBufferStorage and
+// stays mapped, so the png decoder writes straight into memory the driver can read from; a fence after
+// every upload keeps the next decode from overwriting pixels the GL hasn't copied out yet. without
+// buffer storage it's mapped with invalidation for each load instead, which needs no fence.
+struct upload_buffer_t {
+	GLuint pbo;
+	size_t size;
+	unsigned char *mapped;	// the persistent mapping, NULL if mapped per load
+	GLsync fence;
+};
+
+static upload_buffer_t upload = { 0, 0, NULL, NULL };
+
+static unsigned char *upload_begin(size_t size) {
+	if (size > upload.size) {
+		if (upload.pbo) {
+			glDeleteBuffers(1, &upload.pbo);	// deleting also unmaps, and the GL keeps it alive for pending uploads
+		}
+		if (upload.fence) {
+			glDeleteSync(upload.fence);
+			upload.fence = NULL;
+		}
+		upload.size = (size + 0xFFFFF) & ~(size_t)0xFFFFF;	// whole megabytes, fewer reallocations
+		upload.mapped = NULL;
+
+		glGenBuffers(1, &upload.pbo);
+		gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pbo);
+		if (glBufferStorage) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, upload.size, NULL, flags);
+			upload.mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, upload.size, flags);
+		}
+		else {
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, upload.size, NULL, GL_STREAM_DRAW);
+		}
+		gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	if (upload.mapped) {
+		if (upload.fence) {
+			while (glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+			glDeleteSync(upload.fence);
+			upload.fence = NULL;
+		}
+		return upload.mapped;
 	}
 
-	// lodePNG loads in a top-to-bottom order, so flip
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pbo);
+	unsigned char *p = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return p;
+}
 
-	const size_t stride = (out_header->bpp / 8) * out_header->width;
-	const size_t width = out_header->width;
-	unsigned char *temprow = new unsigned char[stride];
+// leaves the buffer bound as GL_PIXEL_UNPACK_BUFFER for the glTexSubImage2D calls that read from it
+static void upload_end() {
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pbo);
+	if (!upload.mapped) {
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+}
 
-	for (int i = 0; i < width/2; ++i) {
-		memcpy(temprow, &pixels[i*stride], stride);
-		memcpy(&pixels[i*stride], &pixels[((width-1) - i) * stride], stride);
-		memcpy(&pixels[((width-1) - i)*stride], temprow, stride);
+// after the uploads from the buffer have been issued
+static void upload_done() {
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if (upload.mapped) {
+		upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 	}
+}
 
-	delete[] temprow;
+struct png_rows_t {
+	unsigned char *dst;
+	size_t stride;
+};
 
-	return (e == 0);
+static unsigned png_row(void *user, const unsigned char *row, unsigned y, unsigned /*w*/, unsigned /*h*/) {
+	png_rows_t *rows = (png_rows_t*)user;
+	memcpy(rows->dst + y * rows->stride, row, rows->stride);
+	return 0;
 }
 
-static int load_pixels(const std::string& filename, std::vector<unsigned char> &pixels, unified_header_data *img_info, LodePNGColorType colortype = LCT_RGBA) {
-	unsigned width = 0, height = 0;
+// feeds the rest of the file through the stream decoder, rows go bottom-to-top like GL wants them.
+// piece holds the first n bytes, which were already read for the header
+static unsigned decode_png_rows(FILE *fp, lodepng::State *state, unsigned char *piece, size_t piece_size, size_t n, png_rows_t *rows) {
+	LodePNGStreamDecoder *decoder = lodepng_stream_new(state, png_row, rows, 1);
+	unsigned e = decoder ? 0 : 83;
+	while (!e && n > 0) {
+		e = lodepng_stream_feed(decoder, piece, n);
+		n = fread(piece, 1, piece_size, fp);
+	}
+	if (!e) e = lodepng_stream_finish(decoder);
+	lodepng_stream_delete(decoder);
+	return e;
+}
 
+static unsigned inspect_png(lodepng::State *state, unified_header_data *out_header, const unsigned char *piece, size_t n, LodePNGColorType colortype) {
+	state->info_raw.colortype = colortype;
+	state->info_raw.bitdepth = 8;
+	unsigned e = lodepng_inspect(&out_header->width, &out_header->height, state, piece, n);
+	if (!e) {
+		out_header->bpp = lodepng_get_bpp(&state->info_raw);
+	}
+	return e;
+}
+
+// decodes into the upload buffer. the header is read from the first piece of the file, so the buffer can
+// be mapped before any pixels come out
+static int loadPNG(const std::string &filename, unified_header_data *out_header, LodePNGColorType colortype) {
+	static unsigned char piece[65536];
+
+	FILE *fp = fopen(filename.c_str(), "rb");
+	if (!fp) {
+		return 0;
+	}
+	size_t n = fread(piece, 1, sizeof(piece), fp);
+
+	lodepng::State state;
+	if (inspect_png(&state, out_header, piece, n, colortype)) {
+		fclose(fp);
+		return 0;
+	}
+
+	png_rows_t rows;
+	rows.stride = lodepng_get_raw_size(out_header->width, 1, &state.info_raw);
+	rows.dst = upload_begin(rows.stride * out_header->height);
+	if (!rows.dst) {
+		fclose(fp);
+		return 0;
+	}
+
+	unsigned e = decode_png_rows(fp, &state, piece, sizeof(piece), n, &rows);
+	fclose(fp);
+
+	upload_end();
+	if (e) {
+		upload_done();
+		printf("loadPNG: %s: %s\n", filename.c_str(), lodepng_error_text(e));
+	}
+
+	return (e == 0);
+}
+
+static int load_pixels(const std::string& filename, unified_header_data *img_info, LodePNGColorType colortype = LCT_RGBA) {
 	memset(img_info, 0x0, sizeof(*img_info));
 
 	std::string ext = get_file_extension(filename);
 	if (ext == "png") {
-		if (!loadPNG(filename, pixels, img_info, colortype)) {
+		if (!loadPNG(filename, img_info, colortype)) {
 			printf("load_pixels: fatal error: loading file %s failed.\n", filename.c_str());
 			return 0;
 		}
@@ -72,27 +186,45 @@ Texture::Texture(const std::string &filename, const GLint filter_param) : name(f
 
 	unified_header_data img_info;
 
-	std::vector<unsigned char> pixels;
-	if (!load_pixels(filename, pixels, &img_info)) {
+	if (!load_pixels(filename, &img_info)) {
 		printf("Loading a texture resource failed.\n");
 		_otherbad = true;
 		return;
 	}
 
-	_badheader = _nosuch = _otherbad = false;
+	create_from_unpack_buffer(img_info, filter_param);
 
+	upload_done();
+
+}
+
+Texture::Texture(const std::string &filename, const unified_header_data &img_info, const GLint filter_param) : name(filename) {
+	create_from_unpack_buffer(img_info, filter_param);
+}
+
+void Texture::create_from_unpack_buffer(const unified_header_data &img_info, const GLint filter_param) {
+
+	_badheader = _nosuch = _otherbad = false;
+	this->img_info = img_info;
 
 	if (IS_POWER_OF_TWO(img_info.width) == 0 && img_info.width == img_info.height) {
-		// image is valid, carry on
-		GLint internal_format = GL_RGBA;
+		// image is valid, carry on. the pixels are in the bound unpack buffer
 		GLint input_pixel_format = img_info.bpp == 32 ? GL_RGBA : GL_RGB;
 		glEnable(GL_TEXTURE_2D);
 		glGenTextures(1, &textureId);
 		glBindTexture(GL_TEXTURE_2D, textureId);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, img_info.width, img_info.height, 0, input_pixel_format, GL_UNSIGNED_BYTE, (const GLvoid*)&pixels[0]);
-		//glTexStorage2D(GL_TEXTURE_2D, 4, internalfmt, width, height); // this is superior to glTexImage2D. only available in GL4 though
-		//glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid*)&buffer[0]);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (glTexStorage2D) {
+			GLsizei levels = 1;
+			while ((img_info.width >> levels) > 0) ++levels;
+			glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, img_info.width, img_info.height);
+		}
+		else {
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img_info.width, img_info.height, 0, input_pixel_format, GL_UNSIGNED_BYTE, NULL);
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, img_info.width, img_info.height, input_pixel_format, GL_UNSIGNED_BYTE, (const GLvoid*)0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -108,3 +240,104 @@ Texture::Texture(const std::string &filename, const GLint filter_param) : name(f
 
 }
 
+// the staged load used by the async loader. the worker thread stages (begin, decode) only touch the file
+// and the mapped memory, the GL thread stages (map, end) own the buffer object. every load gets its own
+// buffer so several can be in flight at once
+struct texture_load_t {
+	std::string filename;
+	GLint filter_param;
+	FILE *fp;
+	lodepng::State state;
+	unified_header_data img_info;
+	unsigned char piece[65536];
+	size_t piece_len;
+	png_rows_t rows;
+	GLuint pbo;
+	bool failed;
+};
+
+texture_load_t *texture_load_begin(const std::string &filename, GLint filter_param) {
+	texture_load_t *t = new texture_load_t;
+	t->filename = filename;
+	t->filter_param = filter_param;
+	t->piece_len = 0;
+	t->rows.dst = NULL;
+	t->rows.stride = 0;
+	t->pbo = 0;
+	t->failed = true;
+	memset(&t->img_info, 0, sizeof(t->img_info));
+
+	if (get_file_extension(filename) != "png") {
+		printf("texture_load_begin: unsupported image file extension in %s (only .png is supported)\n", filename.c_str());
+		t->fp = NULL;
+		return t;
+	}
+	t->fp = fopen(filename.c_str(), "rb");
+	if (!t->fp) {
+		printf("texture_load_begin: couldn't open %s\n", filename.c_str());
+		return t;
+	}
+	t->piece_len = fread(t->piece, 1, sizeof(t->piece), t->fp);
+
+	unsigned e = inspect_png(&t->state, &t->img_info, t->piece, t->piece_len, LCT_RGBA);
+	if (e) {
+		printf("texture_load_begin: %s: %s\n", filename.c_str(), lodepng_error_text(e));
+		return t;
+	}
+	t->rows.stride = lodepng_get_raw_size(t->img_info.width, 1, &t->state.info_raw);
+	t->failed = false;
+	return t;
+}
+
+int texture_load_map(texture_load_t *t) {
+	if (t->failed) {
+		return 0;
+	}
+	size_t size = t->rows.stride * t->img_info.height;
+
+	glGenBuffers(1, &t->pbo);
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, t->pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	t->rows.dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!t->rows.dst) {
+		t->failed = true;
+		return 0;
+	}
+	return 1;
+}
+
+int texture_load_decode(texture_load_t *t) {
+	unsigned e = decode_png_rows(t->fp, &t->state, t->piece, sizeof(t->piece), t->piece_len, &t->rows);
+	fclose(t->fp);
+	t->fp = NULL;
+	if (e) {
+		printf("texture_load_decode: %s: %s\n", t->filename.c_str(), lodepng_error_text(e));
+		t->failed = true;
+		return 0;
+	}
+	return 1;
+}
+
+Texture *texture_load_end(texture_load_t *t) {
+	Texture *tex = NULL;
+
+	if (t->pbo) {
+		gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, t->pbo);
+		if (t->rows.dst) {
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		if (!t->failed) {
+			tex = new Texture(t->filename, t->img_info, t->filter_param);
+		}
+		gls_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &t->pbo);	// the GL keeps it around until the texture upload is done
+	}
+	if (t->fp) {
+		fclose(t->fp);
+	}
+	delete t;
+	return tex;
+}
+
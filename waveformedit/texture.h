@@ -19,6 +19,8 @@ private:
 	bool _badheader;
 	bool _otherbad;
 
+	void create_from_unpack_buffer(const unified_header_data &img_info, const GLint filter_param);
+
 public:
 	std::string getName() const { return name; }
 	GLuint id() const { return textureId; }
@@ -30,6 +32,17 @@ public:
 
 	GLuint getId() const { return textureId; }
 	Texture(const std::string &filename, const GLint filter_param);
+	Texture(const std::string &filename, const unified_header_data &img_info, const GLint filter_param);	// pixels come from the bound GL_PIXEL_UNPACK_BUFFER
 	Texture() {};
 
-};
\ No newline at end of file
+};
+
+// staged loading for the async loader (loader.cpp). begin and decode do file i/o and png decoding and can
+// run on any thread, map and end make GL calls and must run on the GL thread. end returns NULL if any
+// stage failed, and frees the load either way
+struct texture_load_t;
+
+texture_load_t *texture_load_begin(const std::string &filename, GLint filter_param);
+int texture_load_map(texture_load_t *t);
+int texture_load_decode(texture_load_t *t);
+Texture *texture_load_end(texture_load_t *t);
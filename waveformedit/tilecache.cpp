@@ -0,0 +1,120 @@
+#include "tilecache.h"
+
+#include <cstdio>
+
+struct tile_slot_t {
+	bool used;
+	int zoom;
+	long long index;
+	double x0, x1;
+	unsigned last_frame;
+};
+
+static tile_slot_t slots[TILE_CACHE_SLOTS];
+static unsigned frame = 1;
+
+static GLuint atlas_texture = 0, atlas_fbo = 0;
+static int tile_height = 0;
+
+int tile_cache_init(int height) {
+	if (atlas_texture && height == tile_height) {
+		return 1;
+	}
+	tile_cache_destroy();
+	tile_height = height;
+
+	glGenTextures(1, &atlas_texture);
+	glBindTexture(GL_TEXTURE_2D, atlas_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tile_cache_atlas_width(), tile_cache_atlas_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	// the tiles are drawn 1:1
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	GLint previous_fbo;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_fbo);
+
+	glGenFramebuffers(1, &atlas_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, atlas_fbo);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, atlas_texture, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, previous_fbo);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		printf("tile_cache_init: framebuffer incomplete (status 0x%X)\n", status);
+		tile_cache_destroy();
+		return 0;
+	}
+	return 1;
+}
+
+void tile_cache_destroy() {
+	if (atlas_fbo) {
+		glDeleteFramebuffers(1, &atlas_fbo);
+	}
+	if (atlas_texture) {
+		glDeleteTextures(1, &atlas_texture);
+	}
+	atlas_fbo = atlas_texture = 0;
+	for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+		slots[i].used = false;
+	}
+}
+
+GLuint tile_cache_texture() { return atlas_texture; }
+GLuint tile_cache_framebuffer() { return atlas_fbo; }
+int tile_cache_atlas_width() { return TILE_CACHE_COLUMNS * TILE_WIDTH; }
+int tile_cache_atlas_height() { return TILE_CACHE_ROWS * tile_height; }
+
+void tile_cache_slot_rect(int slot, tile_rect_t *r) {
+	r->x = (slot % TILE_CACHE_COLUMNS) * TILE_WIDTH;
+	r->y = (slot / TILE_CACHE_COLUMNS) * tile_height;
+	r->width = TILE_WIDTH;
+	r->height = tile_height;
+}
+
+void tile_cache_begin_frame() {
+	++frame;
+}
+
+int tile_cache_find(int zoom, long long index) {
+	for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+		if (slots[i].used && slots[i].zoom == zoom && slots[i].index == index) {
+			slots[i].last_frame = frame;
+			return i;
+		}
+	}
+	return -1;
+}
+
+int tile_cache_insert(int zoom, long long index, double x0, double x1) {
+	int victim = -1;
+	for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+		if (!slots[i].used) {
+			victim = i;
+			break;
+		}
+		if (slots[i].last_frame != frame && (victim < 0 || slots[i].last_frame < slots[victim].last_frame)) {
+			victim = i;
+		}
+	}
+	if (victim < 0) {
+		return -1;
+	}
+
+	tile_slot_t *s = &slots[victim];
+	s->used = true;
+	s->zoom = zoom;
+	s->index = index;
+	s->x0 = x0;
+	s->x1 = x1;
+	s->last_frame = frame;
+	return victim;
+}
+
+void tile_cache_invalidate(double x0, double x1) {
+	for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+		if (slots[i].used && slots[i].x0 < x1 && slots[i].x1 > x0) {
+			slots[i].used = false;
+		}
+	}
+}
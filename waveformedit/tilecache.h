@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glext_loader.h"
+
+// the waveform view in tiles: TILE_WIDTH pixels wide and as tall as the view, each one a stretch of the
+// curve rendered once at one zoom level and kept in a slot of a single atlas texture. tiles are keyed on
+// (zoom level, tile index). a lookup refreshes the tile's LRU stamp, a new tile goes in a free slot or
+// evicts the one that's gone unused the longest, never one used this frame. the tiles remember the curve
+// range they cover so edits only throw out what they touch. GL thread only
+
+#define TILE_WIDTH 256
+#define TILE_CACHE_COLUMNS 8
+#define TILE_CACHE_ROWS 4
+#define TILE_CACHE_SLOTS (TILE_CACHE_COLUMNS * TILE_CACHE_ROWS)
+
+// atlas texels, bottom-up like GL
+struct tile_rect_t {
+	int x, y, width, height;
+};
+
+// the atlas and its framebuffer for tiles height pixels tall. returns 0 on failure. calling again with a
+// different height starts over empty
+int tile_cache_init(int height);
+void tile_cache_destroy();
+
+GLuint tile_cache_texture();
+GLuint tile_cache_framebuffer();
+int tile_cache_atlas_width();
+int tile_cache_atlas_height();
+void tile_cache_slot_rect(int slot, tile_rect_t *r);
+
+// starts a new frame for the LRU stamps
+void tile_cache_begin_frame();
+
+// the slot of a cached tile, -1 if it isn't there
+int tile_cache_find(int zoom, long long index);
+// takes a slot for a tile that isn't cached, x0..x1 is the curve range it shows. the caller renders into
+// the slot. -1 if every slot is in use this frame
+int tile_cache_insert(int zoom, long long index, double x0, double x1);
+
+// drops every tile that shows any of the curve range x0..x1
+void tile_cache_invalidate(double x0, double x1);
@@ -1,31 +1,48 @@
 #pragma once
 
-#include <Windows.h>
 #include <cstdio>
 
-struct timer_t {
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>	// clock_gettime, for the headless build (see platform.h)
+#endif
+
+// not timer_t, that one's taken by posix
+struct perf_timer_t {
 	double cpu_freq;	// in kHz
-	__int64 counter_start;
+	long long counter_start;
 
-	__int64 get() const {
+#ifdef _WIN32
+	long long get() const {
 		LARGE_INTEGER li;
 		QueryPerformanceCounter(&li);
 		return li.QuadPart;
 	}
-public:
-	bool init() {
+	static long long frequency() {
 		LARGE_INTEGER li;
 		QueryPerformanceFrequency(&li);
-		cpu_freq = double(li.QuadPart);	// in Hz. this is subject to dynamic frequency scaling, though
+		return li.QuadPart;
+	}
+#else
+	long long get() const {
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+	static long long frequency() {
+		return 1000000000;
+	}
+#endif
+public:
+	bool init() {
+		cpu_freq = double(frequency());	// in Hz. this is subject to dynamic frequency scaling, though
 		begin();
 		return true;
 	}
 	void begin() {
-		LARGE_INTEGER li;
-		QueryPerformanceFrequency(&li);
-		cpu_freq = double(li.QuadPart);
-		QueryPerformanceCounter(&li);
-		counter_start = li.QuadPart;
+		cpu_freq = double(frequency());
+		counter_start = get();
 	}
 
 
@@ -38,7 +55,7 @@ public:
 	inline double get_us() const {
 		return double(1000000 * (get_s()));
 	}
-	timer_t() {
-		if (!init()) { printf("timer_t: error: initialization failed.\n"); }
+	perf_timer_t() {
+		if (!init()) { printf("perf_timer_t: error: initialization failed.\n"); }
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,356 @@
+#include "voices.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+// MSVC lets every function use every intrinsic, gcc and clang need the instruction set named per function
+#if defined(__GNUC__)
+#define VOICE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VOICE_TARGET(isa)
+#endif
+
+#define HALF_PI (3.14159265359/2)
+
+#define WT_PHASE_FRAC_BITS (32 - WT_TABLE_BITS)
+#define WT_PHASE_FRAC_MASK ((1u << WT_PHASE_FRAC_BITS) - 1)
+#define WT_PHASE_FRAC_SCALE (1.0f / (float)(1u << WT_PHASE_FRAC_BITS))
+
+// AVX2 needs the bit in cpuid leaf 7, AVX and OSXSAVE in leaf 1, and the OS saving the ymm registers
+static bool detect_avx2() {
+	unsigned r[4];
+#ifdef _MSC_VER
+	int ri[4];
+	__cpuidex(ri, 0, 0);
+	if (ri[0] < 7) return false;
+	__cpuidex(ri, 1, 0);
+	r[2] = (unsigned)ri[2];
+#else
+	if (__get_cpuid_max(0, NULL) < 7) return false;
+	__cpuid_count(1, 0, r[0], r[1], r[2], r[3]);
+#endif
+	if (!(r[2] & (1u << 27)) || !(r[2] & (1u << 28))) return false;
+
+#ifdef _MSC_VER
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(ri, 7, 0);
+	r[1] = (unsigned)ri[1];
+#else
+	unsigned eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	if ((eax & 6) != 6) return false;
+	__cpuid_count(7, 0, r[0], r[1], r[2], r[3]);
+#endif
+	return (r[1] & (1u << 5)) != 0;
+}
+
+// detection runs once, the audio thread racing the first call stores the same value
+static bool cpu_has_avx2() {
+	static volatile int has = -1;
+	if (has < 0) has = detect_avx2() ? 1 : 0;
+	return has != 0;
+}
+
+float note_to_frequency(int note) {
+	return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+bool voice_event_queue_t::push(const voice_event_t &e) {
+	unsigned t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) >= VOICE_EVENT_QUEUE_SIZE) {
+		return false;	// full, the event is dropped
+	}
+	events[t % VOICE_EVENT_QUEUE_SIZE] = e;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool voice_event_queue_t::pop(voice_event_t *e) {
+	unsigned h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	*e = events[h % VOICE_EVENT_QUEUE_SIZE];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+void voice_pool_t::init(float a_sample_rate) {
+	memset(this, 0, sizeof(*this));
+	sample_rate = a_sample_rate;
+}
+
+void voice_pool_t::set_sample_rate(float new_rate) {
+	float ratio = sample_rate / new_rate;
+
+	for (int v = 0; v < MAX_VOICES; ++v) {
+		if (!active[v]) continue;
+
+		float freq = note_to_frequency(note[v]);
+		phase_inc[v] = (uint32_t)(freq / new_rate * 4294967296.0);
+		table_offset[v] = wavetable_t::level_for_frequency(freq, new_rate) * (WT_TABLE_SIZE + 1);
+		gain_step[v] *= ratio;	// keep the envelope times in milliseconds
+	}
+
+	sample_rate = new_rate;
+}
+
+int voice_pool_t::allocate_voice() {
+	int oldest = 0;
+	for (int i = 0; i < MAX_VOICES; ++i) {
+		if (!active[i]) {
+			return i;
+		}
+		if (age[i] < age[oldest]) {
+			oldest = i;
+		}
+	}
+	return oldest;	// all busy, steal the oldest one
+}
+
+void voice_pool_t::note_on(int n, float velocity) {
+	int v = allocate_voice();
+	float freq = note_to_frequency(n);
+
+	phase[v] = 0;
+	phase_inc[v] = (uint32_t)(freq / sample_rate * 4294967296.0);
+	table_offset[v] = wavetable_t::level_for_frequency(freq, sample_rate) * (WT_TABLE_SIZE + 1);
+
+	gain_max[v] = velocity;
+	gain[v] = gain[v] > velocity ? velocity : gain[v];	// a stolen voice ramps from where it was
+	gain_step[v] = velocity / (float)(VOICE_ATTACK_MS * 0.001 * sample_rate);
+
+	// spread the notes of an octave a bit across the stereo field, constant power
+	float p = 0.5 + 0.6 * ((float)(n % 12) / 11.0 - 0.5);
+	pan_l[v] = cos(p * HALF_PI);
+	pan_r[v] = sin(p * HALF_PI);
+
+	note[v] = n;
+	age[v] = ++age_counter;
+	active[v] = true;
+	releasing[v] = false;
+}
+
+void voice_pool_t::note_off(int n) {
+	for (int v = 0; v < MAX_VOICES; ++v) {
+		if (active[v] && !releasing[v] && note[v] == n) {
+			releasing[v] = true;
+			gain_step[v] = -gain_max[v] / (float)(VOICE_RELEASE_MS * 0.001 * sample_rate);
+		}
+	}
+}
+
+void voice_pool_t::handle_event(const voice_event_t &e) {
+	if (e.type == VOICE_EVENT_NOTE_ON) {
+		note_on(e.note, e.velocity);
+	}
+	else if (e.type == VOICE_EVENT_NOTE_OFF) {
+		note_off(e.note);
+	}
+}
+
+int voice_pool_t::num_active() const {
+	int n = 0;
+	for (int v = 0; v < MAX_VOICES; ++v) {
+		n += active[v] ? 1 : 0;
+	}
+	return n;
+}
+
+static inline float table_read(const float *base, int32_t offset, uint32_t phase) {
+	const float *t = base + offset + (phase >> WT_PHASE_FRAC_BITS);
+	float frac = (float)(phase & WT_PHASE_FRAC_MASK) * WT_PHASE_FRAC_SCALE;
+	return t[0] + frac * (t[1] - t[0]);
+}
+
+// the rows by pointer, 32 bit MSVC can't pass a fourth __m128 by value
+static inline void transpose_sum_add(const __m128 *rows, float *out) {
+	// rows are samples, lanes are voices. after the transpose lanes are samples, so summing the rows mixes the voices.
+	__m128 r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = rows[3];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	__m128 sum = _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3));
+	_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), sum));
+}
+
+// leftover samples i..n-1 when n isn't a multiple of 4, for voices v0..v0+lanes-1
+static void render_tail(voice_pool_t *p, const float *base, const float *prev_base, const float *xfade, int v0, int lanes, float *out_l, float *out_r, int i, int n) {
+	for (; i < n; ++i) {
+		for (int v = v0; v < v0 + lanes; ++v) {
+			float s = table_read(base, p->table_offset[v], p->phase[v]);
+			if (prev_base) {
+				float ps = table_read(prev_base, p->table_offset[v], p->phase[v]);
+				s = ps + xfade[i] * (s - ps);
+			}
+			s *= p->gain[v];
+			out_l[i] += s * p->pan_l[v];
+			out_r[i] += s * p->pan_r[v];
+
+			float ng = p->gain[v] + p->gain_step[v];
+			p->gain[v] = ng < 0 ? 0 : (ng > p->gain_max[v] ? p->gain_max[v] : ng);
+			p->phase[v] += p->phase_inc[v];
+		}
+	}
+}
+
+// a whole group in one register
+static VOICE_TARGET("avx2") void render_group_avx2(voice_pool_t *p, const float *base, const float *prev_base, const float *xfade, int v0, float *out_l, float *out_r, int n) {
+	__m256i ph = _mm256_load_si256((const __m256i*)&p->phase[v0]);
+	const __m256i inc = _mm256_load_si256((const __m256i*)&p->phase_inc[v0]);
+	const __m256i off = _mm256_load_si256((const __m256i*)&p->table_offset[v0]);
+	__m256 g = _mm256_load_ps(&p->gain[v0]);
+	const __m256 step = _mm256_load_ps(&p->gain_step[v0]);
+	const __m256 gmax = _mm256_load_ps(&p->gain_max[v0]);
+	const __m256 pl = _mm256_load_ps(&p->pan_l[v0]);
+	const __m256 pr = _mm256_load_ps(&p->pan_r[v0]);
+
+	const __m256i frac_mask = _mm256_set1_epi32(WT_PHASE_FRAC_MASK);
+	const __m256 frac_scale = _mm256_set1_ps(WT_PHASE_FRAC_SCALE);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 zero = _mm256_setzero_ps();
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 l[4], r[4];
+		for (int k = 0; k < 4; ++k) {
+			__m256i idx = _mm256_add_epi32(_mm256_srli_epi32(ph, WT_PHASE_FRAC_BITS), off);
+			__m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(ph, frac_mask)), frac_scale);
+			__m256 a = _mm256_i32gather_ps(base, idx, 4);
+			__m256 b = _mm256_i32gather_ps(base, _mm256_add_epi32(idx, one), 4);
+			__m256 s = _mm256_add_ps(a, _mm256_mul_ps(frac, _mm256_sub_ps(b, a)));
+
+			if (prev_base) {
+				__m256 pa = _mm256_i32gather_ps(prev_base, idx, 4);
+				__m256 pb = _mm256_i32gather_ps(prev_base, _mm256_add_epi32(idx, one), 4);
+				__m256 ps = _mm256_add_ps(pa, _mm256_mul_ps(frac, _mm256_sub_ps(pb, pa)));
+				s = _mm256_add_ps(ps, _mm256_mul_ps(_mm256_set1_ps(xfade[i + k]), _mm256_sub_ps(s, ps)));
+			}
+
+			__m256 v = _mm256_mul_ps(g, s);
+
+			__m256 vl = _mm256_mul_ps(v, pl);
+			__m256 vr = _mm256_mul_ps(v, pr);
+			// fold the 8 voices down to 4 lanes, the transpose below takes care of the rest
+			l[k] = _mm_add_ps(_mm256_castps256_ps128(vl), _mm256_extractf128_ps(vl, 1));
+			r[k] = _mm_add_ps(_mm256_castps256_ps128(vr), _mm256_extractf128_ps(vr, 1));
+
+			g = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(g, step), zero), gmax);
+			ph = _mm256_add_epi32(ph, inc);
+		}
+		transpose_sum_add(l, &out_l[i]);
+		transpose_sum_add(r, &out_r[i]);
+	}
+
+	_mm256_store_si256((__m256i*)&p->phase[v0], ph);
+	_mm256_store_ps(&p->gain[v0], g);
+
+	render_tail(p, base, prev_base, xfade, v0, VOICE_LANES, out_l, out_r, i, n);
+}
+
+// four of a group's voices, the SSE2 mixer does a group in two of these
+static void render_quad_sse2(voice_pool_t *p, const float *base, const float *prev_base, const float *xfade, int v0, float *out_l, float *out_r, int n) {
+	__m128i ph = _mm_load_si128((const __m128i*)&p->phase[v0]);
+	const __m128i inc = _mm_load_si128((const __m128i*)&p->phase_inc[v0]);
+	const __m128i off = _mm_load_si128((const __m128i*)&p->table_offset[v0]);
+	__m128 g = _mm_load_ps(&p->gain[v0]);
+	const __m128 step = _mm_load_ps(&p->gain_step[v0]);
+	const __m128 gmax = _mm_load_ps(&p->gain_max[v0]);
+	const __m128 pl = _mm_load_ps(&p->pan_l[v0]);
+	const __m128 pr = _mm_load_ps(&p->pan_r[v0]);
+
+	const __m128i frac_mask = _mm_set1_epi32(WT_PHASE_FRAC_MASK);
+	const __m128 frac_scale = _mm_set1_ps(WT_PHASE_FRAC_SCALE);
+	const __m128 zero = _mm_setzero_ps();
+
+	alignas(16) int32_t ix[4];
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 l[4], r[4];
+		for (int k = 0; k < 4; ++k) {
+			__m128i idx = _mm_add_epi32(_mm_srli_epi32(ph, WT_PHASE_FRAC_BITS), off);
+			__m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(ph, frac_mask)), frac_scale);
+
+			// no gather before AVX2, the loads are scalar but everything around them isn't
+			_mm_store_si128((__m128i*)ix, idx);
+			__m128 a = _mm_set_ps(base[ix[3]], base[ix[2]], base[ix[1]], base[ix[0]]);
+			__m128 b = _mm_set_ps(base[ix[3] + 1], base[ix[2] + 1], base[ix[1] + 1], base[ix[0] + 1]);
+			__m128 s = _mm_add_ps(a, _mm_mul_ps(frac, _mm_sub_ps(b, a)));
+
+			if (prev_base) {
+				__m128 pa = _mm_set_ps(prev_base[ix[3]], prev_base[ix[2]], prev_base[ix[1]], prev_base[ix[0]]);
+				__m128 pb = _mm_set_ps(prev_base[ix[3] + 1], prev_base[ix[2] + 1], prev_base[ix[1] + 1], prev_base[ix[0] + 1]);
+				__m128 ps = _mm_add_ps(pa, _mm_mul_ps(frac, _mm_sub_ps(pb, pa)));
+				s = _mm_add_ps(ps, _mm_mul_ps(_mm_set1_ps(xfade[i + k]), _mm_sub_ps(s, ps)));
+			}
+
+			__m128 v = _mm_mul_ps(g, s);
+
+			l[k] = _mm_mul_ps(v, pl);
+			r[k] = _mm_mul_ps(v, pr);
+
+			g = _mm_min_ps(_mm_max_ps(_mm_add_ps(g, step), zero), gmax);
+			ph = _mm_add_epi32(ph, inc);
+		}
+		transpose_sum_add(l, &out_l[i]);
+		transpose_sum_add(r, &out_r[i]);
+	}
+
+	_mm_store_si128((__m128i*)&p->phase[v0], ph);
+	_mm_store_ps(&p->gain[v0], g);
+
+	render_tail(p, base, prev_base, xfade, v0, 4, out_l, out_r, i, n);
+}
+
+void voice_pool_t::render_group(const wavetable_t *wt, const wavetable_t *wt_prev, const float *xfade, int v0, float *out_l, float *out_r, int n) {
+	const float *base = wt->tables[0];
+	const float *prev_base = wt_prev ? wt_prev->tables[0] : NULL;
+
+	if (cpu_has_avx2()) {
+		render_group_avx2(this, base, prev_base, xfade, v0, out_l, out_r, n);
+		return;
+	}
+	for (int q = v0; q < v0 + VOICE_LANES; q += 4) {
+		if (active[q] || active[q + 1] || active[q + 2] || active[q + 3]) {
+			render_quad_sse2(this, base, prev_base, xfade, q, out_l, out_r, n);
+		}
+	}
+}
+
+const char *voice_mixer_name() {
+	return cpu_has_avx2() ? "avx2" : "sse2";
+}
+
+void voice_pool_t::render(const wavetable_t *wt, const wavetable_t *wt_prev, const float *xfade, float *out_l, float *out_r, int n) {
+	memset(out_l, 0, n * sizeof(float));
+	memset(out_r, 0, n * sizeof(float));
+
+	for (int group = 0; group < VOICE_GROUPS; ++group) {
+		int v0 = group * VOICE_LANES;
+
+		bool any = false;
+		for (int v = v0; v < v0 + VOICE_LANES; ++v) {
+			any = any || active[v];
+		}
+		if (!any) continue;	// idle voices have zero gain, but there's no point in mixing silence
+
+		render_group(wt, wt_prev, xfade, v0, out_l, out_r, n);
+	}
+
+	// retire the voices whose release has finished
+	for (int v = 0; v < MAX_VOICES; ++v) {
+		if (active[v] && releasing[v] && gain[v] <= 0) {
+			active[v] = false;
+			releasing[v] = false;
+			gain_step[v] = 0;
+			gain_max[v] = 0;
+			phase_inc[v] = 0;
+		}
+	}
+}
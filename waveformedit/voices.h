@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+#include "wavetable.h"
+
+// A fixed pool of wavetable voices, all playing the same edited cycle. Voice state is kept as
+// structure-of-arrays so the mixer can process a group of VOICE_LANES voices at once: one AVX2 register,
+// or two SSE2 ones on CPUs without AVX2 (picked at runtime, the build doesn't need /arch:AVX2).
+// Nothing in here allocates; the pool and the event queue are plain static-sized arrays.
+
+#define VOICE_LANES 8
+
+#define MAX_VOICES 64
+#define VOICE_GROUPS (MAX_VOICES / VOICE_LANES)
+
+#define VOICE_ATTACK_MS 5.0
+#define VOICE_RELEASE_MS 80.0
+
+enum {
+	VOICE_EVENT_NOTE_ON = 0,
+	VOICE_EVENT_NOTE_OFF = 1
+};
+
+struct voice_event_t {
+	int type;
+	int note;
+	float velocity;
+};
+
+// single producer (the GL/input thread), single consumer (the audio thread)
+#define VOICE_EVENT_QUEUE_SIZE 256
+
+struct voice_event_queue_t {
+	voice_event_t events[VOICE_EVENT_QUEUE_SIZE];
+	std::atomic<unsigned> head;	// written by the consumer
+	std::atomic<unsigned> tail;	// written by the producer
+
+	voice_event_queue_t() : head(0), tail(0) {}
+
+	bool push(const voice_event_t &e);
+	bool pop(voice_event_t *e);
+};
+
+struct voice_pool_t {
+	alignas(32) uint32_t phase[MAX_VOICES];
+	alignas(32) uint32_t phase_inc[MAX_VOICES];
+	alignas(32) int32_t table_offset[MAX_VOICES];	// level * (WT_TABLE_SIZE + 1), i.e. which mip level to read
+	alignas(32) float gain[MAX_VOICES];		// current envelope value
+	alignas(32) float gain_step[MAX_VOICES];	// per-sample envelope increment, negative while releasing
+	alignas(32) float gain_max[MAX_VOICES];		// the envelope is clamped to [0, gain_max]
+	alignas(32) float pan_l[MAX_VOICES];
+	alignas(32) float pan_r[MAX_VOICES];
+
+	int note[MAX_VOICES];
+	unsigned age[MAX_VOICES];
+	bool active[MAX_VOICES];
+	bool releasing[MAX_VOICES];
+
+	float sample_rate;
+	unsigned age_counter;
+
+	void init(float sample_rate);
+
+	// retunes all voices for a new render rate, e.g. when the oversampling factor changes
+	void set_sample_rate(float sample_rate);
+
+	void note_on(int note, float velocity);
+	void note_off(int note);
+	void handle_event(const voice_event_t &e);
+
+	int num_active() const;
+
+	// overwrites out_l/out_r with the mix of all active voices, n samples each.
+	// if wt_prev is non-NULL, the voices crossfade from wt_prev to wt with the per-sample weights in xfade
+	// (0 == wt_prev, 1 == wt). the tables are linear in the curve coefficients, so this is the same thing
+	// as interpolating the coefficient sets sample by sample.
+	void render(const wavetable_t *wt, const wavetable_t *wt_prev, const float *xfade, float *out_l, float *out_r, int n);
+
+private:
+	int allocate_voice();
+	void render_group(const wavetable_t *wt, const wavetable_t *wt_prev, const float *xfade, int first_voice, float *out_l, float *out_r, int n);
+};
+
+float note_to_frequency(int note);
+
+// the mixer render uses on this CPU, "avx2" or "sse2"
+const char *voice_mixer_name();
@@ -0,0 +1,187 @@
+#include "wavelod.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "glstate.h"
+#include "timer.h"
+
+static GLuint samples_buffer = 0, samples_texture = 0;
+static GLuint columns_buffer = 0, columns_texture = 0;
+
+static float cycle[WAVE_LOD_CYCLE_SAMPLES];
+static long long material_periods = 0;
+
+// scratch for the CPU path
+static wave_lod_column_t cpu_columns[WAVE_LOD_COLUMNS];
+
+// a stretch of the material in samples, relative to the start of the period x0 is in. far into the material
+// that keeps the numbers small enough for floats, and both paths do the same float math on them
+struct reduce_params_t {
+	float start;	// x0
+	float step;		// samples per column
+	float lo, hi;	// the ends of the material
+};
+
+static void reduce_params(double x0, double px, reduce_params_t *p) {
+	double base = floor(x0);
+	p->start = (float)((x0 - base) * WAVE_LOD_CYCLE_SAMPLES);
+	p->step = (float)(px * WAVE_LOD_CYCLE_SAMPLES);
+	p->lo = (float)(-base * WAVE_LOD_CYCLE_SAMPLES);
+	p->hi = (float)((material_periods - base) * WAVE_LOD_CYCLE_SAMPLES);
+}
+
+static GLuint buffer_texture(GLuint *buffer, GLsizeiptr size, GLenum format) {
+	glGenBuffers(1, buffer);
+	gls_bind_buffer(GL_TEXTURE_BUFFER, *buffer);
+	glBufferData(GL_TEXTURE_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, *buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	return texture;
+}
+
+void wave_lod_init() {
+	if (samples_texture) {
+		return;
+	}
+	samples_texture = buffer_texture(&samples_buffer, sizeof(cycle), GL_R32F);
+	columns_texture = buffer_texture(&columns_buffer, sizeof(cpu_columns), GL_RGBA32F);
+}
+
+void wave_lod_destroy() {
+	glDeleteTextures(1, &samples_texture);
+	glDeleteTextures(1, &columns_texture);
+	glDeleteBuffers(1, &samples_buffer);
+	glDeleteBuffers(1, &columns_buffer);
+	samples_texture = columns_texture = 0;
+	samples_buffer = columns_buffer = 0;
+}
+
+void wave_lod_set_cycle(const float *samples, long long periods) {
+	memcpy(cycle, samples, sizeof(cycle));
+	material_periods = periods;
+	gls_bind_buffer(GL_TEXTURE_BUFFER, samples_buffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, sizeof(cycle), cycle);
+}
+
+GLuint wave_lod_columns_texture() {
+	return columns_texture;
+}
+
+// shaders/wave_reduce/cs does this with a workgroup per column
+void wave_lod_reduce_cpu(int count, double x0, double px, wave_lod_column_t *out) {
+	reduce_params_t p;
+	reduce_params(x0, px, &p);
+
+	for (int c = 0; c < count; ++c) {
+		float a = p.start + (float)c * p.step;
+		float b = p.start + (float)(c + 1) * p.step;
+		if (a < p.lo) a = p.lo;
+		if (b > p.hi) b = p.hi;
+
+		wave_lod_column_t *col = &out[c];
+		if (a >= b) {
+			col->min = 1;
+			col->max = -1;
+			col->rms = 0;
+			col->unused = 0;
+			continue;
+		}
+
+		// every sample the column touches, a whole cycle at most since they all look the same
+		int s0 = (int)floorf(a);
+		int n = (int)ceilf(b) - s0;
+		if (n < 1) n = 1;
+		if (n > WAVE_LOD_CYCLE_SAMPLES) n = WAVE_LOD_CYCLE_SAMPLES;
+
+		float lo = 1e30f, hi = -1e30f, sq = 0;
+		for (int i = 0; i < n; ++i) {
+			float v = cycle[(s0 + i) % WAVE_LOD_CYCLE_SAMPLES];
+			if (v < lo) lo = v;
+			if (v > hi) hi = v;
+			sq += v * v;
+		}
+		col->min = lo;
+		col->max = hi;
+		col->rms = sqrtf(sq / (float)n);
+		col->unused = 0;
+	}
+}
+
+void wave_lod_reduce(ShaderProgram *reduce, int first, int count, double x0, double px) {
+	if (first < 0 || count <= 0 || first + count > WAVE_LOD_COLUMNS) {
+		return;
+	}
+
+	if (!reduce) {
+		wave_lod_reduce_cpu(count, x0, px, cpu_columns);
+		gls_bind_buffer(GL_TEXTURE_BUFFER, columns_buffer);
+		glBufferSubData(GL_TEXTURE_BUFFER, first * sizeof(wave_lod_column_t), count * sizeof(wave_lod_column_t), cpu_columns);
+		return;
+	}
+
+	reduce_params_t p;
+	reduce_params(x0, px, &p);
+
+	gls_use_program(reduce->getProgramHandle());
+	reduce->update_uniform_1f("start", p.start);
+	reduce->update_uniform_1f("step", p.step);
+	reduce->update_uniform_2f("material", p.lo, p.hi);
+	reduce->update_uniform_1i("first_column", first);
+	reduce->update_uniform_1i("cycle_samples", WAVE_LOD_CYCLE_SAMPLES);
+	reduce->update_uniform_1i("samples", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, samples_texture);
+	glBindImageTexture(0, columns_texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+
+	glDispatchCompute(count, 1, 1);
+
+	// the lod draws read the columns with texelFetch
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+double wave_lod_check(ShaderProgram *reduce, int count, double x0, double px, double *gpu_ms, double *cpu_ms) {
+	if (!reduce) {
+		return -1;
+	}
+	if (count > WAVE_LOD_COLUMNS) count = WAVE_LOD_COLUMNS;
+
+	perf_timer_t T;
+	glFinish();
+	T.begin();
+	wave_lod_reduce(reduce, 0, count, x0, px);
+	glFinish();
+	*gpu_ms = T.get_ms();
+
+	std::vector<wave_lod_column_t> gpu(count), cpu(count);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	gls_bind_buffer(GL_TEXTURE_BUFFER, columns_buffer);
+	glGetBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof(wave_lod_column_t), gpu.data());
+
+	T.begin();
+	wave_lod_reduce_cpu(count, x0, px, cpu.data());
+	*cpu_ms = T.get_ms();
+
+	double worst = 0;
+	for (int c = 0; c < count; ++c) {
+		const wave_lod_column_t &g = gpu[c], &r = cpu[c];
+		if ((g.min > g.max) != (r.min > r.max)) {
+			return HUGE_VAL;
+		}
+		if (r.min > r.max) {
+			continue;
+		}
+		double d = fabs(g.min - r.min);
+		if (fabs(g.max - r.max) > d) d = fabs(g.max - r.max);
+		if (fabs(g.rms - r.rms) > d) d = fabs(g.rms - r.rms);
+		if (d > worst) worst = d;
+	}
+	return worst;
+}
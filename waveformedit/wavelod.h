@@ -0,0 +1,41 @@
+#pragma once
+
+#include "glext_loader.h"
+#include "shader.h"
+#include "tilecache.h"
+
+// the zoomed out waveform: per pixel column min, max and rms of the material, for the zoom levels where a
+// period is too narrow for the tessellated curve. one cycle of samples goes to the GPU after each edit and a
+// compute pass (shaders/wave_reduce) reduces it straight into a buffer texture that shaders/wave_lod draws
+// from, nothing comes back to the CPU. without compute shaders the CPU reference fills the same buffer.
+// GL thread only
+
+#define WAVE_LOD_CYCLE_SAMPLES 4096
+
+// the column buffer has a region of TILE_WIDTH columns for every tile slot
+#define WAVE_LOD_COLUMNS (TILE_CACHE_SLOTS * TILE_WIDTH)
+
+// a column with none of the material in it has min > max
+struct wave_lod_column_t {
+	float min, max, rms, unused;
+};
+
+void wave_lod_init();
+void wave_lod_destroy();
+
+// WAVE_LOD_CYCLE_SAMPLES samples of exactly one period, the material is that looped periods times
+void wave_lod_set_cycle(const float *samples, long long periods);
+
+// columns first..first+count-1 of the column buffer get the material from x0 on, px curve units per column.
+// with reduce NULL it's done on the CPU and uploaded
+void wave_lod_reduce(ShaderProgram *reduce, int first, int count, double x0, double px);
+
+// the samplerBuffer (GL_RGBA32F, a wave_lod_column_t per texel) shaders/wave_lod reads
+GLuint wave_lod_columns_texture();
+
+// the reference, the same numbers the compute pass gives
+void wave_lod_reduce_cpu(int count, double x0, double px, wave_lod_column_t *out);
+
+// reduces count columns on the GPU, reads them back and compares with the reference. returns the largest
+// difference, gpu_ms and cpu_ms get the time each took. -1 without a reduce program
+double wave_lod_check(ShaderProgram *reduce, int count, double x0, double px, double *gpu_ms, double *cpu_ms);
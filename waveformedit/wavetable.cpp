@@ -0,0 +1,125 @@
+#include "wavetable.h"
+
+#include <cmath>
+#include <cstring>
+
+#define TWO_PI (3.14159265358979*2)
+
+#define WT_PHASE_FRAC_BITS (32 - WT_TABLE_BITS)
+
+// in-place iterative radix-2 FFT. sign = -1 for forward, +1 for inverse (unnormalized)
+static void fft(float *re, float *im, int n, int sign) {
+
+	// bit reversal permutation
+	for (int i = 1, j = 0; i < n; ++i) {
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+
+		if (i < j) {
+			float t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	for (int len = 2; len <= n; len <<= 1) {
+		double alpha = sign * TWO_PI / (double)len;
+		float wr = (float)cos(alpha);
+		float wi = (float)sin(alpha);
+
+		for (int i = 0; i < n; i += len) {
+			float cr = 1.0, ci = 0.0;
+			for (int k = 0; k < len / 2; ++k) {
+				int a = i + k;
+				int b = a + len / 2;
+
+				float br = re[b] * cr - im[b] * ci;
+				float bi = re[b] * ci + im[b] * cr;
+
+				re[b] = re[a] - br;
+				im[b] = im[a] - bi;
+				re[a] += br;
+				im[a] += bi;
+
+				float tmp = cr * wr - ci * wi;
+				ci = cr * wi + ci * wr;
+				cr = tmp;
+			}
+		}
+	}
+}
+
+void wavetable_t::build(const float *cycle) {
+
+	static float spectrum_re[WT_TABLE_SIZE], spectrum_im[WT_TABLE_SIZE];
+	static float re[WT_TABLE_SIZE], im[WT_TABLE_SIZE];
+
+	memcpy(spectrum_re, cycle, sizeof(spectrum_re));
+	memset(spectrum_im, 0, sizeof(spectrum_im));
+
+	fft(spectrum_re, spectrum_im, WT_TABLE_SIZE, -1);
+
+	// the DC term isn't audible anyway, and leaving it in would just eat headroom
+	spectrum_re[0] = spectrum_im[0] = 0;
+
+	const float scale = 1.0 / (float)WT_TABLE_SIZE;
+
+	for (int level = 0; level < WT_NUM_LEVELS; ++level) {
+		int H = max_harmonics(level);
+
+		memset(re, 0, sizeof(re));
+		memset(im, 0, sizeof(im));
+
+		// keep harmonics 1..H and their mirror images, everything else is truncated
+		for (int h = 1; h <= H && h <= WT_TABLE_SIZE / 2; ++h) {
+			re[h] = spectrum_re[h];
+			im[h] = spectrum_im[h];
+			re[WT_TABLE_SIZE - h] = spectrum_re[WT_TABLE_SIZE - h];
+			im[WT_TABLE_SIZE - h] = spectrum_im[WT_TABLE_SIZE - h];
+		}
+
+		fft(re, im, WT_TABLE_SIZE, 1);
+
+		float *t = tables[level];
+		for (int i = 0; i < WT_TABLE_SIZE; ++i) {
+			t[i] = re[i] * scale;
+		}
+		t[WT_TABLE_SIZE] = t[0];
+	}
+}
+
+int wavetable_t::level_for_frequency(float freq_Hz, float sample_rate) {
+	// pick the richest level whose highest harmonic still stays below nyquist
+	float allowed = 0.5 * sample_rate / freq_Hz;
+	int level = 0;
+	while (level < WT_NUM_LEVELS - 1 && (float)max_harmonics(level) > allowed) {
+		++level;
+	}
+	return level;
+}
+
+void wt_oscillator_t::set_frequency(float freq_Hz, float sample_rate) {
+	phase_inc = (uint32_t)(freq_Hz / sample_rate * 4294967296.0);
+	level = wavetable_t::level_for_frequency(freq_Hz, sample_rate);
+}
+
+void wt_oscillator_t::render_add(const wavetable_t *wt, float *out, int n, float gain) {
+	static const float frac_scale = 1.0 / (float)(1u << WT_PHASE_FRAC_BITS);
+
+	const float *t = wt->tables[level];
+	uint32_t p = phase;
+
+	for (int i = 0; i < n; ++i) {
+		uint32_t idx = p >> WT_PHASE_FRAC_BITS;
+		float frac = (float)(p & ((1u << WT_PHASE_FRAC_BITS) - 1)) * frac_scale;
+		float a = t[idx];
+		float b = t[idx + 1];
+
+		out[i] += gain * (a + frac * (b - a));
+		p += phase_inc;
+	}
+
+	phase = p;
+}
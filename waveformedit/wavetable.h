@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// A single edited cycle, rendered once into a set of band-limited tables (one "mip level" per octave).
+// Level k contains at most (WT_TABLE_SIZE/2) >> k harmonics, so playback can always pick a level
+// that has nothing above nyquist for the requested frequency.
+
+#define WT_TABLE_BITS 11
+#define WT_TABLE_SIZE (1 << WT_TABLE_BITS)
+#define WT_NUM_LEVELS WT_TABLE_BITS
+
+struct wavetable_t {
+	// +1 guard sample (== tables[k][0]) so the interpolated read never has to wrap
+	float tables[WT_NUM_LEVELS][WT_TABLE_SIZE + 1];
+
+	// cycle should contain WT_TABLE_SIZE samples of exactly one period
+	void build(const float *cycle);
+
+	static int max_harmonics(int level) { return (WT_TABLE_SIZE / 2) >> level; }
+	static int level_for_frequency(float freq_Hz, float sample_rate);
+};
+
+struct wt_oscillator_t {
+	uint32_t phase;		// 32-bit fixed point phase, top WT_TABLE_BITS bits index the table
+	uint32_t phase_inc;
+	int level;
+
+	wt_oscillator_t() : phase(0), phase_inc(0), level(0) {}
+
+	void set_frequency(float freq_Hz, float sample_rate);
+
+	// adds gain*wave to out, n samples
+	void render_add(const wavetable_t *wt, float *out, int n, float gain);
+};
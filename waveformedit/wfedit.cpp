@@ -4,6 +4,7 @@
 #include "sound.h"
 #include "curve.h"
 #include "timer.h"
+#include "benchmarks.h"
 
 #include <cstdio>
 #include <iostream>
@@ -39,6 +40,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	}
 #endif
 
+#ifdef WFEDIT_BENCHMARKS
+	run_benchmarks();
+	MessageBox(NULL, "Benchmarks finished, see the debug console.", "wfedit", MB_OK);
+	return EXIT_SUCCESS;
+#endif
 
 	long wait = 0;
 	static double time_per_frame_ms = 0;
@@ -76,6 +82,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 
 	while (wfedit_running()) {
+		if (!window_wants_frame()) {
+			// nothing to redraw, sleep until a message arrives instead of spinning. the audio thread
+			// runs on its own event and doesn't care
+			MsgWaitForMultipleObjects(0, NULL, FALSE, INFINITE, QS_ALLINPUT);
+		}
+
 		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) > 0) {
 			if (msg.message == WM_QUIT) {
 				wfedit_stop();
@@ -87,8 +99,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 			}
 		}
 
-		draw();
-		swap_buffers();
+		if (wfedit_running() && window_wants_frame()) {
+			draw();
+			swap_buffers();
+		}
 	}
 
 